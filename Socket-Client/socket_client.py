@@ -1,9 +1,17 @@
 #!/usr/bin/env python
 
-import socket, time
+import os, socket, struct, time
 
 HOST = "localhost"  # The server's hostname or IP address
 PORT = 4007  # The port used by the server
+# Protocol version 1 only, must match the server: GST_REMOTE_FRAME_META=1 sends a timing block per frame
+FRAME_META = os.environ.get("GST_REMOTE_FRAME_META", "0") != "0"
+# 2 asks for the versioned header (common/frame-protocol.h), 1 sends no hello
+PROTOCOL = int(os.environ.get("GST_CLIENT_PROTOCOL", "2"))
+STAGES = ["arrival", "decoded", "encoded", "enqueued", "sent"]
+FORMATS = ["unknown", "jpg", "tensor", "bgr"]
+MAGIC = 0x46525347
+FLAG_META = 2
 
 print("**************************************")
 print("******* Socket Client Tester *********")
@@ -13,28 +21,75 @@ def socket_read(sock, expected):
     """Read expected number of bytes from sock
     Will repeatedly call recv until all expected data is received
     """
-    buffer = b''
-    while len(buffer) < expected:
-        print("recibido 1")
-        buffer += sock.recv(expected - len(buffer))
-    return buffer
+    buffer = bytearray(expected)
+    view = memoryview(buffer)
+    received = 0
+    while received < expected:
+        n = sock.recv_into(view[received:], expected - received)
+        if n == 0:
+            raise ConnectionError("server closed the connection")
+        received += n
+    return bytes(buffer)
 
 with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
     s.connect((HOST, PORT))
     print(f"Connected to port:", PORT)
+    version = 1
+    pending = None
+    if PROTOCOL >= 2:
+        #hello: magic, size, min version, max version, reserved, flags
+        s.sendall(struct.pack("<IHHHHI", MAGIC, 16, 1, 2, 0, 0))
+        #The answer is a hello too, unless the server predates them and starts with a frame
+        first = socket_read(s, 8)
+        if struct.unpack_from("<I", first)[0] == MAGIC:
+            hello = first + socket_read(s, 8)
+            hello_size, version = struct.unpack_from("<HH", hello, 4)
+            socket_read(s, hello_size - 16)
+            if version == 0:
+                raise ConnectionError("server supports neither protocol version 1 nor 2")
+        else:
+            pending = first
+    print(f"Protocol version:", version)
     while 1:
-        #First Receive the frame number
-        raw_frame = s.recv(4)
-        frame = int.from_bytes(raw_frame, byteorder="little")
-        #Second Receive the frame size
-        raw_size = s.recv(4)
-        size = int.from_bytes(raw_size, byteorder="little") 
+        ext = "jpg"
+        has_meta = FRAME_META
+        if version == 2:
+            #64 byte header: magic, version, size, sequence, pts, length, format, width, height, stride, flags, stream, crc
+            header = socket_read(s, 64)
+            (magic, _, header_size, frame, pts, size, fmt, width, height, stride, flags,
+             stream, crc) = struct.unpack_from("<IHHQQ8I", header)
+            if magic != MAGIC:
+                raise ConnectionError("frame header expected, stream out of sync")
+            socket_read(s, header_size - 64)
+            has_meta = flags & FLAG_META
+            ext = FORMATS[fmt] if fmt < len(FORMATS) else "bin"
+        else:
+            #First Receive the frame number, then the frame size
+            header = pending if pending is not None else socket_read(s, 8)
+            pending = None
+            frame, size = struct.unpack("<iI", header)
+        #Optional timing block: size, version, rtp ts, stream id, pts, stage times (ns)
+        if has_meta:
+            meta_size = int.from_bytes(socket_read(s, 2), byteorder="little")
+            meta = socket_read(s, meta_size - 2)
+            stream_id = struct.unpack_from("<I", meta, 6)[0]
+            stage_ns = struct.unpack_from("<5Q", meta, 22)
+            now_ns = time.time_ns()
+            spans = [f"{STAGES[i]} +{(stage_ns[i] - stage_ns[i - 1]) / 1e6:.1f}"
+                     for i in range(1, len(STAGES)) if stage_ns[i] and stage_ns[i - 1]]
+            if stage_ns[0]:
+                spans.append(f"received +{(now_ns - stage_ns[0]) / 1e6:.1f}")
+            print(f"Frame {frame} stream {stream_id} ms: " + " ".join(spans))
         #Third Receive the frame
-        raw_img = s.recv(size)
+        raw_img = socket_read(s, size)
         # Open a file, save img and close it
-        f = open (str(frame)+".jpg", "wb")
+        #GST_REMOTE_OUTPUT=tensor: 64 byte header, then float32 R, G, B planes
+        if raw_img[:4] == b"TSNR":
+            ext = "tensor"
+            w, h, c, dtype, src_w, src_h, scale, pad_x, pad_y = struct.unpack_from("<4I2If2I", raw_img, 8)
+            print(f"Tensor {c}x{h}x{w} from {src_w}x{src_h} scale {scale:.4f} pad {pad_x},{pad_y}")
+        f = open (str(frame)+"."+ext, "wb")
         f.write(raw_img)
         f.close()
-        if raw_frame != 0 :
-            print(f"Rcv Frame: {frame} - with lenght: {size}")
+        print(f"Rcv Frame: {frame} - with lenght: {size}")
         #time.sleep(0.1)
@@ -0,0 +1,724 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file    bench.cpp
+ * @brief   End-to-end benchmark of the local -> remote -> consumer chain
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Runs the sender pipeline of local.cpp, the receive pipeline of remote.cpp
+ * and a TCP consumer in one process over loopback, for every combination of
+ * resolution, frame rate and x264enc settings given in the environment:
+ *
+ *   GST_BENCH_RESOLUTIONS   640x480,1280x720,1920x1080
+ *   GST_BENCH_FRAMERATES    30
+ *   GST_BENCH_ENCODERS      x264enc properties per setting, ';' separated
+ *                           (default "tune=zerolatency speed-preset=ultrafast")
+ *   GST_BENCH_ENCODE_THREADS  jpegenc threads on the remote side (default 1)
+ *   GST_BENCH_WARMUP        seconds discarded before measuring (default 2)
+ *   GST_BENCH_DURATION      seconds measured per case (default 10)
+ *   GST_BENCH_JITTER_LATENCY  rtpjitterbuffer ms like gstreamer-remote (20, 0 = none)
+ *   GST_BENCH_PORT          RTP port, the frame server uses port + 1 (5600)
+ *   GST_BENCH_CSV           also append one row per case to this file
+ *
+ * Latency is measured from the moment a raw frame enters x264enc until the
+ * consumer has read the last byte of its JPEG. The frame is followed through
+ * the chain by its PTS on the sender, its RTP timestamp on the wire and its
+ * depayloader input PTS on the receiver, all against one steady clock.
+ *
+ * The pipelines are written out here, not built by local.cpp and remote.cpp,
+ * and leave out what needs a second peer or a real source: no rtpsession and
+ * RTCP on either side (so no adaptive bitrate and no keyframe requests), no
+ * sender profile (the case's x264enc properties instead), no decodebin and
+ * no videorate on the sender.
+ */
+////////////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <string>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/rtp/gstrtpbuffer.h>   //For the RTP timestamp
+#include <utils.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "frame-queue.h"
+#include "mapped-frame.h"
+#include "frame-server.h"
+#include "notifier.h"
+#include "encode-pool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+#define BENCH_RESOLUTIONS     "640x480,1280x720,1920x1080"
+#define BENCH_FRAMERATES      "30"
+#define BENCH_ENCODERS        "tune=zerolatency speed-preset=ultrafast"
+#define BENCH_WARMUP_S        2
+#define BENCH_DURATION_S      10
+#define BENCH_JITTER_LATENCY  20
+#define BENCH_PORT            5600
+#define BENCH_FRAME_QUEUE     8
+#define BENCH_CLIENT_QUEUE    4
+#define BENCH_TOP_THREADS     8     //Busiest threads listed per case
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  int width;
+  int height;
+  int fps;
+  std::string encoder;              //x264enc properties, gst-launch syntax
+} bench_case_t;
+
+typedef struct {
+  std::string name;
+  double cpu_percent;               //Of one core over the measured window
+} thread_cpu_t;
+
+typedef struct {
+  uint64_t frames;
+  double fps;
+  double latency_p50_ms;
+  double latency_p90_ms;
+  double latency_p99_ms;
+  double latency_max_ms;
+  double rtp_bytes_per_frame;
+  double jpeg_bytes_per_frame;
+  uint64_t queue_dropped;
+  uint64_t client_dropped;
+  double process_cpu_percent;
+  std::vector<thread_cpu_t> threads;
+} bench_result_t;
+
+typedef struct {
+  GstSample *sample;
+} frame_t;
+
+////////////////////////////////////////////////////////////////////////////////
+/* Everything one case shares between the GStreamer and bench threads */
+typedef struct {
+  std::mutex mtx;
+  std::map<uint64_t, int64_t> capture_by_pts;     //Sender PTS -> enters x264enc
+  std::map<uint32_t, int64_t> capture_by_rtp;     //RTP timestamp -> capture
+  std::map<uint64_t, int64_t> capture_by_arrival; //Receiver depayloader input PTS -> capture
+  std::map<int32_t, int64_t> capture_by_number;   //Frame server number -> capture
+  std::vector<int64_t> latencies_ns;
+
+  std::atomic<bool> measuring{false};
+  std::atomic<bool> running{true};
+  std::atomic<uint64_t> rtp_bytes{0};
+  std::atomic<uint64_t> jpeg_bytes{0};
+  std::atomic<uint64_t> frames{0};
+
+  remote::frame_queue<frame_t> *queue;
+  remote::event_notifier *ready;
+  remote::frame_server *server;
+  remote::encode_pool *encoder;
+} bench_state_t;
+
+////////////////////////////////////////////////////////////////////////////////
+static int64_t now_ns ()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Find key and forget everything older, every map is keyed in stream order */
+template <typename K>
+static bool take_capture (std::map<K, int64_t> &map, K key, int64_t &capture)
+{
+  auto it = map.find(key);
+  if (it == map.end()) {
+    return false;
+  }
+  capture = it->second;
+  map.erase(map.begin(), std::next(it));
+  return true;
+}
+
+static std::vector<std::string> split (const std::string &value, char separator)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(value);
+  std::string item;
+  while (std::getline(ss, item, separator)) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+static std::string get_env_string (const char *name, const char *default_value)
+{
+  auto value = std::getenv(name);
+  return value != nullptr ? value : default_value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* CPU ticks of every thread of this process, from /proc/self/task */
+static std::map<pid_t, std::pair<std::string, uint64_t>> thread_ticks ()
+{
+  std::map<pid_t, std::pair<std::string, uint64_t>> ticks;
+  DIR *dir = opendir("/proc/self/task");
+  if (dir == NULL) {
+    return ticks;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    std::string task = std::string("/proc/self/task/") + entry->d_name;
+    std::ifstream stat_file(task + "/stat");
+    std::string stat;
+    if (!std::getline(stat_file, stat)) {
+      continue;
+    }
+    //The name may contain spaces, the fields we want come after its ')'
+    std::istringstream fields(stat.substr(stat.rfind(')') + 2));
+    std::string field;
+    uint64_t utime = 0, stime = 0;
+    for (int i = 3; i <= 15 && fields >> field; i++) {
+      if (i == 14) utime = std::stoull(field);
+      if (i == 15) stime = std::stoull(field);
+    }
+    std::ifstream comm_file(task + "/comm");
+    std::string comm;
+    std::getline(comm_file, comm);
+    ticks[std::atoi(entry->d_name)] = {comm, utime + stime};
+  }
+  closedir(dir);
+  return ticks;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Sender: raw frame enters x264enc, this is time zero for the frame */
+static GstPadProbeReturn cb_capture (GstPad *, GstPadProbeInfo *info, gpointer user_data)
+{
+  auto state = static_cast<bench_state_t *>(user_data);
+  GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+  if (buffer != NULL && GST_BUFFER_PTS_IS_VALID(buffer)) {
+    std::lock_guard<std::mutex> lock(state->mtx);
+    state->capture_by_pts[GST_BUFFER_PTS(buffer)] = now_ns();
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean rtp_packet_sent (GstBuffer **buffer, guint, gpointer user_data)
+{
+  auto state = static_cast<bench_state_t *>(user_data);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  if (state->measuring) {
+    state->rtp_bytes.fetch_add(gst_buffer_get_size(*buffer), std::memory_order_relaxed);
+  }
+  if (!GST_BUFFER_PTS_IS_VALID(*buffer) || !gst_rtp_buffer_map(*buffer, GST_MAP_READ, &rtp)) {
+    return TRUE;
+  }
+  uint32_t rtp_ts = gst_rtp_buffer_get_timestamp(&rtp);
+  gst_rtp_buffer_unmap(&rtp);
+
+  //The payloader keeps the PTS of the access unit on every packet
+  std::lock_guard<std::mutex> lock(state->mtx);
+  int64_t capture;
+  if (state->capture_by_rtp.count(rtp_ts) == 0 &&
+      take_capture(state->capture_by_pts, static_cast<uint64_t>(GST_BUFFER_PTS(*buffer)), capture)) {
+    state->capture_by_rtp[rtp_ts] = capture;
+  }
+  return TRUE;
+}
+
+/* Sender: rtph264pay output, one packet or a list of them */
+static GstPadProbeReturn cb_rtp_sent (GstPad *, GstPadProbeInfo *info, gpointer user_data)
+{
+  if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    gst_buffer_list_foreach(gst_pad_probe_info_get_buffer_list(info), rtp_packet_sent, user_data);
+  }
+  else {
+    GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+    rtp_packet_sent(&buffer, 0, user_data);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/* Receiver: packets reaching rtph264depay, whose output keeps a packet PTS */
+static GstPadProbeReturn cb_rtp_received (GstPad *, GstPadProbeInfo *info, gpointer user_data)
+{
+  auto state = static_cast<bench_state_t *>(user_data);
+  GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+  if (buffer == NULL || !GST_BUFFER_PTS_IS_VALID(buffer) || !gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) {
+    return GST_PAD_PROBE_OK;
+  }
+  uint32_t rtp_ts = gst_rtp_buffer_get_timestamp(&rtp);
+  gst_rtp_buffer_unmap(&rtp);
+
+  std::lock_guard<std::mutex> lock(state->mtx);
+  auto it = state->capture_by_rtp.find(rtp_ts);
+  if (it != state->capture_by_rtp.end()) {
+    state->capture_by_arrival[GST_BUFFER_PTS(buffer)] = it->second;
+    //Older access units are complete or lost by now
+    state->capture_by_rtp.erase(state->capture_by_rtp.begin(), it);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static void queue_frame (bench_state_t *state, GstSample *sample)
+{
+  frame_t *slot = state->queue->producer_slot();
+  if (slot != NULL) {
+    slot->sample = sample;
+    state->queue->push_commit();
+    state->ready->notify();
+  }
+  else {
+    gst_sample_unref(sample);
+  }
+}
+
+/* Same loop as remote.cpp's appsink thread */
+static void appsink_loop (bench_state_t *state, GstAppSink *sink)
+{
+  pthread_setname_np(pthread_self(), "bench-appsink");
+  GstSample *sample;
+  while ((sample = gst_app_sink_pull_sample(sink)) != NULL) {
+    if (state->encoder != NULL) {
+      state->encoder->submit(sample);
+    }
+    else {
+      queue_frame(state, sample);
+    }
+  }
+}
+
+/* Same loop as remote.cpp's socket thread, plus the latency bookkeeping */
+static void socket_loop (bench_state_t *state)
+{
+  pthread_setname_np(pthread_self(), "bench-socket");
+  int32_t number = 0;
+  while (state->running) {
+    state->server->poll(100);
+
+    frame_t *frame;
+    while ((frame = state->queue->front()) != NULL) {
+      auto mapped = std::make_shared<remote::mapped_frame>(frame->sample);
+      frame->sample = NULL;
+      state->queue->pop_release();
+      if (!mapped->valid()) {
+        continue;
+      }
+      GstClockTime pts = GST_BUFFER_PTS(mapped->buffer());
+      if (GST_CLOCK_TIME_IS_VALID(pts)) {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        int64_t capture;
+        if (take_capture(state->capture_by_arrival, static_cast<uint64_t>(pts), capture)) {
+          state->capture_by_number[number] = capture;
+        }
+      }
+      state->server->broadcast(mapped, number++);
+    }
+  }
+}
+
+static bool read_exact (int fd, void *data, size_t len)
+{
+  auto p = static_cast<uint8_t *>(data);
+  while (len > 0) {
+    ssize_t n = recv(fd, p, len, 0);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+/* The consumer: reads frames like the Python socket client does */
+static void consumer_loop (bench_state_t *state, int fd)
+{
+  pthread_setname_np(pthread_self(), "bench-consumer");
+  std::vector<uint8_t> payload;
+  remote::frame_header_t header;
+
+  while (read_exact(fd, &header, sizeof(header))) {
+    payload.resize(header.length);
+    if (!read_exact(fd, payload.data(), header.length)) {
+      break;
+    }
+    int64_t done = now_ns();
+    if (!state->measuring) {
+      continue;
+    }
+    state->frames.fetch_add(1, std::memory_order_relaxed);
+    state->jpeg_bytes.fetch_add(header.length, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(state->mtx);
+    int64_t capture;
+    if (take_capture(state->capture_by_number, header.number, capture)) {
+      state->latencies_ns.push_back(done - capture);
+    }
+  }
+}
+
+static int connect_consumer (uint16_t port)
+{
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    perror("connect");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Fail on the first error posted by either pipeline, otherwise wait timeout */
+static bool check_buses (GstElement *sender, GstElement *receiver, GstClockTime timeout)
+{
+  GstElement *pipelines[] = {sender, receiver};
+  int64_t deadline = now_ns() + timeout;
+  do {
+    for (GstElement *pipeline : pipelines) {
+      GstBus *bus = gst_element_get_bus(pipeline);
+      GstMessage *msg = gst_bus_timed_pop_filtered(bus, 50 * GST_MSECOND,
+          static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+      gst_object_unref(bus);
+      if (msg == NULL) {
+        continue;
+      }
+      if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError *err;
+        gchar *debug_info;
+        gst_message_parse_error(msg, &err, &debug_info);
+        g_printerr("Error received from element %s: %s\n", GST_OBJECT_NAME(msg->src), err->message);
+        g_printerr("Debugging information: %s\n", debug_info ? debug_info : "none");
+        g_clear_error(&err);
+        g_free(debug_info);
+      }
+      else {
+        g_printerr("Unexpected End-Of-Stream.\n");
+      }
+      gst_message_unref(msg);
+      return false;
+    }
+  } while (now_ns() < deadline);
+  return true;
+}
+
+static GstElement *launch (const std::string &description)
+{
+  GError *err = NULL;
+  GstElement *pipeline = gst_parse_launch(description.c_str(), &err);
+  if (err != NULL) {
+    g_printerr("Could not build '%s': %s\n", description.c_str(), err->message);
+    g_clear_error(&err);
+    if (pipeline != NULL) {
+      gst_object_unref(pipeline);
+    }
+    return NULL;
+  }
+  return pipeline;
+}
+
+static void add_probe (GstElement *pipeline, const char *element, const char *pad_name,
+                       GstPadProbeType type, GstPadProbeCallback callback, bench_state_t *state)
+{
+  GstElement *e = gst_bin_get_by_name(GST_BIN(pipeline), element);
+  GstPad *pad = gst_element_get_static_pad(e, pad_name);
+  gst_pad_add_probe(pad, type, callback, state, NULL);
+  gst_object_unref(pad);
+  gst_object_unref(e);
+}
+
+static double percentile_ms (const std::vector<int64_t> &sorted, double p)
+{
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+  return sorted[index] / 1e6;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static bool run_case (const bench_case_t &c, uint16_t port, size_t encode_threads, unsigned jitter_latency,
+                      unsigned warmup_s, unsigned duration_s, bench_result_t &r)
+{
+  bench_state_t state;
+  uint16_t server_port = port + 1;
+
+  //Same elements as local.cpp, minus decodebin which has nothing to decode
+  //from videotestsrc, and with the case's caps and encoder settings
+  std::ostringstream sender_desc;
+  sender_desc << "videotestsrc is-live=true pattern=1 ! video/x-raw,width=" << c.width
+              << ",height=" << c.height << ",framerate=" << c.fps << "/1"
+              << " ! x264enc name=bench_x264 " << c.encoder
+              << " ! rtph264pay name=bench_pay config-interval=-1"
+              << " ! udpsink host=127.0.0.1 port=" << port << " sync=false";
+
+  //Same elements as remote.cpp without RTCP, see the file comment
+  std::ostringstream receiver_desc;
+  receiver_desc << "udpsrc port=" << port
+                << " caps=\"application/x-rtp,encoding-name=H264,payload=96,clock-rate=90000\"";
+  if (jitter_latency > 0) {
+    receiver_desc << " ! rtpjitterbuffer latency=" << jitter_latency << " drop-on-latency=true do-lost=true";
+  }
+  receiver_desc << " ! rtph264depay name=bench_depay ! avdec_h264 ! autovideoconvert"
+                << (encode_threads > 1 ? "" : " ! jpegenc")
+                << " ! appsink name=bench_sink emit-signals=false sync=false";
+
+  GstElement *sender = launch(sender_desc.str());
+  GstElement *receiver = launch(receiver_desc.str());
+  if (sender == NULL || receiver == NULL) {
+    //Neither was started, the one that was created only needs its reference dropped
+    for (GstElement *pipeline : {sender, receiver}) {
+      if (pipeline != NULL) {
+        gst_object_unref(pipeline);
+      }
+    }
+    return false;
+  }
+
+  state.queue = new remote::frame_queue<frame_t>(BENCH_FRAME_QUEUE);
+  state.ready = new remote::event_notifier();
+  state.server = new remote::frame_server(server_port, BENCH_CLIENT_QUEUE,
+      remote::slow_client_policy::drop_oldest);
+  state.encoder = NULL;
+  if (encode_threads > 1) {
+    state.encoder = new remote::encode_pool(encode_threads, 2 * encode_threads,
+        [&state](GstSample *sample, uint32_t) { queue_frame(&state, sample); });
+  }
+
+  bool ok = state.ready->valid() && state.server->start() && state.server->add_wakeup_fd(state.ready->fd()) &&
+            (state.encoder == NULL || state.encoder->start());
+  int consumer_fd = ok ? connect_consumer(server_port) : -1;
+  ok = ok && consumer_fd >= 0;
+
+  std::thread socket_thread, appsink_thread, consumer_thread;
+  if (ok) {
+    add_probe(sender, "bench_x264", "sink", GST_PAD_PROBE_TYPE_BUFFER, cb_capture, &state);
+    add_probe(sender, "bench_pay", "src",
+        static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST), cb_rtp_sent, &state);
+    add_probe(receiver, "bench_depay", "sink", GST_PAD_PROBE_TYPE_BUFFER, cb_rtp_received, &state);
+
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(receiver), "bench_sink");
+    socket_thread = std::thread(socket_loop, &state);
+    appsink_thread = std::thread(appsink_loop, &state, GST_APP_SINK_CAST(sink));
+    consumer_thread = std::thread(consumer_loop, &state, consumer_fd);
+    gst_object_unref(sink);
+
+    //Receiver first so the first key frame is not lost
+    ok = gst_element_set_state(receiver, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE &&
+         gst_element_set_state(sender, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE;
+  }
+
+  int64_t start = 0, end = 0;
+  std::map<pid_t, std::pair<std::string, uint64_t>> ticks_start, ticks_end;
+  if (ok && check_buses(sender, receiver, warmup_s * GST_SECOND)) {
+    ticks_start = thread_ticks();
+    start = now_ns();
+    state.measuring = true;
+    ok = check_buses(sender, receiver, duration_s * GST_SECOND);
+    state.measuring = false;
+    end = now_ns();
+    ticks_end = thread_ticks();
+  }
+  else {
+    ok = false;
+  }
+
+  /* Tear down in pipeline order, NULL state unblocks the appsink pull */
+  gst_element_set_state(sender, GST_STATE_NULL);
+  gst_element_set_state(receiver, GST_STATE_NULL);
+  if (appsink_thread.joinable()) {
+    appsink_thread.join();
+  }
+  delete state.encoder;
+  state.encoder = NULL;
+  state.running = false;
+  if (socket_thread.joinable()) {
+    socket_thread.join();
+  }
+  if (consumer_fd >= 0) {
+    shutdown(consumer_fd, SHUT_RDWR);
+  }
+  if (consumer_thread.joinable()) {
+    consumer_thread.join();
+  }
+  if (consumer_fd >= 0) {
+    close(consumer_fd);
+  }
+
+  r.queue_dropped = state.queue->dropped();
+  r.client_dropped = state.server->frames_dropped();
+  frame_t *frame;
+  while ((frame = state.queue->front()) != NULL) {
+    gst_sample_unref(frame->sample);
+    state.queue->pop_release();
+  }
+  delete state.server;
+  delete state.ready;
+  delete state.queue;
+  gst_object_unref(sender);
+  gst_object_unref(receiver);
+
+  if (!ok) {
+    return false;
+  }
+
+  /* Results of the measured window */
+  double seconds = (end - start) / 1e9;
+  r.frames = state.frames;
+  r.fps = r.frames / seconds;
+  std::sort(state.latencies_ns.begin(), state.latencies_ns.end());
+  r.latency_p50_ms = percentile_ms(state.latencies_ns, 0.50);
+  r.latency_p90_ms = percentile_ms(state.latencies_ns, 0.90);
+  r.latency_p99_ms = percentile_ms(state.latencies_ns, 0.99);
+  r.latency_max_ms = state.latencies_ns.empty() ? 0.0 : state.latencies_ns.back() / 1e6;
+  r.rtp_bytes_per_frame = r.frames ? static_cast<double>(state.rtp_bytes) / r.frames : 0.0;
+  r.jpeg_bytes_per_frame = r.frames ? static_cast<double>(state.jpeg_bytes) / r.frames : 0.0;
+
+  //Threads are summed by name, GStreamer names its streaming threads after the pad
+  std::map<std::string, uint64_t> by_name;
+  uint64_t total = 0;
+  for (auto &t : ticks_end) {
+    auto before = ticks_start.find(t.first);
+    uint64_t used = t.second.second - (before != ticks_start.end() ? before->second.second : 0);
+    by_name[t.second.first] += used;
+    total += used;
+  }
+  double tick_s = 1.0 / sysconf(_SC_CLK_TCK);
+  r.process_cpu_percent = 100.0 * total * tick_s / seconds;
+  r.threads.clear();
+  for (auto &t : by_name) {
+    r.threads.push_back({t.first, 100.0 * t.second * tick_s / seconds});
+  }
+  std::sort(r.threads.begin(), r.threads.end(),
+      [](const thread_cpu_t &a, const thread_cpu_t &b) { return a.cpu_percent > b.cpu_percent; });
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static std::string case_name (const bench_case_t &c)
+{
+  std::ostringstream name;
+  name << c.width << "x" << c.height << "@" << c.fps << " [" << c.encoder << "]";
+  return name.str();
+}
+
+static void print_result (const bench_case_t &c, const bench_result_t &r)
+{
+  std::cout << std::fixed << std::setprecision(1)
+            << "[Bench] " << case_name(c) << std::endl
+            << "  fps: " << r.fps << " (" << r.frames << " frames)"
+            << " | latency ms p50: " << r.latency_p50_ms << " p90: " << r.latency_p90_ms
+            << " p99: " << r.latency_p99_ms << " max: " << r.latency_max_ms << std::endl
+            << "  bytes/frame rtp: " << std::setprecision(0) << r.rtp_bytes_per_frame
+            << " jpeg: " << r.jpeg_bytes_per_frame
+            << " | dropped queue: " << r.queue_dropped << " client: " << r.client_dropped << std::endl
+            << std::setprecision(1) << "  cpu: " << r.process_cpu_percent << "% total";
+  for (size_t i = 0; i < r.threads.size() && i < BENCH_TOP_THREADS; i++) {
+    std::cout << (i % 4 == 0 ? "\n    " : " | ") << r.threads[i].name << " " << r.threads[i].cpu_percent << "%";
+  }
+  std::cout << std::endl;
+}
+
+static void write_csv (const std::string &path, const bench_case_t &c, const bench_result_t &r)
+{
+  bool header = std::ifstream(path).peek() == std::ifstream::traits_type::eof();
+  std::ofstream csv(path, std::ios::app);
+  if (header) {
+    csv << "width,height,fps_target,encoder,fps,frames,p50_ms,p90_ms,p99_ms,max_ms,"
+           "rtp_bytes_per_frame,jpeg_bytes_per_frame,queue_dropped,client_dropped,cpu_percent\n";
+  }
+  csv << c.width << "," << c.height << "," << c.fps << ",\"" << c.encoder << "\","
+      << r.fps << "," << r.frames << "," << r.latency_p50_ms << "," << r.latency_p90_ms << ","
+      << r.latency_p99_ms << "," << r.latency_max_ms << "," << r.rtp_bytes_per_frame << ","
+      << r.jpeg_bytes_per_frame << "," << r.queue_dropped << "," << r.client_dropped << ","
+      << r.process_cpu_percent << "\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char *argv[])
+{
+  std::vector<bench_case_t> cases;
+  for (auto &resolution : split(get_env_string("GST_BENCH_RESOLUTIONS", BENCH_RESOLUTIONS), ',')) {
+    int width = 0, height = 0;
+    if (sscanf(resolution.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+      std::cout << "Not valid resolution " << resolution << ". Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    for (auto &framerate : split(get_env_string("GST_BENCH_FRAMERATES", BENCH_FRAMERATES), ',')) {
+      int fps = std::atoi(framerate.c_str());
+      if (fps <= 0) {
+        std::cout << "Not valid frame rate " << framerate << ". Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      for (auto &encoder : split(get_env_string("GST_BENCH_ENCODERS", BENCH_ENCODERS), ';')) {
+        cases.push_back({width, height, fps, encoder});
+      }
+    }
+  }
+
+  auto port = utils::get_env_ulong("GST_BENCH_PORT", BENCH_PORT);
+  if (port == 0 || port >= utils::port_range_max) {
+    std::cout << "Not valid GST_BENCH_PORT. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  auto encode_threads = utils::get_env_ulong("GST_BENCH_ENCODE_THREADS", 1);
+  auto jitter_latency = utils::get_env_ulong("GST_BENCH_JITTER_LATENCY", BENCH_JITTER_LATENCY);
+  auto warmup_s = utils::get_env_ulong("GST_BENCH_WARMUP", BENCH_WARMUP_S);
+  auto duration_s = utils::get_env_ulong("GST_BENCH_DURATION", BENCH_DURATION_S);
+  auto csv_path = get_env_string("GST_BENCH_CSV", "");
+  if (duration_s == 0) {
+    duration_s = 1;
+  }
+
+  gst_init (&argc, &argv);
+
+  std::cout << "Benchmark: " << cases.size() << " cases, " << warmup_s << " s warm-up + "
+            << duration_s << " s each, jpegenc threads: " << encode_threads << std::endl;
+  std::cout << "Benchmark: jitter buffer " << jitter_latency << " ms; no RTCP, sender profile, decodebin"
+            << " or videorate, unlike gstreamer-local and gstreamer-remote" << std::endl;
+
+  int failed = 0;
+  for (auto &c : cases) {
+    bench_result_t result;
+    std::cout << "[Bench] running " << case_name(c) << std::endl;
+    if (!run_case(c, port, encode_threads, jitter_latency, warmup_s, duration_s, result)) {
+      std::cout << "[Bench] " << case_name(c) << " failed" << std::endl;
+      failed++;
+      continue;
+    }
+    print_result(c, result);
+    if (!csv_path.empty()) {
+      write_csv(csv_path, c, result);
+    }
+  }
+  return failed == 0 ? 0 : 1;
+}
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,387 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file    client-bench.cpp
+ * @brief   Throughput of the frame client over loopback, or against a live remote
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Without arguments a sender thread serves frames of every size in
+ * GST_CLIENT_BENCH_SIZES as fast as loopback takes them, in the wire format
+ * of common/frame-protocol.h, and two readers are timed against it:
+ *
+ * - pool:  client::frame_client, payloads read into reused buffers, version 2
+ *          unless GST_CLIENT_BENCH_PROTOCOL=1
+ * - alloc: the same exact reads, but a new zeroed vector per frame, as a
+ *          consumer that doesn't keep its buffers does, version 1
+ *
+ * With a host and port it only measures frame_client against that server.
+ * Reader CPU is the receive thread's own, in % of one core.
+ */
+////////////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <utils.h>
+#include <crc32c.h>
+#include "frame-client.h"
+
+////////////////////////////////////////////////////////////////////////////////
+#define BENCH_SIZES           "16384,262144,1048576,6220800" //Default, override with GST_CLIENT_BENCH_SIZES
+#define BENCH_DURATION        3         //Default, override with GST_CLIENT_BENCH_DURATION (seconds)
+#define BENCH_WARMUP_MS       500
+#define HELLO_WAIT_MS         100       //Like gstreamer-remote, silent readers get version 1
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  uint64_t frames;
+  uint64_t bytes;
+  double seconds;
+  double cpu;                       //Receive thread, % of one core
+} result_t;
+
+static double seconds_since (std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static uint64_t thread_cpu_ns (std::thread &t)
+{
+  clockid_t clock;
+  struct timespec ts;
+  if (pthread_getcpuclockid(t.native_handle(), &clock) != 0 || clock_gettime(clock, &ts) != 0) {
+    return 0;
+  }
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Sample the reader's counters over the measuring window, after a warm-up */
+template <typename counters_fn>
+static result_t measure (std::thread &reader, unsigned long seconds, counters_fn counters)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(BENCH_WARMUP_MS));
+  uint64_t frames0, bytes0;
+  counters(frames0, bytes0);
+  uint64_t cpu0 = thread_cpu_ns(reader);
+  auto start = std::chrono::steady_clock::now();
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+  result_t r;
+  counters(r.frames, r.bytes);
+  r.seconds = seconds_since(start);
+  r.frames -= frames0;
+  r.bytes -= bytes0;
+  r.cpu = (thread_cpu_ns(reader) - cpu0) / 1e7 / r.seconds;
+  return r;
+}
+
+static void print_result (const std::string &label, const std::string &reader, const result_t &r)
+{
+  std::cout << std::left << std::setw(12) << label << std::setw(7) << reader << std::right << std::fixed
+            << std::setprecision(0) << std::setw(10) << r.frames / r.seconds
+            << std::setprecision(1) << std::setw(10) << r.bytes / r.seconds / 1e6
+            << std::setprecision(2) << std::setw(9) << r.bytes * 8 / r.seconds / 1e9
+            << std::setprecision(0) << std::setw(7) << r.cpu << "%" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Version 2 if the reader says hello in time, with CRCs if it asks for them */
+static uint16_t answer_hello (int fd, bool &crc)
+{
+  struct pollfd pfd = {fd, POLLIN, 0};
+  frame_protocol::hello_t hello;
+  if (poll(&pfd, 1, HELLO_WAIT_MS) <= 0 || recv(fd, &hello, sizeof(hello), MSG_WAITALL) != sizeof(hello) ||
+      hello.magic != frame_protocol::magic || hello.max_version < frame_protocol::version_2) {
+    return frame_protocol::version_1;
+  }
+  frame_protocol::hello_t reply = {};
+  reply.magic = frame_protocol::magic;
+  reply.size = sizeof(reply);
+  reply.min_version = frame_protocol::version_2;
+  reply.max_version = frame_protocol::version_2;
+  reply.flags = hello.flags & frame_protocol::hello_crc;
+  crc = reply.flags != 0;
+  send(fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+  return frame_protocol::version_2;
+}
+
+/* Loopback server: one client, the same payload over and over */
+static void sender_loop (int listen_fd, uint32_t size, bool meta, std::atomic<bool> *stop)
+{
+  int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+  if (fd < 0) {
+    perror("accept");
+    return;
+  }
+  bool crc = false;
+  uint16_t version = answer_hello(fd, crc);
+  std::vector<uint8_t> payload(size, 0xA5);
+  frame_protocol::header_t header = {0, size};
+  frame_protocol::header_v2_t header_v2 = {};
+  header_v2.magic = frame_protocol::magic;
+  header_v2.version = frame_protocol::version_2;
+  header_v2.size = sizeof(header_v2);
+  header_v2.pts = frame_protocol::unknown_pts;
+  header_v2.length = size;
+  header_v2.format = frame_protocol::format_jpeg;
+  header_v2.flags = frame_protocol::flag_keyframe;
+  if (meta) {
+    header_v2.flags |= frame_protocol::flag_meta;
+  }
+  if (crc) {
+    //The payload never changes, the reader's check is what is measured
+    header_v2.crc = crc32c::compute(payload.data(), payload.size());
+    header_v2.flags |= frame_protocol::flag_crc;
+  }
+  frame_protocol::meta_t block = {};
+  block.size = sizeof(block);
+  block.version = frame_protocol::meta_version;
+  block.pts = frame_protocol::unknown_pts;
+
+  struct iovec iov[3];
+  while (!stop->load(std::memory_order_relaxed)) {
+    if (version == frame_protocol::version_2) {
+      iov[0] = {&header_v2, sizeof(header_v2)};
+    }
+    else {
+      iov[0] = {&header, sizeof(header)};
+    }
+    iov[1] = {&block, meta ? sizeof(block) : 0};
+    iov[2] = {payload.data(), payload.size()};
+    size_t first = 0;
+    while (first < 3) {
+      //The reader hangs up on us at the end, no SIGPIPE for that
+      struct msghdr msg = {};
+      msg.msg_iov = iov + first;
+      msg.msg_iovlen = 3 - first;
+      ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        close(fd);
+        return;
+      }
+      while (first < 3 && static_cast<size_t>(n) >= iov[first].iov_len) {
+        n -= iov[first].iov_len;
+        first++;
+      }
+      if (first < 3) {
+        iov[first].iov_base = static_cast<uint8_t *>(iov[first].iov_base) + n;
+        iov[first].iov_len -= n;
+      }
+    }
+    header.number++;
+    header_v2.sequence++;
+  }
+  close(fd);
+}
+
+static int listen_loopback (uint16_t &port)
+{
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  socklen_t len = sizeof(addr);
+  if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(fd, 1) < 0 ||
+      getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len) < 0) {
+    perror("listen");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  port = ntohs(addr.sin_port);
+  return fd;
+}
+
+/* Reads like frame_client, but with a fresh buffer for every payload */
+static bool read_exact (int fd, void *data, size_t len)
+{
+  auto p = static_cast<uint8_t *>(data);
+  while (len > 0) {
+    ssize_t n = recv(fd, p, len, MSG_WAITALL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+static void alloc_reader (int fd, bool meta, std::atomic<uint64_t> *frames, std::atomic<uint64_t> *bytes)
+{
+  frame_protocol::header_t header;
+  frame_protocol::meta_t block;
+  while (read_exact(fd, &header, sizeof(header)) && (!meta || read_exact(fd, &block, sizeof(block)))) {
+    std::vector<uint8_t> payload(header.length);
+    if (!read_exact(fd, payload.data(), payload.size())) {
+      break;
+    }
+    frames->fetch_add(1, std::memory_order_relaxed);
+    bytes->fetch_add(header.length, std::memory_order_relaxed);
+  }
+}
+
+static int connect_loopback (uint16_t port, int recv_buffer)
+{
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && recv_buffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &recv_buffer, sizeof(recv_buffer));
+  }
+  if (fd < 0 || connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    perror("connect");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+static bool run_loopback (uint32_t size, bool pooled, const client::options_t &options, unsigned long seconds)
+{
+  uint16_t port = 0;
+  int listen_fd = listen_loopback(port);
+  if (listen_fd < 0) {
+    return false;
+  }
+  std::atomic<bool> stop{false};
+  std::thread sender(sender_loop, listen_fd, size, options.frame_meta, &stop);
+
+  client::frame_client frames(options);
+  std::atomic<uint64_t> alloc_frames{0}, alloc_bytes{0};
+  int alloc_fd = -1;
+  std::thread reader;
+  result_t r = {};
+  bool ok;
+  if (pooled) {
+    ok = frames.connect("127.0.0.1", port);
+    if (ok) {
+      reader = std::thread([&frames]() { frames.run([](const client::frame_ptr &) {}); });
+      r = measure(reader, seconds, [&frames](uint64_t &f, uint64_t &b) { f = frames.frames(); b = frames.bytes(); });
+    }
+    else {
+      std::cout << "[Bench] " << frames.error() << std::endl;
+    }
+  }
+  else {
+    alloc_fd = connect_loopback(port, options.recv_buffer);
+    ok = alloc_fd >= 0;
+    if (ok) {
+      reader = std::thread(alloc_reader, alloc_fd, options.frame_meta, &alloc_frames, &alloc_bytes);
+      r = measure(reader, seconds, [&alloc_frames, &alloc_bytes](uint64_t &f, uint64_t &b) {
+        f = alloc_frames.load(std::memory_order_relaxed);
+        b = alloc_bytes.load(std::memory_order_relaxed);
+      });
+    }
+  }
+
+  //Both ends may be blocked in the kernel, shut the connection down under them
+  stop = true;
+  frames.stop();
+  if (alloc_fd >= 0) {
+    shutdown(alloc_fd, SHUT_RDWR);
+  }
+  if (!ok) {
+    shutdown(listen_fd, SHUT_RDWR);
+  }
+  if (reader.joinable()) {
+    reader.join();
+  }
+  frames.close();
+  if (alloc_fd >= 0) {
+    close(alloc_fd);
+  }
+  sender.join();
+  close(listen_fd);
+  if (ok) {
+    print_result(std::to_string(size), pooled ? "pool" : "alloc", r);
+  }
+  return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char *argv[])
+{
+  client::options_t options = client::default_options;
+  options.frame_meta = utils::get_env_ulong("GST_CLIENT_BENCH_META", 0) != 0;
+  unsigned long max_version = utils::get_env_ulong("GST_CLIENT_BENCH_PROTOCOL", frame_protocol::version_2);
+  if (max_version < frame_protocol::version_1 || max_version > frame_protocol::version_2) {
+    std::cout << "Not valid GST_CLIENT_BENCH_PROTOCOL (1, 2). Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  options.max_version = static_cast<uint16_t>(max_version);
+  options.crc = utils::get_env_ulong("GST_CLIENT_BENCH_CRC", 0) != 0;
+  unsigned long seconds = utils::get_env_ulong("GST_CLIENT_BENCH_DURATION", BENCH_DURATION);
+
+  std::cout << std::left << std::setw(12) << "size" << std::setw(7) << "reader" << std::right
+            << std::setw(10) << "fps" << std::setw(10) << "MB/s" << std::setw(9) << "Gbit/s"
+            << std::setw(8) << "cpu" << std::endl;
+
+  if (argc > 2) {
+    unsigned long port = std::strtoul(argv[2], NULL, 10);
+    if (port == 0 || port > utils::port_range_max) {
+      std::cout << "Not valid port. Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    client::frame_client frames(options);
+    if (!frames.connect(argv[1], port)) {
+      std::cout << "[Bench] " << frames.error() << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    std::thread reader([&frames]() { frames.run([](const client::frame_ptr &) {}); });
+    result_t r = measure(reader, seconds, [&frames](uint64_t &f, uint64_t &b) { f = frames.frames(); b = frames.bytes(); });
+    frames.stop();
+    reader.join();
+    print_result(std::string(argv[1]) + ":" + argv[2], "pool", r);
+    return 0;
+  }
+
+  std::string sizes_str{BENCH_SIZES};
+  auto env_sizes = std::getenv("GST_CLIENT_BENCH_SIZES");
+  if (env_sizes != nullptr) {
+    sizes_str = env_sizes;
+  }
+  std::stringstream sizes(sizes_str);
+  std::string item;
+  while (std::getline(sizes, item, ',')) {
+    unsigned long size = std::strtoul(item.c_str(), NULL, 10);
+    if (size == 0 || size > options.max_frame) {
+      std::cout << "Not valid size " << item << ". Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    for (bool pooled : {true, false}) {
+      if (!run_loopback(size, pooled, options, seconds)) {
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+  return 0;
+}
+////////////////////////////////////////////////////////////////////////////////
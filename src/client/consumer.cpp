@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file    consumer.cpp
+ * @brief   Sample high rate consumer of gstreamer-remote built on frame-client
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * The receive thread reads frames into pooled buffers and hands each one to
+ * a worker thread, the way an inference service would. The worker always
+ * takes the newest frame; frames it had no time for are released unread and
+ * their buffers go straight back to the pool, so a slow worker costs frames,
+ * never latency or memory. Once a second a [Consumer] line reports what came
+ * in and what the worker got to.
+ */
+////////////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <utils.h>
+#include "frame-client.h"
+
+////////////////////////////////////////////////////////////////////////////////
+#define CONSUMER_HOST         "127.0.0.1" //Default, override with argv[1]
+#define CONSUMER_PORT         4007        //Default, override with argv[2]
+#define CONSUMER_BUFFERS      4           //Default, override with GST_CONSUMER_BUFFERS
+#define RECONNECT_MS          1000        //Default, override with GST_CONSUMER_RECONNECT (0 = exit)
+#define STATS_INTERVAL_MS     1000
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  std::mutex mtx;
+  std::condition_variable cv;
+  client::frame_ptr latest;         //Newest frame not yet taken by the worker
+  uint64_t replaced = 0;            //Frames overwritten before the worker took them
+  uint64_t processed = 0;
+  uint64_t latency_ns = 0;          //Sum of server send -> processed, with the meta block
+  uint64_t latency_frames = 0;
+  bool done = false;
+} handoff_t;
+
+static uint64_t realtime_ns ()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/* Stands in for the real work: checks the frame and optionally saves it */
+static void worker_loop (handoff_t *h, unsigned long save_every)
+{
+  while (true) {
+    client::frame_ptr frame;
+    {
+      std::unique_lock<std::mutex> lock(h->mtx);
+      h->cv.wait(lock, [h]() { return h->latest != nullptr || h->done; });
+      if (h->latest == nullptr) {
+        return;
+      }
+      frame = std::move(h->latest);
+    }
+
+    //Version 2 names the format, with version 1 a JPEG is told by its FF D8
+    uint32_t format = frame->header.format;
+    if (format == frame_protocol::format_unknown && frame->length >= 2 && frame->data[0] == 0xFF && frame->data[1] == 0xD8) {
+      format = frame_protocol::format_jpeg;
+    }
+    if (save_every > 0 && frame->header.sequence % save_every == 0) {
+      std::string ext = format == frame_protocol::format_jpeg ? ".jpg" : ".bin";
+      std::ofstream out(std::to_string(frame->header.sequence) + ext, std::ios::binary);
+      out.write(reinterpret_cast<const char *>(frame->data), frame->length);
+    }
+
+    uint64_t sent_ns = frame->has_meta ? frame->meta.stage_ns[frame_protocol::stage_sent] : 0;
+    uint64_t now = realtime_ns();
+    std::lock_guard<std::mutex> lock(h->mtx);
+    h->processed++;
+    if (sent_ns != 0 && now > sent_ns) {
+      h->latency_ns += now - sent_ns;
+      h->latency_frames++;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char *argv[])
+{
+  std::string host = argc > 1 ? argv[1] : CONSUMER_HOST;
+  unsigned long port = argc > 2 ? std::strtoul(argv[2], NULL, 10) : CONSUMER_PORT;
+  if (port == 0 || port > utils::port_range_max) {
+    std::cout << "Not valid port. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  client::options_t options = client::default_options;
+  //Version 1 only, must match the server: GST_REMOTE_FRAME_META=1 sends the timing block
+  options.frame_meta = utils::get_env_ulong("GST_CONSUMER_META", 0) != 0;
+  unsigned long max_version = utils::get_env_ulong("GST_CONSUMER_PROTOCOL", frame_protocol::version_2);
+  if (max_version < frame_protocol::version_1 || max_version > frame_protocol::version_2) {
+    std::cout << "Not valid GST_CONSUMER_PROTOCOL (1, 2). Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  options.max_version = static_cast<uint16_t>(max_version);
+  options.crc = utils::get_env_ulong("GST_CONSUMER_CRC", 0) != 0;
+  //The receive thread holds one buffer, the handoff one, the worker one
+  options.buffers = utils::get_env_ulong("GST_CONSUMER_BUFFERS", CONSUMER_BUFFERS);
+  unsigned long save_every = utils::get_env_ulong("GST_CONSUMER_SAVE", 0);
+  unsigned long reconnect_ms = utils::get_env_ulong("GST_CONSUMER_RECONNECT", RECONNECT_MS);
+
+  client::frame_client frames(options);
+  handoff_t handoff;
+  std::thread worker(worker_loop, &handoff, save_every);
+
+  std::thread reporter([&frames, &handoff]() {
+    uint64_t last_frames = 0, last_bytes = 0, last_processed = 0;
+    while (true) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(STATS_INTERVAL_MS));
+      uint64_t received = frames.frames(), bytes = frames.bytes();
+      uint64_t processed, replaced, latency_ns, latency_frames;
+      {
+        std::lock_guard<std::mutex> lock(handoff.mtx);
+        if (handoff.done) {
+          return;
+        }
+        processed = handoff.processed;
+        replaced = handoff.replaced;
+        latency_ns = handoff.latency_ns;
+        latency_frames = handoff.latency_frames;
+        handoff.latency_ns = 0;
+        handoff.latency_frames = 0;
+      }
+      std::cout << "[Consumer] fps: " << (received - last_frames) * 1000 / STATS_INTERVAL_MS
+                << " processed fps: " << (processed - last_processed) * 1000 / STATS_INTERVAL_MS
+                << " MB/s: " << (bytes - last_bytes) / 1000 / STATS_INTERVAL_MS
+                << " skipped: " << replaced << " crc errors: " << frames.crc_errors()
+                << " pool waits: " << frames.pool().waits()
+                << " allocations: " << frames.pool().allocations();
+      if (latency_frames > 0) {
+        std::cout << " sent->processed ms: " << latency_ns / latency_frames / 1e6;
+      }
+      std::cout << std::endl;
+      last_frames = received;
+      last_bytes = bytes;
+      last_processed = processed;
+    }
+  });
+
+  while (true) {
+    if (frames.connect(host, port)) {
+      std::cout << "Connected to " << host << ":" << port << std::endl;
+      bool first = true;
+      frames.run([&handoff, &frames, &first](const client::frame_ptr &frame) {
+        if (first) {
+          std::cout << "[Consumer] protocol " << frames.version() << (frames.crc() ? " with CRCs" : "")
+                    << ", " << frame_protocol::format_name(frame->header.format) << " " << frame->header.width
+                    << "x" << frame->header.height << std::endl;
+          first = false;
+        }
+        {
+          std::lock_guard<std::mutex> lock(handoff.mtx);
+          if (handoff.latest != nullptr) {
+            handoff.replaced++;
+          }
+          //The replaced frame's buffer is back in the pool once this returns
+          handoff.latest = frame;
+        }
+        handoff.cv.notify_one();
+      });
+    }
+    std::cout << "[Consumer] " << frames.error() << std::endl;
+    if (reconnect_ms == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(reconnect_ms));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(handoff.mtx);
+    handoff.done = true;
+    handoff.latest.reset();
+  }
+  handoff.cv.notify_all();
+  worker.join();
+  reporter.join();
+  frames.close();
+  return 0;
+}
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,370 @@
+/**
+ * @file    frame-client.cpp
+ * @brief   C++ consumer of the frames gstreamer-remote serves over TCP
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <crc32c.h>
+
+#include "frame-client.h"
+
+namespace client {
+
+    static uint64_t realtime_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    std::shared_ptr<buffer_pool> buffer_pool::create(size_t buffers) {
+        return std::shared_ptr<buffer_pool>(new buffer_pool(buffers));
+    }
+
+    buffer_pool::buffer_pool(size_t buffers) : count_(std::max<size_t>(buffers, 1)), slots_(count_) {
+        free_.reserve(count_);
+        for (size_t i = count_; i > 0; i--) {
+            slots_[i - 1].capacity = 0;
+            free_.push_back(i - 1);
+        }
+    }
+
+    std::shared_ptr<frame_t> buffer_pool::acquire(uint32_t length) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (free_.empty() && !aborted_) {
+            waits_.fetch_add(1, std::memory_order_relaxed);
+            cv_.wait(lock, [this]() { return !free_.empty() || aborted_; });
+        }
+        if (aborted_) {
+            return nullptr;
+        }
+        size_t index = free_.back();
+        free_.pop_back();
+        lock.unlock();
+
+        slot_t &slot = slots_[index];
+        if (slot.capacity < length) {
+            // JPEG sizes wander from frame to frame, some headroom saves regrowing
+            slot.capacity = length + length / 4;
+            slot.storage.reset(new uint8_t[slot.capacity]);
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+        }
+        slot.frame = {};
+        slot.frame.length = length;
+        slot.frame.data = slot.storage.get();
+
+        auto self = shared_from_this();
+        return std::shared_ptr<frame_t>(&slot.frame, [self, index](frame_t *) { self->release(index); });
+    }
+
+    void buffer_pool::release(size_t index) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            free_.push_back(index);
+        }
+        cv_.notify_one();
+    }
+
+    void buffer_pool::abort() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            aborted_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void buffer_pool::reset_abort() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        aborted_ = false;
+    }
+
+    size_t buffer_pool::available() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return free_.size();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    frame_client::frame_client(const options_t &options)
+        : options_(options), pool_(buffer_pool::create(options.buffers)) {
+    }
+
+    frame_client::~frame_client() {
+        close();
+    }
+
+    bool frame_client::connect(const std::string &host, uint16_t port) {
+        close();
+
+        struct addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo *found = NULL;
+        int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found);
+        if (rc != 0) {
+            return fail(host + ": " + gai_strerror(rc));
+        }
+
+        int fd = -1;
+        for (struct addrinfo *ai = found; ai != NULL; ai = ai->ai_next) {
+            fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            // Before connect(), the window scale is agreed on in the handshake
+            if (options_.recv_buffer > 0) {
+                setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &options_.recv_buffer, sizeof(options_.recv_buffer));
+            }
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                break;
+            }
+            ::close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(found);
+        if (fd < 0) {
+            return fail("connect to " + host + ":" + std::to_string(port) + ": " + strerror(errno));
+        }
+
+        return attach(fd);
+    }
+
+    bool frame_client::attach(int fd) {
+        close();
+        error_.clear();
+        stopping_.store(false, std::memory_order_relaxed);
+        pool_->reset_abort();
+        fd_.store(fd, std::memory_order_relaxed);
+        version_ = 0;
+        crc_ = false;
+        pending_v1_ = false;
+        if (options_.max_version < frame_protocol::version_2) {
+            version_ = frame_protocol::version_1;
+            return true;
+        }
+
+        // The reply is read with the first frame, connecting never waits on the server
+        frame_protocol::hello_t hello = {};
+        hello.magic = frame_protocol::magic;
+        hello.size = sizeof(hello);
+        hello.min_version = frame_protocol::version_1;
+        hello.max_version = options_.max_version;
+        if (options_.crc) {
+            hello.flags = frame_protocol::hello_crc;
+        }
+        auto p = reinterpret_cast<const uint8_t *>(&hello);
+        for (size_t left = sizeof(hello); left > 0;) {
+            ssize_t n = send(fd, p, left, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return fail(std::string("hello: ") + strerror(errno));
+            }
+            p += n;
+            left -= n;
+        }
+        return true;
+    }
+
+    bool frame_client::read_exact(void *data, size_t len) {
+        auto p = static_cast<uint8_t *>(data);
+        int fd = fd_.load(std::memory_order_relaxed);
+        while (len > 0) {
+            // MSG_WAITALL returns early only on a signal, a shutdown or the peer closing
+            ssize_t n = recv(fd, p, len, MSG_WAITALL);
+            if (n < 0 && errno == EINTR && !stopping_.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            if (n <= 0) {
+                return fail(n == 0 || stopping_.load(std::memory_order_relaxed) ? "connection closed"
+                                                                                 : std::string("recv: ") + strerror(errno));
+            }
+            p += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    bool frame_client::skip(size_t len) {
+        uint8_t scratch[256];
+        while (len > 0) {
+            size_t chunk = std::min(len, sizeof(scratch));
+            if (!read_exact(scratch, chunk)) {
+                return false;
+            }
+            len -= chunk;
+        }
+        return true;
+    }
+
+    /* A server that knows the hello answers it first, an older one starts with a version 1 header */
+    bool frame_client::negotiate() {
+        frame_protocol::hello_t hello;
+        static_assert(sizeof(hello) >= sizeof(v1_header_), "the first read must fit both");
+        if (!read_exact(&hello, sizeof(v1_header_))) {
+            return false;
+        }
+        if (hello.magic != frame_protocol::magic) {
+            memcpy(&v1_header_, &hello, sizeof(v1_header_));
+            pending_v1_ = true;
+            version_ = frame_protocol::version_1;
+            return true;
+        }
+
+        auto rest = reinterpret_cast<uint8_t *>(&hello) + sizeof(v1_header_);
+        if (!read_exact(rest, sizeof(hello) - sizeof(v1_header_)) ||
+            !skip(hello.size > sizeof(hello) ? hello.size - sizeof(hello) : 0)) {
+            return false;
+        }
+        if (hello.max_version < frame_protocol::version_1 || hello.max_version > options_.max_version) {
+            return fail("server supports none of protocol versions 1.." + std::to_string(options_.max_version));
+        }
+        version_ = hello.max_version;
+        crc_ = (hello.flags & frame_protocol::hello_crc) != 0;
+        return true;
+    }
+
+    bool frame_client::read_meta(frame_protocol::meta_t &meta) {
+        if (!read_exact(&meta, sizeof(meta))) {
+            return false;
+        }
+        if (meta.size < sizeof(meta)) {
+            return fail("meta block of " + std::to_string(meta.size) + " bytes, is the server sending one?");
+        }
+        // Fields appended by a newer server
+        return skip(meta.size - sizeof(meta));
+    }
+
+    bool frame_client::read(frame_ptr &frame) {
+        // Our own reference would keep a buffer from the pool
+        frame.reset();
+        if (fd_.load(std::memory_order_relaxed) < 0) {
+            return fail("not connected");
+        }
+        if (version_ == 0 && !negotiate()) {
+            return false;
+        }
+        return version_ == frame_protocol::version_2 ? read_v2(frame) : read_v1(frame);
+    }
+
+    bool frame_client::read_v1(frame_ptr &frame) {
+        frame_protocol::header_t header = v1_header_;
+        if (!pending_v1_ && !read_exact(&header, sizeof(header))) {
+            return false;
+        }
+        pending_v1_ = false;
+        if (header.length > options_.max_frame) {
+            return fail("frame " + std::to_string(header.number) + " claims " +
+                        std::to_string(header.length) + " bytes, stream out of sync");
+        }
+        frame_protocol::meta_t meta;
+        if (options_.frame_meta && !read_meta(meta)) {
+            return false;
+        }
+
+        auto next = pool_->acquire(header.length);
+        if (next == nullptr) {
+            return fail("stopped");
+        }
+        next->number = header.number;
+        next->header.sequence = static_cast<uint32_t>(header.number);
+        next->has_meta = options_.frame_meta;
+        if (options_.frame_meta) {
+            next->meta = meta;
+        }
+        if (!read_exact(next->data, next->length)) {
+            return false;
+        }
+        next->received_ns = realtime_ns();
+
+        frames_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(next->length, std::memory_order_relaxed);
+        frame = std::move(next);
+        return true;
+    }
+
+    bool frame_client::read_v2(frame_ptr &frame) {
+        while (true) {
+            // Read straight into the struct, the layout is the wire layout
+            frame_protocol::header_v2_t header;
+            if (!read_exact(&header, sizeof(header))) {
+                return false;
+            }
+            if (header.magic != frame_protocol::magic || header.version != frame_protocol::version_2 ||
+                header.size < sizeof(header)) {
+                return fail("no frame header after frame " + std::to_string(frames()) + ", stream out of sync");
+            }
+            if (header.length > options_.max_frame) {
+                return fail("frame " + std::to_string(header.sequence) + " claims " +
+                            std::to_string(header.length) + " bytes");
+            }
+            frame_protocol::meta_t meta;
+            if (!skip(header.size - sizeof(header)) ||
+                ((header.flags & frame_protocol::flag_meta) && !read_meta(meta))) {
+                return false;
+            }
+
+            auto next = pool_->acquire(header.length);
+            if (next == nullptr) {
+                return fail("stopped");
+            }
+            next->header = header;
+            next->number = static_cast<int32_t>(header.sequence);
+            next->has_meta = (header.flags & frame_protocol::flag_meta) != 0;
+            if (next->has_meta) {
+                next->meta = meta;
+            }
+            if (!read_exact(next->data, next->length)) {
+                return false;
+            }
+            next->received_ns = realtime_ns();
+            bytes_.fetch_add(next->length, std::memory_order_relaxed);
+
+            // The length was right, so the next header is still in sync: drop just this frame
+            if (options_.crc && (header.flags & frame_protocol::flag_crc) &&
+                crc32c::compute(next->data, next->length) != header.crc) {
+                crc_errors_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            frames_.fetch_add(1, std::memory_order_relaxed);
+            frame = std::move(next);
+            return true;
+        }
+    }
+
+    void frame_client::run(const frame_callback &on_frame) {
+        frame_ptr frame;
+        while (read(frame)) {
+            on_frame(frame);
+        }
+    }
+
+    void frame_client::stop() {
+        stopping_.store(true, std::memory_order_relaxed);
+        pool_->abort();
+        int fd = fd_.load(std::memory_order_relaxed);
+        if (fd >= 0) {
+            shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    void frame_client::close() {
+        int fd = fd_.exchange(-1, std::memory_order_relaxed);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool frame_client::fail(const std::string &what) {
+        error_ = what;
+        return false;
+    }
+
+};
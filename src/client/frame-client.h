@@ -0,0 +1,184 @@
+/**
+ * @file    frame-client.h
+ * @brief   C++ consumer of the frames gstreamer-remote serves over TCP
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Reads the wire format of common/frame-protocol.h with exact reads, so a
+ * frame split over any number of TCP segments arrives whole. It asks for
+ * version 2 on connect and reads version 1 from servers that don't know the
+ * hello, telling them apart by the first bytes they send. Payloads are
+ * received straight into buffers of a pool: a frame handed to the caller
+ * holds its buffer until the last reference goes away, then the buffer is
+ * reused for a later frame without being freed or allocated again.
+ *
+ *   client::frame_client c;
+ *   c.connect("127.0.0.1", 4007);
+ *   c.run([](const client::frame_ptr &frame) { infer(frame->data, frame->length); });
+ */
+#ifndef __FRAME_CLIENT_H
+#define __FRAME_CLIENT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <frame-protocol.h>
+
+namespace client {
+
+    /** @brief One frame as received, data points into a pooled buffer */
+    typedef struct {
+        int32_t number;             // Frame counter of the server, the low bits of sequence with version 2
+        uint32_t length;            // Payload bytes
+        bool has_meta;              // meta is valid, the server sends the timing block
+        frame_protocol::meta_t meta;
+        uint64_t received_ns;       // CLOCK_REALTIME when the last payload byte was read
+        uint8_t *data;
+        // Version 2 only, header.sequence == number and the rest 0 with version 1
+        frame_protocol::header_v2_t header;
+    } frame_t;
+
+    /** @brief Returns its buffer to the pool when the last copy goes away */
+    typedef std::shared_ptr<const frame_t> frame_ptr;
+
+    /**
+     * @brief Fixed number of reusable payload buffers. A buffer keeps the
+     *        largest capacity it was ever given, so after the first few
+     *        frames no allocation happens at all.
+     *
+     * Thread safe: frames may be released on any thread.
+     */
+    class buffer_pool : public std::enable_shared_from_this<buffer_pool> {
+    public:
+        /** @brief Use create(), frames keep the pool alive through a shared_ptr */
+        static std::shared_ptr<buffer_pool> create(size_t buffers);
+
+        /**
+         * @brief Wait until a buffer is free and size it for length bytes
+         *
+         * @return nullptr if abort() was called meanwhile
+         */
+        std::shared_ptr<frame_t> acquire(uint32_t length);
+
+        /** @brief Wake and fail every acquire(), e.g. when the client stops */
+        void abort();
+        void reset_abort();
+
+        size_t buffers() const { return count_; }
+        size_t available() const;
+        uint64_t waits() const { return waits_.load(std::memory_order_relaxed); }
+        uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+    private:
+        explicit buffer_pool(size_t buffers);
+        void release(size_t index);
+
+        struct slot_t {
+            frame_t frame;
+            std::unique_ptr<uint8_t[]> storage; // Not a vector: growing it would zero bytes about to be overwritten
+            size_t capacity;
+        };
+
+        size_t count_;
+        std::vector<slot_t> slots_;
+        std::vector<size_t> free_;
+        bool aborted_ = false;
+        mutable std::mutex mtx_;
+        std::condition_variable cv_;
+        std::atomic<uint64_t> waits_{0};        // acquire() found every buffer held by the caller
+        std::atomic<uint64_t> allocations_{0};  // A buffer had to grow
+    };
+
+    typedef struct {
+        bool frame_meta;            // Version 1 only: the server runs with GST_REMOTE_FRAME_META=1
+        size_t buffers;             // Frames the caller may hold at the same time, plus the one being read
+        uint32_t max_frame;         // Larger lengths are a protocol error, not an allocation
+        int recv_buffer;            // SO_RCVBUF in bytes, 0 keeps the system default
+        uint16_t max_version;       // Highest version to ask for, version_1 sends no hello at all
+        bool crc;                   // Ask for payload CRCs and check them, version 2 only
+    } options_t;
+
+    static constexpr options_t default_options = {false, 4, 64u << 20, 4 << 20, frame_protocol::version_2, false};
+
+    /**
+     * @brief Blocking TCP client for one gstreamer-remote frame server.
+     *
+     * read() and run() must be called from one thread at a time; stop() and
+     * the counters may be used from any thread.
+     */
+    class frame_client {
+    public:
+        typedef std::function<void(const frame_ptr &)> frame_callback;
+
+        explicit frame_client(const options_t &options = default_options);
+        ~frame_client();
+
+        frame_client(const frame_client &) = delete;
+        frame_client &operator=(const frame_client &) = delete;
+
+        /** @brief Connect to host (IPv4 address or name) and port */
+        bool connect(const std::string &host, uint16_t port);
+
+        /** @brief Use an already connected socket, the client owns it from now on and sends the hello */
+        bool attach(int fd);
+
+        /**
+         * @brief Read the next frame, waiting for a free buffer first
+         *
+         * @return false on disconnect, error or stop(), see error()
+         */
+        bool read(frame_ptr &frame);
+
+        /** @brief Call on_frame for every frame until the connection ends or stop() */
+        void run(const frame_callback &on_frame);
+
+        /** @brief Make read() and run() return, from any thread */
+        void stop();
+
+        void close();
+        bool connected() const { return fd_.load(std::memory_order_relaxed) >= 0; }
+
+        /** @brief Wire format version, 0 until the first read() found out */
+        uint16_t version() const { return version_; }
+        /** @brief The server agreed to send payload CRCs */
+        bool crc() const { return crc_; }
+        const std::string &error() const { return error_; }
+
+        uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+        uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+        /** @brief Frames dropped because their payload didn't match the CRC */
+        uint64_t crc_errors() const { return crc_errors_.load(std::memory_order_relaxed); }
+        const buffer_pool &pool() const { return *pool_; }
+
+    private:
+        bool read_exact(void *data, size_t len);
+        bool skip(size_t len);
+        bool negotiate();
+        bool read_v1(frame_ptr &frame);
+        bool read_v2(frame_ptr &frame);
+        bool read_meta(frame_protocol::meta_t &meta);
+        bool fail(const std::string &what);
+
+        options_t options_;
+        std::shared_ptr<buffer_pool> pool_;
+        std::atomic<int> fd_{-1};           // Atomic for stop() from another thread
+        std::atomic<bool> stopping_{false};
+        std::string error_;
+        uint16_t version_ = 0;
+        bool crc_ = false;
+        bool pending_v1_ = false;               // v1_header_ was read while looking for the hello reply
+        frame_protocol::header_t v1_header_;
+        std::atomic<uint64_t> frames_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> crc_errors_{0};
+    };
+
+};
+
+#endif // __FRAME_CLIENT_H
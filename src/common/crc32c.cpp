@@ -0,0 +1,96 @@
+/**
+ * @file    crc32c.cpp
+ * @brief   CRC-32C (Castagnoli) of frame payloads
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#include "crc32c.h"
+
+namespace crc32c {
+
+    static constexpr uint32_t polynomial = 0x82F63B78u;     // Reflected 0x1EDC6F41
+
+    struct table_t {
+        uint32_t entries[256];
+        table_t() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    c = (c >> 1) ^ (polynomial & (0u - (c & 1)));
+                }
+                entries[i] = c;
+            }
+        }
+    };
+
+    static uint32_t update_table(uint32_t crc, const uint8_t *p, size_t len) {
+        static const table_t table;
+        while (len-- > 0) {
+            crc = table.entries[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+#if defined(__x86_64__)
+    __attribute__((target("sse4.2")))
+    static uint32_t update_sse42(uint32_t crc, const uint8_t *p, size_t len) {
+        uint64_t c = crc;
+        for (; len >= 8; p += 8, len -= 8) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            c = _mm_crc32_u64(c, word);
+        }
+        uint32_t c32 = static_cast<uint32_t>(c);
+        for (; len > 0; p++, len--) {
+            c32 = _mm_crc32_u8(c32, *p);
+        }
+        return c32;
+    }
+
+    static const bool have_sse42 = __builtin_cpu_supports("sse4.2");
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    static uint32_t update_armv8(uint32_t crc, const uint8_t *p, size_t len) {
+        for (; len >= 8; p += 8, len -= 8) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            crc = __crc32cd(crc, word);
+        }
+        for (; len > 0; p++, len--) {
+            crc = __crc32cb(crc, *p);
+        }
+        return crc;
+    }
+#endif
+
+    uint32_t update(uint32_t crc, const void *data, size_t len) {
+        auto p = static_cast<const uint8_t *>(data);
+#if defined(__x86_64__)
+        if (have_sse42) {
+            return update_sse42(crc, p, len);
+        }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+        return update_armv8(crc, p, len);
+#endif
+        return update_table(crc, p, len);
+    }
+
+    const char *implementation() {
+#if defined(__x86_64__)
+        return have_sse42 ? "sse4.2" : "table";
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+        return "armv8";
+#else
+        return "table";
+#endif
+    }
+
+};
@@ -0,0 +1,37 @@
+/**
+ * @file    crc32c.h
+ * @brief   CRC-32C (Castagnoli) of frame payloads
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * The polynomial SSE4.2 and ARMv8 have an instruction for, 8 bytes per
+ * instruction where the CPU has it and a table per byte where it doesn't.
+ * Chunks may be fed one after the other:
+ *
+ *   uint32_t crc = crc32c::initial;
+ *   crc = crc32c::update(crc, a, a_len);
+ *   crc = crc32c::update(crc, b, b_len);
+ *   uint32_t value = crc32c::finish(crc);   // == crc32c::compute(a + b)
+ */
+#ifndef __CRC32C_H
+#define __CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace crc32c {
+
+    static constexpr uint32_t initial = 0xFFFFFFFFu;
+
+    uint32_t update(uint32_t crc, const void *data, size_t len);
+
+    inline uint32_t finish(uint32_t crc) { return crc ^ 0xFFFFFFFFu; }
+
+    inline uint32_t compute(const void *data, size_t len) { return finish(update(initial, data, len)); }
+
+    /** @brief "sse4.2", "armv8" or "table" */
+    const char *implementation();
+
+};
+
+#endif // __CRC32C_H
@@ -0,0 +1,160 @@
+/**
+ * @file    frame-protocol.h
+ * @brief   Wire format of the frames gstreamer-remote sends to TCP consumers
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * A consumer may open with a hello_t asking for version 2, the server
+ * answers with a hello_t naming the version it picked. From then on every
+ * frame is sent as:
+ *
+ *   version 2: [header_v2_t][meta_t if flag_meta][length payload bytes]
+ *   version 1: [header_t][meta_t, with GST_REMOTE_FRAME_META=1][length payload bytes]
+ *
+ * Consumers that send nothing get version 1. Version 2 headers are 64 bytes
+ * with every field naturally aligned, so a reader can use them in place of
+ * the receive buffer. All fields are little endian.
+ */
+#ifndef __FRAME_PROTOCOL_H
+#define __FRAME_PROTOCOL_H
+
+#include <cstdint>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the wire format is little endian, add byte swaps first");
+
+namespace frame_protocol {
+
+    static constexpr uint32_t magic = 0x46525347;          // "GSRF"
+    static constexpr uint16_t version_1 = 1;
+    static constexpr uint16_t version_2 = 2;
+
+    /** @brief hello_t flags: the consumer asks for, the server grants */
+    enum hello_flags_t : uint32_t {
+        hello_crc = 1u << 0,        // CRC-32C of every payload in header_v2_t::crc
+    };
+
+    /**
+     * @brief Both ends of the version negotiation. The consumer sends the
+     *        range it understands, the server answers with min_version ==
+     *        max_version == the one it picked, or 0 if there is none and it
+     *        closes the connection.
+     */
+    typedef struct {
+        uint32_t magic;
+        uint16_t size;              // Bytes of this hello, skip anything past sizeof(hello_t)
+        uint16_t min_version;
+        uint16_t max_version;
+        uint16_t reserved;
+        uint32_t flags;             // hello_flags_t
+    } hello_t;
+
+    /** @brief Version 1 frame header, no magic, no way to tell a payload apart */
+    typedef struct {
+        int32_t number;             // Frame counter of the server
+        uint32_t length;            // Payload bytes, the meta block is not included
+    } header_t;
+
+    enum format_t : uint32_t {
+        format_unknown,
+        format_jpeg,                // One JPEG image
+        format_tensor,              // tensor_header_t and float planes, GST_REMOTE_OUTPUT=tensor
+        format_bgr,                 // Packed 8 bit BGR, stride bytes per row
+    };
+
+    enum frame_flags_t : uint32_t {
+        flag_keyframe = 1u << 0,    // Decodable on its own, always set for JPEG and tensors
+        flag_meta = 1u << 1,        // A meta_t follows the header
+        flag_crc = 1u << 2,         // crc holds the CRC-32C of the payload
+    };
+
+    /** @brief Version 2 frame header */
+    typedef struct {
+        uint32_t magic;             // magic, a reader that lost sync notices here
+        uint16_t version;           // version_2
+        uint16_t size;              // Bytes of this header, skip anything past sizeof(header_v2_t)
+        uint64_t sequence;          // Frames the server sent since it started, never wraps
+        uint64_t pts;               // Receiver running time in ns, unknown_pts if not set
+        uint32_t length;            // Payload bytes, the meta block is not included
+        uint32_t format;            // format_t
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;            // Bytes per row of raw formats, 0 otherwise
+        uint32_t flags;             // frame_flags_t
+        uint32_t stream_id;         // Incoming stream, 0 when the remote runs a single one
+        uint32_t crc;               // With flag_crc
+        uint64_t reserved;
+    } header_v2_t;
+
+    /** @brief Points in the remote pipeline a frame's meta block records */
+    enum stage_t : uint32_t {
+        stage_arrival,              // Last RTP packet of the frame left udpsrc
+        stage_decoded,              // avdec_h264 output
+        stage_encoded,              // jpegenc output
+        stage_enqueued,             // Handed to the socket thread
+        stage_sent,                 // Handed to the frame server for every client
+        stage_count
+    };
+
+    static constexpr uint16_t meta_version = 1;
+    static constexpr uint64_t unknown_pts = UINT64_MAX;
+
+    /**
+     * @brief Optional per-frame timing block. Readers must skip size bytes
+     *        rather than sizeof(meta_t), so fields can be appended later.
+     */
+    typedef struct {
+        uint16_t size;              // Bytes of this block on the wire
+        uint16_t version;
+        uint32_t rtp_timestamp;     // Of the packets that carried the frame
+        uint32_t stream_id;         // Incoming stream, 0 when the remote runs a single one
+        uint32_t reserved;
+        uint64_t pts;               // Receiver running time in ns, unknown_pts if not set
+        uint64_t stage_ns[stage_count]; // CLOCK_REALTIME ns, 0 if the stage was not seen
+    } meta_t;
+
+    static constexpr uint32_t tensor_magic = 0x524E5354;  // "TSNR"
+    static constexpr uint16_t tensor_version = 1;
+    static constexpr uint32_t tensor_float32 = 0;
+
+    /**
+     * @brief Payload start with GST_REMOTE_OUTPUT=tensor, channels planes of
+     *        width x height values follow. A point of the tensor maps back
+     *        to the decoded frame as ((x - pad_x) / scale, (y - pad_y) / scale).
+     */
+    typedef struct {
+        uint32_t magic;             // tensor_magic
+        uint16_t size;              // Bytes of this header, the planes start here
+        uint16_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;          // Planar R, G, B
+        uint32_t dtype;             // tensor_float32
+        uint32_t src_width;         // Decoded frame
+        uint32_t src_height;
+        float scale;                // Tensor pixels per frame pixel
+        uint32_t pad_x;             // Left border of the letterbox
+        uint32_t pad_y;             // Top border of the letterbox
+        uint32_t resized_width;     // Frame area inside the border
+        uint32_t resized_height;
+        uint32_t reserved[3];
+    } tensor_header_t;
+
+    static_assert(sizeof(hello_t) == 16, "hello_t is part of the wire format");
+    static_assert(sizeof(header_t) == 8, "header_t is part of the wire format");
+    static_assert(sizeof(header_v2_t) == 64, "header_v2_t is part of the wire format");
+    static_assert(sizeof(meta_t) == 64, "meta_t is part of the wire format");
+    static_assert(sizeof(tensor_header_t) == 64, "tensor_header_t is part of the wire format");
+
+    inline const char *stage_name(uint32_t stage) {
+        static const char *names[stage_count] = {"arrival", "decoded", "encoded", "enqueued", "sent"};
+        return stage < stage_count ? names[stage] : "unknown";
+    }
+
+    inline const char *format_name(uint32_t format) {
+        static const char *names[] = {"unknown", "jpeg", "tensor", "bgr"};
+        return format <= format_bgr ? names[format] : "unknown";
+    }
+
+};
+
+#endif // __FRAME_PROTOCOL_H
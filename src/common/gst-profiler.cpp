@@ -0,0 +1,424 @@
+/**
+ * @file    gst-profiler.cpp
+ * @brief   Per-element processing time and per-pad queueing latency of a pipeline
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <gst/gst.h>
+
+#include "gst-profiler.h"
+
+#define MAX_SLICES      4000000     // ~100 MB of JSON, later buffers only go into the summary
+#define MAX_PENDING     4096        // Timestamps waiting in one element, more means it drops buffers
+
+/* The tracer only exists to own the hooks, the state lives in gst_profiler */
+typedef struct { GstTracer parent; } ProfileTracer;
+typedef struct { GstTracerClass parent_class; } ProfileTracerClass;
+
+G_DEFINE_TYPE (ProfileTracer, profile_tracer, GST_TYPE_TRACER)
+
+static void profile_tracer_class_init (ProfileTracerClass *) {}
+static void profile_tracer_init (ProfileTracer *) {}
+
+namespace gst_profiler {
+
+    typedef struct {
+        std::string name;
+        std::atomic<bool> boundary{false};  // Pushes from a task of its own: queue, source, jitter buffer
+    } element_t;
+
+    /** @brief An element working on a buffer on this thread */
+    typedef struct {
+        element_t *element;                 // NULL if the peer could not be resolved
+        uint64_t start;
+        uint64_t resume;                    // Last time control came back to it
+        uint64_t self;                      // Time spent in it, its downstream excluded
+    } frame_t;
+
+    typedef struct {
+        element_t *element;
+        uint64_t start;
+        uint64_t duration;
+    } slice_t;
+
+    typedef struct {
+        uint64_t buffers;
+        uint64_t self_ns;
+        uint64_t max_ns;
+    } element_total_t;
+
+    typedef struct {
+        std::string name;
+        uint64_t buffers;
+        uint64_t wait_ns;
+        uint64_t max_ns;
+    } pad_total_t;
+
+    /** @brief Everything one streaming thread recorded, only that thread writes it */
+    struct thread_log {
+        std::mutex mtx;                     // Contended only by finish()
+        uint32_t tid;
+        std::string name;
+        std::vector<frame_t> stack;
+        std::vector<slice_t> slices;
+        std::unordered_map<element_t *, element_total_t> elements;
+        std::unordered_map<GstPad *, pad_total_t> pads;
+        std::unordered_map<GstElement *, element_t *> known;   // Cache of the element table
+    };
+
+    static std::atomic<bool> recording{false};
+    static std::atomic<uint64_t> slice_count{0};
+    static std::string trace_file;
+
+    static std::mutex registry_mtx;         // Element table and thread list
+    static std::vector<std::unique_ptr<element_t>> elements;
+    static std::unordered_map<GstElement *, element_t *> element_table;
+    static std::vector<std::shared_ptr<thread_log>> threads;
+
+    // Timestamps of the buffers inside each boundary element, FIFO per
+    // timestamp as all RTP packets of a frame share one
+    static std::mutex pending_mtx;
+    static std::unordered_map<element_t *, std::unordered_map<uint64_t, std::deque<uint64_t>>> pending;
+
+    static thread_log &local_log() {
+        static thread_local std::shared_ptr<thread_log> log;
+        if (!log) {
+            log = std::make_shared<thread_log>();
+            char name[16] = "";
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+            log->name = name;
+            std::lock_guard<std::mutex> lock(registry_mtx);
+            log->tid = threads.size() + 1;
+            threads.push_back(log);
+        }
+        return *log;
+    }
+
+    static element_t *lookup(thread_log &log, GstElement *element) {
+        auto found = log.known.find(element);
+        if (found != log.known.end()) {
+            return found->second;
+        }
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        element_t *&entry = element_table[element];
+        if (entry == NULL) {
+            elements.push_back(std::unique_ptr<element_t>(new element_t));
+            entry = elements.back().get();
+            entry->name = GST_OBJECT_NAME(element);
+        }
+        log.known[element] = entry;
+        return entry;
+    }
+
+    /* Ghost and proxy pads only relay a push that is traced again on the real pad */
+    static GstElement *pad_owner(GstPad *pad) {
+        GstObject *parent = GST_OBJECT_PARENT(pad);
+        if (parent == NULL || !GST_IS_ELEMENT(parent) || GST_IS_BIN(parent)) {
+            return NULL;
+        }
+        return GST_ELEMENT(parent);
+    }
+
+    /* The element a push ends up in, through the ghost pads of any bins in between */
+    static GstElement *peer_element(GstPad *pad) {
+        GstPad *peer = gst_pad_get_peer(pad);
+        while (peer != NULL) {
+            GstPad *next = NULL;
+            if (GST_IS_GHOST_PAD(peer)) {
+                // Sink ghost pad, into the bin
+                next = gst_ghost_pad_get_target(GST_GHOST_PAD(peer));
+            }
+            else if (GST_IS_PROXY_PAD(peer)) {
+                // Internal pad of a source ghost pad, out of the bin
+                GstProxyPad *ghost = gst_proxy_pad_get_internal(GST_PROXY_PAD(peer));
+                if (ghost != NULL) {
+                    next = gst_pad_get_peer(GST_PAD(ghost));
+                    gst_object_unref(ghost);
+                }
+            }
+            else {
+                GstElement *element = gst_pad_get_parent_element(peer);
+                gst_object_unref(peer);
+                return element;
+            }
+            gst_object_unref(peer);
+            peer = next;
+        }
+        return NULL;
+    }
+
+    static uint64_t buffer_key(GstBuffer *buffer) {
+        if (buffer == NULL) {
+            return 0;
+        }
+        return GST_BUFFER_PTS_IS_VALID(buffer) ? GST_BUFFER_PTS(buffer) : reinterpret_cast<uintptr_t>(buffer);
+    }
+
+    static void entered_boundary(element_t *element, uint64_t key, uint64_t ts) {
+        std::lock_guard<std::mutex> lock(pending_mtx);
+        auto &waiting = pending[element];
+        if (waiting.size() >= MAX_PENDING) {
+            waiting.clear();
+        }
+        waiting[key].push_back(ts);
+    }
+
+    static void left_boundary(thread_log &log, element_t *element, GstPad *pad, uint64_t key, uint64_t ts) {
+        uint64_t entered;
+        {
+            std::lock_guard<std::mutex> lock(pending_mtx);
+            auto &waiting = pending[element];
+            auto found = waiting.find(key);
+            if (found == waiting.end()) {
+                // A source, or an element that retimes its buffers
+                return;
+            }
+            entered = found->second.front();
+            found->second.pop_front();
+            if (found->second.empty()) {
+                waiting.erase(found);
+            }
+        }
+        pad_total_t &total = log.pads[pad];
+        if (total.name.empty()) {
+            total.name = element->name + "." + GST_PAD_NAME(pad);
+        }
+        const uint64_t wait = ts - entered;
+        total.buffers++;
+        total.wait_ns += wait;
+        total.max_ns = std::max(total.max_ns, wait);
+    }
+
+    static void push_pre(GstClockTime ts, GstPad *pad, GstBuffer *buffer) {
+        GstElement *owner = pad_owner(pad);
+        if (owner == NULL) {
+            return;
+        }
+        thread_log &log = local_log();
+        std::lock_guard<std::mutex> lock(log.mtx);
+        element_t *pusher = lookup(log, owner);
+        const uint64_t key = buffer_key(buffer);
+
+        if (!log.stack.empty()) {
+            frame_t &top = log.stack.back();
+            top.self += ts - top.resume;
+        }
+        else if (GST_PAD_TASK(pad) != NULL) {
+            pusher->boundary.store(true, std::memory_order_relaxed);
+            left_boundary(log, pusher, pad, key, ts);
+        }
+
+        element_t *peer = NULL;
+        GstElement *downstream = peer_element(pad);
+        if (downstream != NULL) {
+            peer = lookup(log, downstream);
+            gst_object_unref(downstream);
+            if (peer->boundary.load(std::memory_order_relaxed)) {
+                entered_boundary(peer, key, ts);
+            }
+        }
+        log.stack.push_back({peer, ts, ts, 0});
+    }
+
+    static void push_post(GstClockTime ts, GstPad *pad) {
+        if (pad_owner(pad) == NULL) {
+            return;
+        }
+        thread_log &log = local_log();
+        std::lock_guard<std::mutex> lock(log.mtx);
+        if (log.stack.empty()) {
+            // The push started before the recording did
+            return;
+        }
+
+        frame_t frame = log.stack.back();
+        log.stack.pop_back();
+        frame.self += ts - frame.resume;
+        if (frame.element != NULL) {
+            element_total_t &total = log.elements[frame.element];
+            total.buffers++;
+            total.self_ns += frame.self;
+            total.max_ns = std::max(total.max_ns, frame.self);
+            if (slice_count.fetch_add(1, std::memory_order_relaxed) < MAX_SLICES) {
+                log.slices.push_back({frame.element, frame.start, ts - frame.start});
+            }
+        }
+        if (!log.stack.empty()) {
+            log.stack.back().resume = ts;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /* Tracer hooks, called on the streaming threads around every pad push */
+    static void cb_push_pre(GstTracer *, GstClockTime ts, GstPad *pad, GstBuffer *buffer) {
+        if (recording.load(std::memory_order_relaxed)) {
+            push_pre(ts, pad, buffer);
+        }
+    }
+
+    static void cb_push_list_pre(GstTracer *, GstClockTime ts, GstPad *pad, GstBufferList *list) {
+        if (recording.load(std::memory_order_relaxed)) {
+            push_pre(ts, pad, gst_buffer_list_length(list) > 0 ? gst_buffer_list_get(list, 0) : NULL);
+        }
+    }
+
+    static void cb_push_post(GstTracer *, GstClockTime ts, GstPad *pad, GstFlowReturn) {
+        if (recording.load(std::memory_order_relaxed)) {
+            push_post(ts, pad);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    static std::string json_string(const std::string &text) {
+        std::string out = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            if (static_cast<unsigned char>(c) >= 0x20) {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    static void write_trace(const std::vector<std::shared_ptr<thread_log>> &logs) {
+        std::ofstream out(trace_file);
+        if (!out) {
+            std::cout << "[Profile] Could not write " << trace_file << std::endl;
+            return;
+        }
+        const int pid = getpid();
+        char line[256];
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (auto &log : logs) {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":" << log->tid << ",\"args\":{\"name\":" << json_string(log->name) << "}}";
+            first = false;
+            for (auto &slice : log->slices) {
+                snprintf(line, sizeof(line), ",\n{\"name\":%s,\"cat\":\"element\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+                         json_string(slice.element->name).c_str(), slice.start / 1e3, slice.duration / 1e3, pid, log->tid);
+                out << line;
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        std::cout << "[Profile] " << std::min<uint64_t>(slice_count.load(), MAX_SLICES) << " slices written to "
+                  << trace_file << std::endl;
+    }
+
+    static void print_summary(const std::vector<std::shared_ptr<thread_log>> &logs) {
+        std::unordered_map<element_t *, element_total_t> element_totals;
+        std::unordered_map<GstPad *, pad_total_t> pad_totals;
+        uint64_t all_ns = 0;
+        for (auto &log : logs) {
+            for (auto &entry : log->elements) {
+                element_total_t &total = element_totals[entry.first];
+                total.buffers += entry.second.buffers;
+                total.self_ns += entry.second.self_ns;
+                total.max_ns = std::max(total.max_ns, entry.second.max_ns);
+                all_ns += entry.second.self_ns;
+            }
+            for (auto &entry : log->pads) {
+                pad_total_t &total = pad_totals[entry.first];
+                total.name = entry.second.name;
+                total.buffers += entry.second.buffers;
+                total.wait_ns += entry.second.wait_ns;
+                total.max_ns = std::max(total.max_ns, entry.second.max_ns);
+            }
+        }
+
+        std::vector<std::pair<element_t *, element_total_t>> by_time(element_totals.begin(), element_totals.end());
+        std::sort(by_time.begin(), by_time.end(), [](const std::pair<element_t *, element_total_t> &a,
+                                                     const std::pair<element_t *, element_total_t> &b) {
+            return a.second.self_ns > b.second.self_ns;
+        });
+        std::cout << std::fixed << std::setprecision(1)
+                  << "[Profile] " << std::left << std::setw(28) << "element" << std::right << std::setw(10) << "buffers"
+                  << std::setw(12) << "self ms" << std::setw(10) << "mean us" << std::setw(10) << "max us"
+                  << std::setw(8) << "share" << std::endl;
+        for (auto &entry : by_time) {
+            const element_total_t &total = entry.second;
+            std::cout << "[Profile] " << std::left << std::setw(28) << entry.first->name << std::right
+                      << std::setw(10) << total.buffers << std::setw(12) << total.self_ns / 1e6
+                      << std::setw(10) << (total.buffers ? total.self_ns / 1e3 / total.buffers : 0.0)
+                      << std::setw(10) << total.max_ns / 1e3
+                      << std::setw(7) << (all_ns ? 100.0 * total.self_ns / all_ns : 0.0) << "%" << std::endl;
+        }
+
+        if (pad_totals.empty()) {
+            return;
+        }
+        std::cout << std::setprecision(2) << "[Profile] " << std::left << std::setw(28) << "queueing before pad"
+                  << std::right << std::setw(10) << "buffers" << std::setw(12) << "mean ms" << std::setw(10)
+                  << "max ms" << std::endl;
+        for (auto &entry : pad_totals) {
+            const pad_total_t &total = entry.second;
+            std::cout << "[Profile] " << std::left << std::setw(28) << total.name << std::right
+                      << std::setw(10) << total.buffers << std::setw(12)
+                      << (total.buffers ? total.wait_ns / 1e6 / total.buffers : 0.0)
+                      << std::setw(10) << total.max_ns / 1e6 << std::endl;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    bool start(const std::string &trace_path, unsigned seconds) {
+        trace_file = trace_path;
+        // Hooks hold a reference, the tracer lives as long as the process
+        GstTracer *tracer = GST_TRACER(g_object_new(profile_tracer_get_type(), NULL));
+        if (tracer == NULL) {
+            return false;
+        }
+        gst_tracing_register_hook(tracer, "pad-push-pre", G_CALLBACK(cb_push_pre));
+        gst_tracing_register_hook(tracer, "pad-push-post", G_CALLBACK(cb_push_post));
+        gst_tracing_register_hook(tracer, "pad-push-list-pre", G_CALLBACK(cb_push_list_pre));
+        gst_tracing_register_hook(tracer, "pad-push-list-post", G_CALLBACK(cb_push_post));
+        recording.store(true);
+
+        std::cout << "[Profile] Recording";
+        if (seconds > 0) {
+            std::cout << " for " << seconds << " s";
+            std::thread([seconds]() {
+                std::this_thread::sleep_for(std::chrono::seconds(seconds));
+                finish();
+            }).detach();
+        }
+        std::cout << ", trace goes to " << trace_file << std::endl;
+        return true;
+    }
+
+    void finish() {
+        if (!recording.exchange(false)) {
+            return;
+        }
+        std::vector<std::shared_ptr<thread_log>> logs;
+        {
+            std::lock_guard<std::mutex> lock(registry_mtx);
+            logs = threads;
+        }
+        // A hook that saw recording set may still be running, wait for it
+        std::vector<std::unique_lock<std::mutex>> locks;
+        for (auto &log : logs) {
+            locks.emplace_back(log->mtx);
+        }
+        write_trace(logs);
+        print_summary(logs);
+    }
+
+};
@@ -0,0 +1,39 @@
+/**
+ * @file    gst-profiler.h
+ * @brief   Per-element processing time and per-pad queueing latency of a pipeline
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * A GstTracer hooks every pad push in the process. Each streaming thread
+ * keeps a stack of the elements a buffer is being pushed through, so the
+ * time between two hooks is charged to the element running in between: an
+ * element's self time excludes what its downstream peers took, which is what
+ * makes the element limiting throughput stand out. Buffers crossing a thread
+ * boundary (queue, rtpjitterbuffer, a source) are matched on both sides and
+ * the wait is reported for the pad they leave from.
+ *
+ * After the recording window the results are written as Chrome trace-event
+ * JSON (chrome://tracing or https://ui.perfetto.dev), one nested slice per
+ * element per buffer, and printed as a summary table. The pipeline keeps
+ * running, the hooks stay installed but return at once.
+ */
+#ifndef __GST_PROFILER_H
+#define __GST_PROFILER_H
+
+#include <string>
+
+namespace gst_profiler {
+
+    /**
+     * @brief Install the tracer, call after gst_init() and before PLAYING
+     * @param trace_path Chrome trace file written when the window ends
+     * @param seconds    Recording window, 0 records until finish()
+     */
+    bool start(const std::string &trace_path, unsigned seconds);
+
+    /** @brief End the recording, write the trace and print the summary; once only */
+    void finish();
+
+};
+
+#endif // __GST_PROFILER_H
@@ -0,0 +1,18 @@
+/**
+ * @file    rtcp-config.h
+ * @brief   RTCP settings gstreamer-local and gstreamer-remote have to agree on
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * The sender adapts its bitrate to the receiver reports and the receiver
+ * asks for keyframes over the same RTCP, so both rtpsessions report at the
+ * same pace.
+ */
+#ifndef __RTCP_CONFIG_H
+#define __RTCP_CONFIG_H
+
+#include <gst/gst.h>
+
+#define RTCP_MIN_INTERVAL   (500 * GST_MSECOND) // rtpsession default is 5 s, too slow to adapt on
+
+#endif // __RTCP_CONFIG_H
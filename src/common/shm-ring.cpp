@@ -0,0 +1,284 @@
+/**
+ * @file    shm-ring.cpp
+ * @brief   Shared-memory ring of raw video frames for co-located consumers
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <iostream>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <new>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "shm-ring.h"
+
+namespace shm_ring {
+
+    static constexpr size_t header_area = 4096;
+    static constexpr size_t data_alignment = 64;
+    static constexpr size_t slot_alignment = 4096;
+
+    static size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static uint32_t *futex_word(std::atomic<uint32_t> &word) {
+        return reinterpret_cast<uint32_t *>(&word);
+    }
+
+    /* Shared (not FUTEX_PRIVATE) so waiters in other processes are woken */
+    static void futex_wake_all(std::atomic<uint32_t> &word) {
+        syscall(SYS_futex, futex_word(word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+
+    static void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, int timeout_ms) {
+        struct timespec ts;
+        struct timespec *timeout = NULL;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            timeout = &ts;
+        }
+        syscall(SYS_futex, futex_word(word), FUTEX_WAIT, expected, timeout, NULL, 0);
+    }
+
+    static std::string object_name(const std::string &name) {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ring_writer::ring_writer(const std::string &name, uint32_t slot_count)
+        : name_(object_name(name)), slot_count_(slot_count > 1 ? slot_count : 2) {}
+
+    ring_writer::~ring_writer() {
+        destroy();
+    }
+
+    bool ring_writer::create(uint32_t slot_capacity) {
+        destroy();
+
+        size_t data_offset = align_up(sizeof(slot_header_t), data_alignment);
+        size_t slot_stride = align_up(data_offset + slot_capacity, slot_alignment);
+        size_ = header_area + slot_stride * slot_count_;
+
+        // A ring left behind by a crashed writer is replaced, not reused
+        shm_unlink(name_.c_str());
+        fd_ = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+        if (fd_ < 0) {
+            perror("shm_open");
+            return false;
+        }
+        if (ftruncate(fd_, size_) < 0) {
+            perror("ftruncate");
+            destroy();
+            return false;
+        }
+        void *base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            perror("mmap");
+            destroy();
+            return false;
+        }
+        base_ = static_cast<uint8_t *>(base);
+
+        // ftruncate() zero fills, which is a valid initial state for the
+        // atomics, but construct them properly anyway
+        header_ = new (base_) ring_header_t();
+        header_->version = ring_version;
+        header_->header_size = sizeof(ring_header_t);
+        header_->slot_count = slot_count_;
+        header_->slot_stride = slot_stride;
+        header_->slot_capacity = slot_capacity;
+        header_->data_offset = data_offset;
+        header_->writer_pid = getpid();
+        for (uint32_t i = 0; i < slot_count_; i++) {
+            new (base_ + header_area + i * slot_stride) slot_header_t();
+        }
+
+        // Readers check the magic last, publish it after everything else
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = ring_magic;
+
+        std::cout << "Shared memory ring " << name_ << ": " << slot_count_ << " slots of "
+                  << slot_capacity << " bytes" << std::endl;
+        return true;
+    }
+
+    void ring_writer::destroy() {
+        if (header_ != nullptr) {
+            // Tell attached readers to look for the new object
+            header_->closed.store(1, std::memory_order_release);
+            futex_wake_all(header_->futex);
+        }
+        if (base_ != nullptr) {
+            munmap(base_, size_);
+            shm_unlink(name_.c_str());
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = -1;
+        base_ = nullptr;
+        header_ = nullptr;
+        pending_ = nullptr;
+        size_ = 0;
+    }
+
+    uint8_t *ring_writer::begin_frame(const frame_format_t &format, uint64_t pts) {
+        if (header_ == nullptr || format.frame_size > header_->slot_capacity) {
+            if (!create(format.frame_size)) {
+                return nullptr;
+            }
+        }
+
+        uint64_t seq = seq_ + 1;
+        uint8_t *slot_base = base_ + header_area + (seq % slot_count_) * header_->slot_stride;
+        pending_ = reinterpret_cast<slot_header_t *>(slot_base);
+
+        pending_->seq.store(slot_busy, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        pending_->pts = pts;
+        pending_->size = format.frame_size;
+        pending_->format = format;
+        return slot_base + header_->data_offset;
+    }
+
+    void ring_writer::commit_frame() {
+        if (pending_ == nullptr) {
+            return;
+        }
+        seq_++;
+        pending_->seq.store(seq_, std::memory_order_release);
+        header_->write_seq.store(seq_, std::memory_order_release);
+        header_->futex.fetch_add(1, std::memory_order_release);
+        if (header_->waiters.load(std::memory_order_acquire) > 0) {
+            futex_wake_all(header_->futex);
+        }
+        pending_ = nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    ring_reader::~ring_reader() {
+        detach();
+    }
+
+    bool ring_reader::attach(const std::string &name) {
+        detach();
+
+        fd_ = shm_open(object_name(name).c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < header_area) {
+            detach();
+            return false;
+        }
+        size_ = st.st_size;
+
+        // Writable only for the waiters counter, frames are never written
+        void *base = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (base == MAP_FAILED) {
+            size_ = 0;
+            detach();
+            return false;
+        }
+        base_ = static_cast<uint8_t *>(base);
+
+        auto header = reinterpret_cast<ring_header_t *>(base_);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->magic != ring_magic || header->version != ring_version ||
+            header_area + static_cast<size_t>(header->slot_stride) * header->slot_count > size_) {
+            detach();
+            return false;
+        }
+        header_ = header;
+        return true;
+    }
+
+    void ring_reader::detach() {
+        if (base_ != nullptr) {
+            munmap(base_, size_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = -1;
+        base_ = nullptr;
+        header_ = nullptr;
+        size_ = 0;
+    }
+
+    bool ring_reader::stale() const {
+        return header_ == nullptr || header_->closed.load(std::memory_order_acquire) != 0;
+    }
+
+    uint64_t ring_reader::latest_seq() const {
+        return header_ != nullptr ? header_->write_seq.load(std::memory_order_acquire) : 0;
+    }
+
+    const slot_header_t *ring_reader::slot(uint64_t seq) const {
+        return reinterpret_cast<const slot_header_t *>(
+            base_ + header_area + (seq % header_->slot_count) * header_->slot_stride);
+    }
+
+    bool ring_reader::read(uint64_t seq, frame_view_t &view) const {
+        if (header_ == nullptr || seq == 0 || seq > latest_seq()) {
+            return false;
+        }
+
+        const slot_header_t *s = slot(seq);
+        if (s->seq.load(std::memory_order_acquire) != seq) {
+            return false;
+        }
+
+        view.seq = seq;
+        view.pts = s->pts;
+        view.format = &s->format;
+        view.size = s->size;
+        view.data = reinterpret_cast<const uint8_t *>(s) + header_->data_offset;
+        return valid(view);
+    }
+
+    bool ring_reader::valid(const frame_view_t &view) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot(view.seq)->seq.load(std::memory_order_relaxed) == view.seq;
+    }
+
+    bool ring_reader::wait_latest(uint64_t last_seq, int timeout_ms, frame_view_t &view) {
+        if (header_ == nullptr) {
+            return false;
+        }
+
+        bool waited = false;
+        while (!stale()) {
+            uint32_t futex = header_->futex.load(std::memory_order_acquire);
+            uint64_t seq = latest_seq();
+            if (seq > last_seq) {
+                if (read(seq, view)) {
+                    return true;
+                }
+                continue;           // Overwritten while we looked, take the next one
+            }
+            if (waited) {
+                return false;       // Timed out
+            }
+
+            header_->waiters.fetch_add(1, std::memory_order_acq_rel);
+            futex_wait(header_->futex, futex, timeout_ms);
+            header_->waiters.fetch_sub(1, std::memory_order_acq_rel);
+            waited = timeout_ms >= 0;
+        }
+        return false;
+    }
+
+};
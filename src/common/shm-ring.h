@@ -0,0 +1,165 @@
+/**
+ * @file    shm-ring.h
+ * @brief   Shared-memory ring of raw video frames for co-located consumers
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Layout of the POSIX shared memory object:
+ *
+ *   [ring_header_t, padded to 4 KiB][slot 0][slot 1]...[slot N-1]
+ *
+ * Each slot is a slot_header_t followed (64 byte aligned) by the frame bytes,
+ * laid out as described by the slot's format. The writer publishes frame n
+ * into slot n % slot_count using a per-slot sequence number as a seqlock, so
+ * readers map the object and read frames in place without any copy or lock.
+ */
+#ifndef __SHM_RING_H
+#define __SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace shm_ring {
+
+    static constexpr uint32_t ring_magic = 0x474E5253;     // "SRNG"
+    static constexpr uint16_t ring_version = 2;            // 2: no ring level format, read the slot's
+    static constexpr uint32_t max_planes = 4;
+    static constexpr uint64_t slot_busy = UINT64_MAX;       // Slot is being written
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock free");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock free");
+
+    /** @brief Raw frame description, plane strides and offsets are in bytes */
+    typedef struct {
+        char format[16];                        // GStreamer video format name, e.g. "BGR", "I420"
+        uint32_t width;
+        uint32_t height;
+        uint32_t n_planes;
+        uint32_t stride[max_planes];
+        uint32_t offset[max_planes];
+        uint32_t frame_size;
+        uint32_t stream_id;                     // Incoming stream the frame was decoded from
+    } frame_format_t;
+
+    typedef struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t header_size;
+        uint32_t slot_count;
+        uint32_t slot_stride;                   // Bytes from one slot header to the next
+        uint32_t slot_capacity;                 // Max frame bytes per slot
+        uint32_t data_offset;                   // Frame bytes start this far into a slot
+        uint32_t writer_pid;
+        std::atomic<uint32_t> closed;           // Set when the writer recreates or removes the ring
+        std::atomic<uint64_t> write_seq;        // Sequence of the latest complete frame, 0 = none
+        std::atomic<uint32_t> futex;            // Bumped for every frame, readers wait on it
+        std::atomic<uint32_t> waiters;
+    } ring_header_t;
+
+    typedef struct {
+        std::atomic<uint64_t> seq;              // Frame sequence, slot_busy while writing
+        uint64_t pts;                           // Nanoseconds, UINT64_MAX if unknown
+        uint32_t size;
+        uint32_t reserved;
+        frame_format_t format;
+    } slot_header_t;
+
+    /**
+     * @brief Creates (or replaces) the named shared memory object and publishes
+     *        frames into it. Single writer.
+     */
+    class ring_writer {
+    public:
+        ring_writer(const std::string &name, uint32_t slot_count);
+        ~ring_writer();
+
+        ring_writer(const ring_writer &) = delete;
+        ring_writer &operator=(const ring_writer &) = delete;
+
+        /**
+         * @brief Reserve the next slot for a frame of the given format. The
+         *        ring is (re)created when it does not exist yet or the frame
+         *        does not fit in a slot.
+         *
+         * @return where to write format.frame_size bytes, nullptr on error
+         */
+        uint8_t *begin_frame(const frame_format_t &format, uint64_t pts);
+
+        /** @brief Publish the frame started with begin_frame() */
+        void commit_frame();
+
+        uint64_t frames_written() const { return seq_; }
+        const std::string &name() const { return name_; }
+
+    private:
+        bool create(uint32_t slot_capacity);
+        void destroy();
+
+        std::string name_;
+        uint32_t slot_count_;
+        int fd_ = -1;
+        uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        ring_header_t *header_ = nullptr;
+        slot_header_t *pending_ = nullptr;
+        uint64_t seq_ = 0;
+    };
+
+    /** @brief Zero-copy view of one frame inside the ring */
+    typedef struct {
+        uint64_t seq;
+        uint64_t pts;
+        const frame_format_t *format;
+        const uint8_t *data;
+        uint32_t size;
+    } frame_view_t;
+
+    /**
+     * @brief Attaches to a ring created by ring_writer. Any number of readers
+     *        may attach; they never block the writer. A view stays readable
+     *        until the writer wraps around to its slot, check it with valid()
+     *        after use.
+     */
+    class ring_reader {
+    public:
+        ring_reader() = default;
+        ~ring_reader();
+
+        ring_reader(const ring_reader &) = delete;
+        ring_reader &operator=(const ring_reader &) = delete;
+
+        bool attach(const std::string &name);
+        void detach();
+        bool attached() const { return header_ != nullptr; }
+
+        /** @brief The writer replaced or removed the ring, attach() again */
+        bool stale() const;
+
+        /**
+         * @brief Wait up to timeout_ms (-1 forever) for a frame newer than
+         *        last_seq and return a view of the newest one
+         */
+        bool wait_latest(uint64_t last_seq, int timeout_ms, frame_view_t &view);
+
+        /** @brief View of frame seq, false if it was already overwritten */
+        bool read(uint64_t seq, frame_view_t &view) const;
+
+        /** @brief True while the frame behind view has not been overwritten */
+        bool valid(const frame_view_t &view) const;
+
+        uint64_t latest_seq() const;
+
+    private:
+        const slot_header_t *slot(uint64_t seq) const;
+
+        int fd_ = -1;
+        uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        ring_header_t *header_ = nullptr;
+    };
+
+};
+
+#endif // __SHM_RING_H
@@ -0,0 +1,408 @@
+/**
+ * @file    udp-frame.cpp
+ * @brief   Datagram framing of whole frames: MTU sized chunks and reassembly
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include "udp-frame.h"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace udp_frame {
+
+    static constexpr size_t max_batch = 64;         // Datagrams per sendmmsg()
+    static constexpr size_t max_gso_segments = 64;  // Kernel limit per GSO send
+
+    /* dst ^= src, a word at a time */
+    static void xor_into(uint8_t *dst, const uint8_t *src, size_t n) {
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+            uint64_t a, b;
+            memcpy(&a, dst + i, sizeof(a));
+            memcpy(&b, src + i, sizeof(b));
+            a ^= b;
+            memcpy(dst + i, &a, sizeof(a));
+        }
+        for (; i < n; i++) {
+            dst[i] ^= src[i];
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    sender::sender(int fd, const struct sockaddr_in &dest, size_t mtu, bool gso)
+        : fd_(fd), dest_(dest), gso_(gso) {
+        size_t datagram = std::min(mtu > ip_udp_overhead + sizeof(chunk_header_t) + 1 ? mtu - ip_udp_overhead : 576 - ip_udp_overhead,
+                                   max_datagram);
+        chunk_payload_ = datagram - sizeof(chunk_header_t);
+    }
+
+    void sender::build(uint32_t frame_id, const std::vector<struct iovec> &payload, size_t length) {
+        size_t count = std::max<size_t>(1, (length + chunk_payload_ - 1) / chunk_payload_);
+        size_t parity = 0;
+        if (fec_percent_ > 0) {
+            parity = std::min(count, std::max<size_t>(1, (count * fec_percent_ + 99) / 100));
+        }
+
+        // Headers first, iovecs point into this vector
+        headers_.resize(count + parity);
+        iov_.clear();
+        chunk_iov_.clear();
+        chunk_len_.clear();
+
+        size_t block = 0, block_offset = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t offset = i * chunk_payload_;
+            size_t left = std::min(chunk_payload_, length - offset);
+
+            chunk_header_t &h = headers_[i];
+            h.magic = chunk_magic;
+            h.version = chunk_version;
+            h.flags = parity > 0 ? flag_fec : 0;
+            h.frame_id = frame_id;
+            h.chunk_index = static_cast<uint16_t>(i);
+            h.chunk_count = static_cast<uint16_t>(count);
+            h.offset = static_cast<uint32_t>(offset);
+            h.frame_length = static_cast<uint32_t>(length);
+
+            chunk_iov_.push_back(iov_.size());
+            chunk_len_.push_back(sizeof(h) + left);
+            iov_.push_back({&h, sizeof(h)});
+            while (left > 0 && block < payload.size()) {
+                size_t n = std::min(left, payload[block].iov_len - block_offset);
+                iov_.push_back({static_cast<uint8_t *>(payload[block].iov_base) + block_offset, n});
+                left -= n;
+                block_offset += n;
+                if (block_offset == payload[block].iov_len) {
+                    block++;
+                    block_offset = 0;
+                }
+            }
+        }
+
+        if (parity > 0) {
+            build_parity(count, parity);
+        }
+        chunk_iov_.push_back(iov_.size());
+    }
+
+    void sender::build_parity(size_t data_chunks, size_t parity_chunks) {
+        if (parity_buffers_.size() < parity_chunks) {
+            parity_buffers_.resize(parity_chunks);
+        }
+        for (size_t p = 0; p < parity_chunks; p++) {
+            parity_buffers_[p].assign(chunk_payload_, 0);
+        }
+
+        // Short chunks are implicitly zero padded, they XOR fewer bytes
+        for (size_t j = 0; j < data_chunks; j++) {
+            uint8_t *dst = parity_buffers_[j % parity_chunks].data();
+            for (size_t v = chunk_iov_[j] + 1; v < (j + 1 < data_chunks ? chunk_iov_[j + 1] : iov_.size()); v++) {
+                xor_into(dst, static_cast<const uint8_t *>(iov_[v].iov_base), iov_[v].iov_len);
+                dst += iov_[v].iov_len;
+            }
+        }
+
+        for (size_t p = 0; p < parity_chunks; p++) {
+            chunk_header_t &h = headers_[data_chunks + p];
+            h = headers_[0];
+            h.flags = flag_fec | flag_parity;
+            h.chunk_index = static_cast<uint16_t>(p);
+            h.offset = static_cast<uint32_t>(parity_chunks);
+
+            chunk_iov_.push_back(iov_.size());
+            chunk_len_.push_back(sizeof(h) + chunk_payload_);
+            iov_.push_back({&h, sizeof(h)});
+            iov_.push_back({parity_buffers_[p].data(), chunk_payload_});
+        }
+        parity_ += parity_chunks;
+    }
+
+    bool sender::send(uint32_t frame_id, const std::vector<struct iovec> &payload, size_t length) {
+        // The chunk index is 16 bits wide
+        if (length > chunk_payload_ * UINT16_MAX) {
+            errors_++;
+            return false;
+        }
+        build(frame_id, payload, length);
+        return gso_ ? send_gso() : send_mmsg();
+    }
+
+    bool sender::send_mmsg() {
+        size_t chunks = chunk_iov_.size() - 1;
+        struct mmsghdr msgs[max_batch];
+
+        for (size_t first = 0; first < chunks; ) {
+            size_t batch = std::min(max_batch, chunks - first);
+            for (size_t i = 0; i < batch; i++) {
+                size_t c = first + i;
+                msgs[i] = {};
+                msgs[i].msg_hdr.msg_name = &dest_;
+                msgs[i].msg_hdr.msg_namelen = sizeof(dest_);
+                msgs[i].msg_hdr.msg_iov = &iov_[chunk_iov_[c]];
+                msgs[i].msg_hdr.msg_iovlen = chunk_iov_[c + 1] - chunk_iov_[c];
+            }
+
+            int sent = sendmmsg(fd_, msgs, batch, 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("sendmmsg");
+                errors_++;
+                return false;
+            }
+            datagrams_ += sent;
+            first += sent;
+        }
+        return true;
+    }
+
+    bool sender::send_gso() {
+        size_t chunks = chunk_iov_.size() - 1;
+        size_t segment = sizeof(chunk_header_t) + chunk_payload_;
+        size_t per_send = std::max<size_t>(1, std::min(max_gso_segments, max_datagram / segment));
+
+        for (size_t first = 0; first < chunks; ) {
+            // Every segment but the last must be full size, the kernel cuts
+            // the payload at segment boundaries and repeats the UDP header.
+            // A short chunk (end of the data, before the parity) ends a send
+            size_t n = 0;
+            while (n < per_send && first + n < chunks) {
+                n++;
+                if (chunk_len_[first + n - 1] != segment) {
+                    break;
+                }
+            }
+
+            char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+            struct msghdr msg = {};
+            msg.msg_name = &dest_;
+            msg.msg_namelen = sizeof(dest_);
+            msg.msg_iov = &iov_[chunk_iov_[first]];
+            msg.msg_iovlen = chunk_iov_[first + n] - chunk_iov_[first];
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gso_size = static_cast<uint16_t>(segment);
+            memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+
+            if (sendmsg(fd_, &msg, 0) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // No GSO in this kernel or on this route, batch the rest instead
+                std::cout << "UDP GSO not available (" << strerror(errno) << "), using sendmmsg" << std::endl;
+                gso_ = false;
+                chunk_iov_.erase(chunk_iov_.begin(), chunk_iov_.begin() + first);
+                chunk_len_.erase(chunk_len_.begin(), chunk_len_.begin() + first);
+                return send_mmsg();
+            }
+            datagrams_ += n;
+            first += n;
+        }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    reassembler::reassembler(size_t max_frame_size, uint32_t timeout_ms, size_t max_pending)
+        : max_frame_size_(max_frame_size), timeout_ms_(timeout_ms), max_pending_(max_pending > 0 ? max_pending : 1) {}
+
+    void reassembler::recycle(std::vector<uint8_t> &&buffer) {
+        if (spare_.size() <= max_pending_ && buffer.capacity() > 0) {
+            spare_.push_back(std::move(buffer));
+        }
+    }
+
+    bool reassembler::push(const uint8_t *datagram, size_t len, uint64_t now_ms, frame_t &frame) {
+        chunk_header_t h;
+        if (len < sizeof(h)) {
+            invalid_++;
+            return false;
+        }
+        memcpy(&h, datagram, sizeof(h));
+        const uint8_t *payload = datagram + sizeof(h);
+        size_t payload_len = len - sizeof(h);
+        bool is_parity = (h.flags & flag_parity) != 0;
+
+        if (h.magic != chunk_magic || h.version != chunk_version || h.chunk_count == 0 ||
+            h.frame_length > max_frame_size_) {
+            invalid_++;
+            return false;
+        }
+        if (is_parity) {
+            // offset is the number of parity groups, the payload one full chunk
+            if (h.offset == 0 || h.offset > h.chunk_count || h.chunk_index >= h.offset || payload_len == 0 ||
+                payload_len * h.chunk_count < h.frame_length ||
+                payload_len * (h.chunk_count - 1) >= std::max<size_t>(h.frame_length, 1)) {
+                invalid_++;
+                return false;
+            }
+        }
+        else if (h.chunk_index >= h.chunk_count || static_cast<size_t>(h.offset) + payload_len > h.frame_length) {
+            invalid_++;
+            return false;
+        }
+
+        auto it = pending_.find(h.frame_id);
+        if (it == pending_.end()) {
+            // A chunk of a frame that was already completed or given up on.
+            // Parity for a frame that completed without it is expected
+            if (any_completed_ && static_cast<int32_t>(h.frame_id - last_completed_) <= 0) {
+                if (!is_parity) {
+                    late_++;
+                }
+                return false;
+            }
+            if (pending_.size() >= max_pending_) {
+                auto oldest = std::min_element(pending_.begin(), pending_.end(),
+                    [](const std::pair<const uint32_t, pending_t> &a, const std::pair<const uint32_t, pending_t> &b) {
+                        return a.second.first_ms < b.second.first_ms;
+                    });
+                recycle(std::move(oldest->second.data));
+                pending_.erase(oldest);
+                timed_out_++;
+            }
+            pending_t p;
+            if (!spare_.empty()) {
+                p.data = std::move(spare_.back());
+                spare_.pop_back();
+            }
+            p.data.resize(h.frame_length);
+            p.received.assign(h.chunk_count, false);
+            p.missing = h.chunk_count;
+            p.first_ms = now_ms;
+            it = pending_.emplace(h.frame_id, std::move(p)).first;
+        }
+
+        pending_t &p = it->second;
+        if (p.data.size() != h.frame_length || p.received.size() != h.chunk_count) {
+            invalid_++;
+            return false;
+        }
+
+        size_t group;
+        if (is_parity) {
+            if (!add_parity(p, h, payload, payload_len)) {
+                return false;
+            }
+            group = h.chunk_index;
+        }
+        else {
+            if (p.received[h.chunk_index]) {
+                duplicate_++;
+                return false;
+            }
+            memcpy(p.data.data() + h.offset, payload, payload_len);
+            p.received[h.chunk_index] = true;
+            p.missing--;
+            group = p.parity.empty() ? 0 : h.chunk_index % p.parity.size();
+        }
+
+        if (p.missing > 0 && !p.parity.empty()) {
+            try_recover(p, group);
+        }
+        if (p.missing > 0) {
+            return false;
+        }
+        finish(it, frame);
+        return true;
+    }
+
+    bool reassembler::add_parity(pending_t &p, const chunk_header_t &h, const uint8_t *payload, size_t len) {
+        if (p.parity.empty()) {
+            p.chunk_size = len;
+            p.parity.resize(h.offset);
+            p.parity_received.assign(h.offset, false);
+        }
+        if (p.parity.size() != h.offset || p.chunk_size != len) {
+            invalid_++;
+            return false;
+        }
+        if (p.parity_received[h.chunk_index]) {
+            duplicate_++;
+            return false;
+        }
+        p.parity[h.chunk_index].assign(payload, payload + len);
+        p.parity_received[h.chunk_index] = true;
+        return true;
+    }
+
+    /* Rebuild the single missing data chunk of a group from its parity */
+    void reassembler::try_recover(pending_t &p, size_t group) {
+        size_t groups = p.parity.size();
+        size_t chunks = p.received.size();
+        if (!p.parity_received[group]) {
+            return;
+        }
+
+        size_t lost = chunks;
+        for (size_t j = group; j < chunks; j += groups) {
+            if (!p.received[j]) {
+                if (lost != chunks) {
+                    return;         // Two holes, XOR can't fix this group
+                }
+                lost = j;
+            }
+        }
+        if (lost == chunks) {
+            return;
+        }
+
+        std::vector<uint8_t> &chunk = p.parity[group];
+        for (size_t j = group; j < chunks; j += groups) {
+            if (j != lost) {
+                size_t offset = j * p.chunk_size;
+                xor_into(chunk.data(), p.data.data() + offset, std::min(p.chunk_size, p.data.size() - offset));
+            }
+        }
+        size_t offset = lost * p.chunk_size;
+        memcpy(p.data.data() + offset, chunk.data(), std::min(p.chunk_size, p.data.size() - offset));
+        p.received[lost] = true;
+        p.parity_received[group] = false;   // Used up
+        p.missing--;
+        recovered_++;
+    }
+
+    void reassembler::finish(std::unordered_map<uint32_t, pending_t>::iterator it, frame_t &frame) {
+        uint32_t frame_id = it->first;
+        recycle(std::move(done_));
+        done_ = std::move(it->second.data);
+        pending_.erase(it);
+        completed_++;
+        last_completed_ = frame_id;
+        any_completed_ = true;
+
+        frame.frame_id = frame_id;
+        frame.data = done_.data();
+        frame.length = done_.size();
+    }
+
+    void reassembler::expire(uint64_t now_ms) {
+        for (auto it = pending_.begin(); it != pending_.end(); ) {
+            if (now_ms - it->second.first_ms > timeout_ms_) {
+                recycle(std::move(it->second.data));
+                it = pending_.erase(it);
+                timed_out_++;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+};
@@ -0,0 +1,177 @@
+/**
+ * @file    udp-frame.h
+ * @brief   Datagram framing of whole frames: MTU sized chunks and reassembly
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * A frame of any size is cut into chunks that each fit one datagram below
+ * the path MTU, so IP fragmentation never happens and a frame is never
+ * limited to 64 KB. Every chunk carries enough to be placed on its own:
+ *
+ *   [chunk_header_t][payload bytes offset .. offset + n of frame frame_id]
+ *
+ * Chunks of one frame may arrive in any order; a frame whose chunks don't
+ * all arrive within the reassembly timeout is dropped as a whole.
+ *
+ * With FEC enabled the data chunks are followed by P parity chunks. Parity p
+ * is the XOR of every data chunk j with j % P == p (zero padded to the chunk
+ * size), so any loss that leaves at most one hole per group, e.g. a burst of
+ * up to P consecutive chunks, is repaired without a retransmission.
+ */
+#ifndef __UDP_FRAME_H
+#define __UDP_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+namespace udp_frame {
+
+    static constexpr uint16_t chunk_magic = 0x4647;         // "GF"
+    static constexpr uint8_t chunk_version = 1;
+    static constexpr size_t ip_udp_overhead = 28;           // IPv4 + UDP headers
+    static constexpr size_t max_datagram = 65507;
+
+    static constexpr uint8_t flag_fec = 0x01;               // Parity chunks follow the data
+    static constexpr uint8_t flag_parity = 0x02;            // This is a parity chunk
+
+    typedef struct {
+        uint16_t magic;
+        uint8_t version;
+        uint8_t flags;              // flag_fec, flag_parity
+        uint32_t frame_id;
+        uint16_t chunk_index;       // Parity chunks: parity group p
+        uint16_t chunk_count;       // Data chunks of the frame, parity not included
+        uint32_t offset;            // Of this chunk's payload in the frame. Parity chunks: P
+        uint32_t frame_length;
+    } chunk_header_t;
+
+    static_assert(sizeof(chunk_header_t) == 20, "chunk_header_t is part of the wire format");
+
+    /**
+     * @brief Sends frames to one destination. Chunks are batched with
+     *        sendmmsg(), or with UDP GSO when enabled and supported, in
+     *        which case the kernel cuts one large send into the datagrams.
+     *        Payload bytes are never copied, every chunk points into the
+     *        caller's iovecs.
+     */
+    class sender {
+    public:
+        sender(int fd, const struct sockaddr_in &dest, size_t mtu, bool gso);
+
+        /**
+         * @brief Add ceil(data chunks * overhead_percent / 100) parity chunks
+         *        to every frame, 0 disables FEC
+         */
+        void set_fec(unsigned overhead_percent) { fec_percent_ = overhead_percent; }
+
+        sender(const sender &) = delete;
+        sender &operator=(const sender &) = delete;
+
+        /** @brief Send one frame made of the given payload blocks */
+        bool send(uint32_t frame_id, const std::vector<struct iovec> &payload, size_t length);
+
+        size_t chunk_payload() const { return chunk_payload_; }
+        bool gso() const { return gso_; }
+        unsigned fec() const { return fec_percent_; }
+
+        uint64_t datagrams_sent() const { return datagrams_; }
+        uint64_t parity_sent() const { return parity_; }
+        uint64_t send_errors() const { return errors_; }
+
+    private:
+        /** @brief One chunk: its header, then slices of the payload blocks */
+        void build(uint32_t frame_id, const std::vector<struct iovec> &payload, size_t length);
+        void build_parity(size_t data_chunks, size_t parity_chunks);
+        bool send_mmsg();
+        bool send_gso();
+
+        int fd_;
+        struct sockaddr_in dest_;
+        size_t chunk_payload_;
+        bool gso_;
+        unsigned fec_percent_ = 0;
+
+        // Reused between frames so steady state sends don't allocate
+        std::vector<chunk_header_t> headers_;
+        std::vector<struct iovec> iov_;
+        std::vector<size_t> chunk_iov_;     // First iov of every chunk, plus one past the end
+        std::vector<size_t> chunk_len_;     // Datagram bytes of every chunk
+        std::vector<std::vector<uint8_t>> parity_buffers_;
+
+        uint64_t datagrams_ = 0;
+        uint64_t parity_ = 0;
+        uint64_t errors_ = 0;
+    };
+
+    /** @brief A reassembled frame, valid until the next push() */
+    typedef struct {
+        uint32_t frame_id;
+        const uint8_t *data;
+        size_t length;
+    } frame_t;
+
+    /**
+     * @brief Collects chunks per frame id into a buffer of the full frame
+     *        length and hands out the frame when its last chunk lands.
+     */
+    class reassembler {
+    public:
+        reassembler(size_t max_frame_size, uint32_t timeout_ms, size_t max_pending);
+
+        /**
+         * @brief Add one datagram received at now_ms
+         *
+         * @return true when it completed a frame, which is then in frame
+         */
+        bool push(const uint8_t *datagram, size_t len, uint64_t now_ms, frame_t &frame);
+
+        /** @brief Drop frames that waited more than the timeout for chunks */
+        void expire(uint64_t now_ms);
+
+        uint64_t frames_completed() const { return completed_; }
+        uint64_t frames_timed_out() const { return timed_out_; }
+        uint64_t chunks_invalid() const { return invalid_; }
+        uint64_t chunks_duplicate() const { return duplicate_; }
+        uint64_t chunks_late() const { return late_; }
+        uint64_t chunks_recovered() const { return recovered_; }
+
+    private:
+        struct pending_t {
+            std::vector<uint8_t> data;
+            std::vector<bool> received;
+            uint16_t missing;
+            uint64_t first_ms;
+            size_t chunk_size = 0;              // Known once a parity chunk arrived
+            std::vector<std::vector<uint8_t>> parity;
+            std::vector<bool> parity_received;
+        };
+
+        void recycle(std::vector<uint8_t> &&buffer);
+        bool add_parity(pending_t &p, const chunk_header_t &h, const uint8_t *payload, size_t len);
+        void try_recover(pending_t &p, size_t group);
+        void finish(std::unordered_map<uint32_t, pending_t>::iterator it, frame_t &frame);
+
+        size_t max_frame_size_;
+        uint32_t timeout_ms_;
+        size_t max_pending_;
+        std::unordered_map<uint32_t, pending_t> pending_;
+        std::vector<uint8_t> done_;         // Data of the last completed frame
+        std::vector<std::vector<uint8_t>> spare_; // Frame buffers kept for reuse
+        uint32_t last_completed_ = 0;
+        bool any_completed_ = false;
+
+        uint64_t completed_ = 0;
+        uint64_t timed_out_ = 0;
+        uint64_t invalid_ = 0;
+        uint64_t duplicate_ = 0;
+        uint64_t late_ = 0;
+        uint64_t recovered_ = 0;
+    };
+
+};
+
+#endif // __UDP_FRAME_H
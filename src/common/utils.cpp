@@ -9,12 +9,12 @@
 
 #include <string>
 #include <stdint.h>
+#include <cstdlib>
 #include <arpa/inet.h>
 
-namespace utils {
+#include "utils.h"
 
-    static constexpr uint16_t port_range_min = 0;
-    static constexpr uint16_t port_range_max = 65535;
+namespace utils {
 
     /**
      * @brief validate ip ipv4 format
@@ -43,4 +43,67 @@ namespace utils {
         return ((p > port_range_min) && (p < port_range_max));
     }
 
+    /**
+     * @brief Read an unsigned numeric setting from the environment
+     * 
+     * @param name environment var name
+     * @param default_value returned when the var is unset or not a number
+     * @return unsigned long 
+     */
+    unsigned long get_env_ulong(const char *name, unsigned long default_value) {
+        auto str = std::getenv(name);
+        if (str == nullptr || *str == '\0') {
+            return default_value;
+        }
+
+        char *end = nullptr;
+        auto value = std::strtoul(str, &end, 10);
+        if (end == str || *end != '\0') {
+            return default_value;
+        }
+        return value;
+    }
+
+    /**
+     * @brief Parse a comma separated list of ports and port ranges,
+     *        e.g. "5000,5002-5005"
+     * 
+     * @param list text to parse
+     * @param ports filled with every port, in order
+     * @return false if an entry is not a valid port or range
+     */
+    bool parse_port_list(const std::string &list, std::vector<uint16_t> &ports) {
+        ports.clear();
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            std::string entry = list.substr(start, end - start);
+            start = end + 1;
+
+            char *next = nullptr;
+            auto first = std::strtoul(entry.c_str(), &next, 10);
+            auto last = first;
+            if (next == entry.c_str()) {
+                return false;
+            }
+            if (*next == '-') {
+                const char *range_end = next + 1;
+                last = std::strtoul(range_end, &next, 10);
+                if (next == range_end) {
+                    return false;
+                }
+            }
+            if (*next != '\0' || first > last || last > port_range_max || !validate_port(first) || !validate_port(last)) {
+                return false;
+            }
+            for (auto port = first; port <= last; port++) {
+                ports.push_back(static_cast<uint16_t>(port));
+            }
+        }
+        return !ports.empty();
+    }
+
 };
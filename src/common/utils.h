@@ -9,6 +9,7 @@
 #define __UTILS_H
 
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 #define IS_VALID            true
@@ -22,6 +23,9 @@ namespace utils {
     bool validate_ip(std::string ip);
     bool validate_port(uint16_t p);
 
+    unsigned long get_env_ulong(const char *name, unsigned long default_value);
+    bool parse_port_list(const std::string &list, std::vector<uint16_t> &ports);
+
 };
 
 #define ASSERT_ELEMENT(gstelmnt, name)                          \
@@ -10,18 +10,48 @@
 #include <iostream>
 #include <string>
 #include <gst/gst.h>
+#include <gio/gio.h>
 #include <utils.h>
+#include <gst-profiler.h>
+#include <startup.h>
+#include <rtcp-config.h>
+#include "sender-profile.h"
+#include "rate-control.h"
+
+#define SENDER_PROFILE    "low-latency" //Default, override with GST_LOCAL_PROFILE
+#define RTCP_LOCAL_PORT   0             //Default, override with GST_LOCAL_RTCP_PORT (0 = any free port)
+#define ADAPTIVE_BITRATE  1             //Default, override with GST_LOCAL_ADAPTIVE (0 = fixed bitrate)
+#define LOCAL_SOURCE      "test"        //Default, override with GST_LOCAL_SOURCE (test, file, /dev/videoN or URI)
+#define PASSTHROUGH       1             //Default, override with GST_LOCAL_PASSTHROUGH (0 = always re-encode)
+#define RTSP_LATENCY_MS   100           //Default, override with GST_LOCAL_RTSP_LATENCY
+#define TRACE_SECONDS     10            //Default, override with GST_LOCAL_TRACE_SECONDS (0 = until exit)
+#define REGISTRY_CACHE    "/var/cache/gstreamer/registry.bin" //Fast start registry, unless GST_REGISTRY is set
+#define PREROLL_TIMEOUT   (5 * GST_SECOND) //A file that doesn't preroll by then is started anyway
 
 typedef struct {
   GstElement *pipeline;
-  GstElement *source;
+  GstElement *source;               //videotestsrc or urisourcebin
+  GstElement *source_caps;          //GST_LOCAL_SOURCE_CAPS, e.g. to ask a camera for H.264
+  GstElement *parse;                //parsebin, tells H.264 input from everything else
   GstElement *sink;
-  GstElement *deco;
+  GstElement *deco;                 //Only for input that is not H.264
+  GstElement *h264parse;            //Passthrough: the input goes to rtph264pay as it is
+  GstElement *rate;                 //videorate, caps the frame rate when the bitrate can't go lower
   GstElement *h264enc;
   GstElement *rtp_enc;
+  GstElement *session;              //rtpsession, sends our sender reports and takes the receiver's
+  GstElement *rtcp_src;
+  GstElement *rtcp_sink;
+  GstElement *sync_sink;            //Sender reports of the far end, unused
+  local::rate_controller *control;
+  bool passthrough;                 //Send H.264 input without decoding it
+  bool linked;                      //A video stream was picked, later ones are ignored
 } pipeline_t;
 
 static void cb_pad_added_handler (GstElement *src, GstPad *new_pad, pipeline_t *data);
+static void cb_source_pad (GstElement *src, GstPad *new_pad, pipeline_t *data);
+static void cb_stream_pad (GstElement *src, GstPad *new_pad, pipeline_t *data);
+static void cb_source_setup (GstElement *bin, GstElement *source, gpointer user_data);
 
 /**
  * @brief main app
@@ -34,7 +64,7 @@ static void cb_pad_added_handler (GstElement *src, GstPad *new_pad, pipeline_t *
 int main (int argc, char *argv[])
 {
 
-  pipeline_t p;
+  pipeline_t p = {};
   GstBus *bus;
   GstMessage *msg;
   GstStateChangeReturn ret;
@@ -67,50 +97,245 @@ int main (int argc, char *argv[])
     exit(EXIT_FAILURE);
   }
 
+  std::string profile_name{SENDER_PROFILE};
+  auto profile_str = std::getenv("GST_LOCAL_PROFILE");
+  if (profile_str != nullptr) {
+    profile_name = profile_str;
+  }
+  auto found = local::find_profile(profile_name);
+  if (found == NULL) {
+    std::cout << "Not valid GST_LOCAL_PROFILE (" << local::profile_names() << "). Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  //Bitrate and keyframe interval depend on the camera and link, allow them per sender
+  local::sender_profile_t profile = *found;
+  profile.bitrate = utils::get_env_ulong("GST_LOCAL_BITRATE", profile.bitrate);
+  profile.key_int_max = utils::get_env_ulong("GST_LOCAL_KEY_INT", profile.key_int_max);
+  std::cout << "Profile: " << profile.name << ", " << profile.bitrate << " kbit/s, keyframe every "
+            << profile.key_int_max << " frames" << std::endl;
+
+  gint rtcp_port = port + 1;
+  if(rtcp_port > utils::port_range_max) {
+    std::cout << "Not valid port, RTCP goes to port + 1. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  unsigned long rtcp_local_port = utils::get_env_ulong("GST_LOCAL_RTCP_PORT", RTCP_LOCAL_PORT);
+  if (rtcp_local_port > utils::port_range_max) {
+    std::cout << "Not valid GST_LOCAL_RTCP_PORT. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  bool adaptive = utils::get_env_ulong("GST_LOCAL_ADAPTIVE", ADAPTIVE_BITRATE) != 0;
+  p.passthrough = utils::get_env_ulong("GST_LOCAL_PASSTHROUGH", PASSTHROUGH) != 0;
+  std::string source_uri{LOCAL_SOURCE};
+  auto source_str = std::getenv("GST_LOCAL_SOURCE");
+  if (source_str != nullptr) {
+    source_uri = source_str;
+  }
+
+  //GST_LOCAL_FAST_START=1 trusts the registry cache as is, rebuild the
+  //cache (or the image) when plugins are installed or updated
+  bool fast_start = utils::get_env_ulong("GST_LOCAL_FAST_START", 0) != 0;
+  if (fast_start) {
+    startup::use_registry_cache(REGISTRY_CACHE);
+  }
+
   /* Initialize GStreamer */
   gst_init (&argc, &argv);
+  startup::mark("gst_init");
+
+  //GST_LOCAL_TRACE=<file.json> profiles every element for a while
+  auto trace_str = std::getenv("GST_LOCAL_TRACE");
+  if (trace_str != nullptr && trace_str[0] != '\0') {
+    gst_profiler::start(trace_str, utils::get_env_ulong("GST_LOCAL_TRACE_SECONDS", TRACE_SECONDS));
+  }
+
+  if (fast_start) {
+    //parsebin and decodebin pick their parsers and decoders only once the
+    //input is known, load the likely ones now instead of on the first buffer
+    std::vector<std::string> factories = {"capsfilter", "parsebin", "decodebin", "h264parse", "videorate", "x264enc",
+                                          "rtph264pay", "rtpsession", "udpsink", "udpsrc", "fakesink", "typefind"};
+    if (source_uri == "test") {
+      factories.push_back("videotestsrc");
+    }
+    else {
+      factories.insert(factories.end(), {"urisourcebin", "avdec_h264", "videoconvert"});
+    }
+    for (auto &missing : startup::preload(factories)) {
+      std::cout << "[Startup] element " << missing << " not found" << std::endl;
+    }
+    startup::mark("plugins loaded");
+  }
 
   /* Create the elements */
-  p.source = gst_element_factory_make ("videotestsrc", "source");
+  if (source_uri == "test") {
+    p.source = gst_element_factory_make ("videotestsrc", "source");
+  }
+  else {
+    //urisourcebin picks filesrc, v4l2src or rtspsrc from the URI; plain paths are files
+    if (g_str_has_prefix (source_uri.c_str(), "/dev/video")) {
+      source_uri = "v4l2://" + source_uri;
+    }
+    else if (!gst_uri_is_valid (source_uri.c_str())) {
+      gchar *uri = gst_filename_to_uri (source_uri.c_str(), NULL);
+      if (uri == NULL) {
+        std::cout << "Not valid GST_LOCAL_SOURCE. Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      source_uri = uri;
+      g_free (uri);
+    }
+    p.source = gst_element_factory_make ("urisourcebin", "source");
+  }
+  std::cout << "Source: " << source_uri << (p.passthrough ? ", H.264 input is sent as it is" : "") << std::endl;
+  p.source_caps = gst_element_factory_make("capsfilter", "source_caps");
+  p.parse = gst_element_factory_make("parsebin", "parse");
   p.deco = gst_element_factory_make("decodebin", "deco");
+  p.h264parse = gst_element_factory_make("h264parse", "h264parse");
+  p.rate = gst_element_factory_make("videorate", "rate");
   p.h264enc = gst_element_factory_make("x264enc", "enc");
   p.rtp_enc = gst_element_factory_make("rtph264pay", "rtp_enc");
+  p.session = gst_element_factory_make("rtpsession", "session");
   p.sink = gst_element_factory_make("udpsink", "sink");
+  p.rtcp_src = gst_element_factory_make("udpsrc", "rtcp_src");
+  p.rtcp_sink = gst_element_factory_make("udpsink", "rtcp_sink");
+  p.sync_sink = gst_element_factory_make("fakesink", "sync_sink");
 
 
   /* Create the empty pipeline */
   p.pipeline = gst_pipeline_new ("test-pipeline");
 
-  if (!p.pipeline || !p.source || !p.deco || !p.h264enc || !p.rtp_enc || !p.sink) {
+  if (!p.pipeline || !p.source || !p.source_caps || !p.parse || !p.deco || !p.h264parse || !p.rate || !p.h264enc ||
+      !p.rtp_enc || !p.session || !p.sink || !p.rtcp_src || !p.rtcp_sink || !p.sync_sink) {
     g_printerr ("Not all elements could be created.\n");
     return -1;
   }
 
   /* Build the pipeline */
-  gst_bin_add_many (GST_BIN (p.pipeline), p.source, p.deco, p.h264enc, p.rtp_enc, p.sink, NULL);
+  /*
+  source ! capsfilter ! parsebin ! decodebin ! videorate ! x264enc ! rtph264pay ! rtpsession ! udpsink port=PORT
+                                 ! h264parse (H.264 input) ----------^
+                          udpsrc (RTCP socket) ! rtpsession ! udpsink (RTCP socket) port=PORT+1
+  */
+  gst_bin_add_many (GST_BIN (p.pipeline), p.source, p.source_caps, p.parse, p.deco, p.h264parse, p.rate, p.h264enc,
+                    p.rtp_enc, p.session, p.sink, p.rtcp_src, p.rtcp_sink, p.sync_sink, NULL);
   
-  if (gst_element_link_many (p.source, p.deco, NULL) != TRUE) {
+  if (gst_element_link_many (p.source_caps, p.parse, NULL) != TRUE ||
+      (source_uri == "test" && gst_element_link (p.source, p.source_caps) != TRUE)) {
     g_printerr ("Elements could not be linked.\n");
     gst_object_unref (p.pipeline);
     return -1;
   }
 
-  if (gst_element_link_many (p.h264enc, p.rtp_enc, p.sink, NULL) != TRUE) {
+  //rtph264pay is linked once the input shows whether the encoder is needed
+  if (gst_element_link_many (p.rate, p.h264enc, NULL) != TRUE ||
+      gst_element_link_pads (p.rtp_enc, "src", p.session, "send_rtp_sink") != TRUE ||
+      gst_element_link_pads (p.session, "send_rtp_src", p.sink, "sink") != TRUE) {
     g_printerr ("Elements could not be linked.\n");
     gst_object_unref (p.pipeline);
     return -1;
   }
 
+  if (gst_element_link_pads (p.rtcp_src, "src", p.session, "recv_rtcp_sink") != TRUE ||
+      gst_element_link_pads (p.session, "sync_src", p.sync_sink, "sink") != TRUE ||
+      gst_element_link_pads (p.session, "send_rtcp_src", p.rtcp_sink, "sink") != TRUE) {
+    g_printerr ("RTCP elements could not be linked.\n");
+    gst_object_unref (p.pipeline);
+    return -1;
+  }
+
+  /* One socket sends our RTCP and receives the reports, which the remote sends back to where ours came from */
+  GError *error = NULL;
+  GSocket *rtcp_socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+  if (rtcp_socket != NULL) {
+    GInetAddress *any = g_inet_address_new_any (G_SOCKET_FAMILY_IPV4);
+    GSocketAddress *bind_address = g_inet_socket_address_new (any, static_cast<guint16>(rtcp_local_port));
+    g_socket_bind (rtcp_socket, bind_address, TRUE, &error);
+    g_object_unref (bind_address);
+    g_object_unref (any);
+  }
+  if (error != NULL) {
+    g_printerr ("RTCP socket could not be opened: %s\n", error->message);
+    g_clear_error (&error);
+    gst_object_unref (p.pipeline);
+    return -1;
+  }
+  GstCaps *rtcp_caps = gst_caps_new_empty_simple ("application/x-rtcp");
+  g_object_set (p.rtcp_src, "socket", rtcp_socket, "caps", rtcp_caps, NULL);
+  gst_caps_unref (rtcp_caps);
+  g_object_set (p.rtcp_sink, "socket", rtcp_socket, "close-socket", FALSE,
+      "host", remote_ip.c_str(), "port", rtcp_port,
+      "sync", FALSE, "async", FALSE, NULL);
+  g_object_unref (rtcp_socket);
+  g_object_set (p.sync_sink, "sync", FALSE, "async", FALSE, NULL);
+  g_object_set (p.session, "rtcp-min-interval", static_cast<guint64>(RTCP_MIN_INTERVAL), NULL);
+
+  /* Never duplicate frames, only drop them once a cap is set */
+  g_object_set (p.rate, "drop-only", TRUE, NULL);
+  p.control = new local::rate_controller(p.h264enc, p.rate, profile.bitrate, adaptive);
+  if (!p.control->attach(p.sink, p.rtcp_src)) {
+    g_printerr ("Rate control could not be attached.\n");
+    gst_object_unref (p.pipeline);
+    return -1;
+  }
+  //PLI/FIR from the receiver force an IDR instead of waiting for the keyframe interval
+  p.control->honor_keyframe_requests(p.rtp_enc);
+  std::cout << "RTCP to port " << rtcp_port << ", bitrate " << (adaptive ? "adapts to the receiver reports" : "fixed")
+            << std::endl;
+
+  local::apply_profile(profile, p.h264enc, p.rtp_enc, p.sink);
+
   /* Modify the source's properties */
-  g_object_set (p.source, "pattern", 1, NULL);
+  if (source_uri == "test") {
+    g_object_set (p.source, "pattern", 1, NULL);
+  }
+  else {
+    g_object_set (p.source, "uri", source_uri.c_str(), NULL);
+    g_signal_connect (p.source, "pad-added", G_CALLBACK (cb_source_pad), &p);
+    g_signal_connect (p.source, "source-setup", G_CALLBACK (cb_source_setup), NULL);
+  }
+  auto source_caps_str = std::getenv("GST_LOCAL_SOURCE_CAPS");
+  if (source_caps_str != nullptr) {
+    GstCaps *source_caps = gst_caps_from_string (source_caps_str);
+    if (source_caps == NULL) {
+      std::cout << "Not valid GST_LOCAL_SOURCE_CAPS. Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    g_object_set (p.source_caps, "caps", source_caps, NULL);
+    gst_caps_unref (source_caps);
+  }
+  //Cameras repeat SPS/PPS rarely, the receiver may join at any time
+  g_object_set (p.h264parse, "config-interval", -1, NULL);
   
   /* Set udpsink ip and port */
   g_object_set (p.sink, "host", remote_ip.c_str(), NULL);
   g_object_set (p.sink, "port", static_cast<gint>(port), NULL);
 
 /* Connect to the pad-added signal */
+  g_signal_connect (p.parse, "pad-added", G_CALLBACK (cb_stream_pad), &p);
   g_signal_connect (p.deco, "pad-added", G_CALLBACK (cb_pad_added_handler), &p);
 
+  startup::mark_first_buffer(p.source_caps, "src", "first packet");
+  startup::mark_first_buffer(p.rate, "sink", "first decoded frame");
+  startup::mark_first_buffer(p.sink, "sink", "first frame sent");
+  startup::mark("pipeline built");
+
+  //Prerolling opens the source, finds the stream and links the branch before
+  //the clock runs, so the first frame leaves right after PLAYING. A live
+  //element returns NO_PREROLL instead, and the RTCP udpsrc always is one, so
+  //then PAUSED only starts the source threads and nothing is waited for.
+  if (fast_start) {
+    ret = gst_element_set_state (p.pipeline, GST_STATE_PAUSED);
+    if (ret == GST_STATE_CHANGE_ASYNC) {
+      ret = gst_element_get_state (p.pipeline, NULL, NULL, PREROLL_TIMEOUT);
+    }
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+      g_printerr ("Unable to set the pipeline to the paused state.\n");
+      gst_object_unref (p.pipeline);
+      return -1;
+    }
+    startup::mark(ret == GST_STATE_CHANGE_NO_PREROLL ? "paused, live: not prerolled" : "prerolled");
+  }
+
   /* Start playing */
   ret = gst_element_set_state (p.pipeline, GST_STATE_PLAYING);
   if (ret == GST_STATE_CHANGE_FAILURE) {
@@ -118,6 +343,7 @@ int main (int argc, char *argv[])
     gst_object_unref (p.pipeline);
     return -1;
   }
+  startup::mark("playing");
 
   /* Wait until error or EOS */
   bus = gst_element_get_bus (p.pipeline);
@@ -151,6 +377,8 @@ int main (int argc, char *argv[])
     gst_message_unref (msg);
   }
 
+  gst_profiler::finish();
+
   /* Free rep.sources */
   gst_object_unref (bus);
   gst_element_set_state (p.pipeline, GST_STATE_NULL);
@@ -161,7 +389,7 @@ int main (int argc, char *argv[])
 /* This function will be called by the pad-added signal */
 static void cb_pad_added_handler (GstElement *src, GstPad *new_pad, pipeline_t *data) {
   GstPad *sink_pad = NULL;
-  GstPad *videosink_pad = gst_element_get_static_pad (data->h264enc, "sink");
+  GstPad *videosink_pad = gst_element_get_static_pad (data->rate, "sink");
 
   GstPadLinkReturn ret;
   GstCaps *new_pad_caps = NULL;
@@ -188,6 +416,10 @@ static void cb_pad_added_handler (GstElement *src, GstPad *new_pad, pipeline_t *
   new_pad_type = gst_structure_get_name (new_pad_struct);
   if (g_str_has_prefix (new_pad_type, "video/x-raw")) {
     sink_pad = videosink_pad;
+    gint fps_n = 0, fps_d = 0;
+    if (gst_structure_get_fraction (new_pad_struct, "framerate", &fps_n, &fps_d) && fps_n > 0 && fps_d > 0) {
+      data->control->set_source_fps ((fps_n + fps_d - 1) / fps_d);
+    }
   }
   else {
     g_print ("It has type '%s' which is not raw video. Ignoring.\n", new_pad_type);
@@ -209,4 +441,53 @@ static void cb_pad_added_handler (GstElement *src, GstPad *new_pad, pipeline_t *
 
   if (new_pad_caps != NULL) gst_caps_unref (new_pad_caps);
   if (videosink_pad != NULL) gst_object_unref (videosink_pad);
-}
\ No newline at end of file
+}
+
+/* urisourcebin has the source's output, usually one pad (rtspsrc: one per RTSP stream) */
+static void cb_source_pad (GstElement *, GstPad *new_pad, pipeline_t *data) {
+  GstPad *sink_pad = gst_element_get_static_pad (data->source_caps, "sink");
+  if (!gst_pad_is_linked (sink_pad) && GST_PAD_LINK_FAILED (gst_pad_link (new_pad, sink_pad))) {
+    g_print ("Source pad '%s' could not be linked.\n", GST_PAD_NAME (new_pad));
+  }
+  gst_object_unref (sink_pad);
+}
+
+/* rtspsrc buffers 2 s by default, far too much for live video */
+static void cb_source_setup (GstElement *, GstElement *source, gpointer) {
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (source), "latency") != NULL) {
+    guint latency = utils::get_env_ulong("GST_LOCAL_RTSP_LATENCY", RTSP_LATENCY_MS);
+    g_object_set (source, "latency", latency, NULL);
+  }
+}
+
+/* parsebin found an elementary stream: H.264 skips the encoder, anything else is decoded */
+static void cb_stream_pad (GstElement *, GstPad *new_pad, pipeline_t *data) {
+  GstCaps *caps = gst_pad_get_current_caps (new_pad);
+  if (caps == NULL) {
+    caps = gst_pad_query_caps (new_pad, NULL);
+  }
+  const gchar *type = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  if (data->linked || !g_str_has_prefix (type, "video/")) {
+    g_print ("Ignoring stream of type '%s'.\n", type);
+    gst_caps_unref (caps);
+    return;
+  }
+
+  bool passthrough = data->passthrough && g_str_has_prefix (type, "video/x-h264");
+  GstElement *next = passthrough ? data->h264parse : data->deco;
+  GstPad *sink_pad = gst_element_get_static_pad (next, "sink");
+  if (GST_PAD_LINK_FAILED (gst_pad_link (new_pad, sink_pad)) ||
+      gst_element_link (passthrough ? data->h264parse : data->h264enc, data->rtp_enc) != TRUE) {
+    g_print ("Type is '%s' but link failed.\n", type);
+  }
+  else {
+    data->linked = true;
+    if (passthrough) {
+      //The bitrate is the camera's now, the reports are only logged
+      data->control->set_adaptive (false);
+    }
+    g_print ("Input is '%s', %s.\n", type, passthrough ? "sent without re-encoding" : "decoded and encoded");
+  }
+  gst_object_unref (sink_pad);
+  gst_caps_unref (caps);
+}
@@ -0,0 +1,234 @@
+/**
+ * @file    rate-control.cpp
+ * @brief   Adapts the sender's bitrate and frame rate to RTCP receiver reports
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+#include <gst/video/video.h>
+
+#include "rate-control.h"
+
+#define LOSS_HIGH           0.10    // Cut the bitrate above this loss
+#define LOSS_LOW            0.02    // Raise it below this one
+#define JITTER_LIMIT_MS     30.0    // Growing queues show up as jitter before loss, don't raise above it
+#define INCREASE            0.08    // Share of the bitrate added per good report
+#define INCREASE_MIN        50      // kbit/s
+#define MIN_BITRATE         200     // kbit/s, lowest floor whatever the profile
+#define MIN_FPS             5
+#define RTP_CLOCK_RATE      90000   // H.264
+#define KEYFRAME_INTERVAL   std::chrono::milliseconds(250) // Requests closer together get one IDR
+
+namespace local {
+
+    rate_controller::rate_controller(GstElement *h264enc, GstElement *videorate, guint max_bitrate, bool adapt)
+        : h264enc_(h264enc), videorate_(videorate), adapt_(adapt), max_bitrate_(max_bitrate),
+          min_bitrate_(std::min(max_bitrate, std::max<guint>(MIN_BITRATE, max_bitrate / 8))),
+          bitrate_(max_bitrate) {
+    }
+
+    bool rate_controller::attach(GstElement *rtp_sink, GstElement *rtcp_src) {
+        GstPad *sent = gst_element_get_static_pad(rtp_sink, "sink");
+        GstPad *reports = gst_element_get_static_pad(rtcp_src, "src");
+        if (sent == NULL || reports == NULL) {
+            return false;
+        }
+        gst_pad_add_probe(sent, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                          cb_sent, this, NULL);
+        gst_pad_add_probe(reports, GST_PAD_PROBE_TYPE_BUFFER, cb_rtcp, this, NULL);
+        gst_object_unref(sent);
+        gst_object_unref(reports);
+        return true;
+    }
+
+    void rate_controller::honor_keyframe_requests(GstElement *payloader) {
+        payloader_sink_ = gst_element_get_static_pad(payloader, "sink");
+    }
+
+    gboolean rate_controller::packet_sent(GstBuffer **buffer, guint, gpointer user_data) {
+        auto self = static_cast<rate_controller *>(user_data);
+        self->bytes_sent_.fetch_add(gst_buffer_get_size(*buffer), std::memory_order_relaxed);
+        self->packets_sent_.fetch_add(1, std::memory_order_relaxed);
+
+        // Reports carry a block per SSRC the receiver sees, ours is random
+        if (!self->have_ssrc_.load(std::memory_order_relaxed)) {
+            GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+            if (gst_rtp_buffer_map(*buffer, GST_MAP_READ, &rtp)) {
+                self->ssrc_.store(gst_rtp_buffer_get_ssrc(&rtp), std::memory_order_relaxed);
+                self->have_ssrc_.store(true, std::memory_order_release);
+                gst_rtp_buffer_unmap(&rtp);
+            }
+        }
+        return TRUE;
+    }
+
+    /* PLI names the media SSRC in the header, FIR in one FCI entry per SSRC */
+    bool rate_controller::is_keyframe_request(GstRTCPPacket *packet, uint32_t own_ssrc) {
+        GstRTCPFBType type = gst_rtcp_packet_fb_get_type(packet);
+        if (type == GST_RTCP_PSFB_TYPE_PLI) {
+            return gst_rtcp_packet_fb_get_media_ssrc(packet) == own_ssrc;
+        }
+        if (type == GST_RTCP_PSFB_TYPE_FIR) {
+            const guint8 *fci = gst_rtcp_packet_fb_get_fci(packet);
+            const guint words = gst_rtcp_packet_fb_get_fci_length(packet);
+            for (guint i = 0; fci != NULL && i + 2 <= words; i += 2) {
+                if (GST_READ_UINT32_BE(fci + i * 4) == own_ssrc) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /* Payloaded packets, one or a list of them */
+    GstPadProbeReturn rate_controller::cb_sent(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+            gst_buffer_list_foreach(gst_pad_probe_info_get_buffer_list(info), packet_sent, user_data);
+        }
+        else {
+            GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+            packet_sent(&buffer, 0, user_data);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    /* A compound RTCP packet from the receiver: the report block about us, and
+       maybe a keyframe request */
+    GstPadProbeReturn rate_controller::cb_rtcp(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<rate_controller *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+        if (!self->have_ssrc_.load(std::memory_order_acquire) || buffer == NULL ||
+            !gst_rtcp_buffer_map(buffer, GST_MAP_READ, &rtcp)) {
+            return GST_PAD_PROBE_OK;
+        }
+
+        const uint32_t own_ssrc = self->ssrc_.load(std::memory_order_relaxed);
+        GstRTCPPacket packet;
+        bool found = false;
+        bool keyframe = false;
+        report_t report = {};
+        for (gboolean more = gst_rtcp_buffer_get_first_packet(&rtcp, &packet); more;
+             more = gst_rtcp_packet_move_to_next(&packet)) {
+            GstRTCPType type = gst_rtcp_packet_get_type(&packet);
+            if (type == GST_RTCP_TYPE_PSFB) {
+                keyframe |= is_keyframe_request(&packet, own_ssrc);
+                continue;
+            }
+            if ((type != GST_RTCP_TYPE_RR && type != GST_RTCP_TYPE_SR) || found) {
+                continue;
+            }
+            for (guint i = 0; i < gst_rtcp_packet_get_rb_count(&packet); i++) {
+                guint32 ssrc, lsr, dlsr;
+                gst_rtcp_packet_get_rb(&packet, i, &ssrc, &report.fraction_lost, &report.cumulative_lost,
+                                       &report.highest_seq, &report.jitter, &lsr, &dlsr);
+                if (ssrc == own_ssrc) {
+                    found = true;
+                    break;
+                }
+            }
+        }
+        gst_rtcp_buffer_unmap(&rtcp);
+
+        if (keyframe) {
+            self->on_keyframe_request();
+        }
+        if (found) {
+            self->on_report(report);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    void rate_controller::on_keyframe_request() {
+        const auto now = std::chrono::steady_clock::now();
+        if (payloader_sink_ == NULL || (keyframes_forced_.load(std::memory_order_relaxed) > 0 &&
+                                        now - last_keyframe_ < KEYFRAME_INTERVAL)) {
+            return;
+        }
+        last_keyframe_ = now;
+        keyframes_forced_.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "[Rate] keyframe requested by the receiver" << std::endl;
+        // Upstream from the payloader's sink pad: x264enc, or h264parse and the source in passthrough
+        gst_pad_push_event(payloader_sink_, gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0));
+    }
+
+    void rate_controller::on_report(const report_t &report) {
+        const double loss = report.fraction_lost / 256.0;
+        const double jitter_ms = report.jitter * 1000.0 / RTP_CLOCK_RATE;
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t bytes = bytes_sent_.load(std::memory_order_relaxed);
+        const uint64_t packets = packets_sent_.load(std::memory_order_relaxed);
+
+        // Packets that got through since the last report, at the size we sent them
+        double received_kbps = 0;
+        if (have_last_) {
+            double seconds = std::chrono::duration<double>(now - last_time_).count();
+            int64_t expected = static_cast<uint32_t>(report.highest_seq - last_.highest_seq);
+            int64_t received = expected - (static_cast<int64_t>(report.cumulative_lost) - last_.cumulative_lost);
+            if (seconds > 0 && packets > last_packets_ && received > 0) {
+                double packet_bytes = static_cast<double>(bytes - last_bytes_) / (packets - last_packets_);
+                received_kbps = received * packet_bytes * 8 / 1000 / seconds;
+            }
+        }
+        have_last_ = true;
+        last_ = report;
+        last_bytes_ = bytes;
+        last_packets_ = packets;
+        last_time_ = now;
+
+        guint bitrate = bitrate_;
+        gint fps_cap = fps_cap_;
+        const gint source_fps = source_fps_.load(std::memory_order_relaxed);
+        if (hold_ > 0) {
+            // This report may still cover packets sent before the last change
+            hold_--;
+            return;
+        }
+        if (loss > LOSS_HIGH) {
+            double target = bitrate_ * (1.0 - loss / 2);
+            if (received_kbps > 0) {
+                target = std::min(target, received_kbps * 0.9);
+            }
+            bitrate = std::max(min_bitrate_, static_cast<guint>(target));
+            if (bitrate_ == min_bitrate_) {
+                // Fewer frames is the only way left to fewer bits
+                fps_cap = std::max(MIN_FPS, (fps_cap_ != 0 ? fps_cap_ : source_fps) / 2);
+            }
+        }
+        else if (loss < LOSS_LOW && jitter_ms < JITTER_LIMIT_MS) {
+            if (fps_cap_ != 0 && bitrate_ >= 2 * min_bitrate_) {
+                fps_cap = fps_cap_ * 2 >= source_fps ? 0 : fps_cap_ * 2;
+            }
+            else {
+                bitrate = std::min(max_bitrate_, bitrate_ + std::max<guint>(bitrate_ * INCREASE, INCREASE_MIN));
+            }
+        }
+        if (bitrate == bitrate_ && fps_cap == fps_cap_) {
+            return;
+        }
+        const bool adapt = adapt_.load(std::memory_order_relaxed);
+
+        std::cout << std::fixed << std::setprecision(1) << "[Rate] loss: " << loss * 100 << "% jitter: "
+                  << jitter_ms << " ms received: " << std::setprecision(0) << received_kbps << " kbit/s -> "
+                  << bitrate << " kbit/s, " << (fps_cap != 0 ? fps_cap : source_fps) << " fps"
+                  << (adapt ? "" : " (not applied)") << std::endl;
+        if (!adapt) {
+            return;
+        }
+        if (bitrate != bitrate_) {
+            g_object_set(G_OBJECT(h264enc_), "bitrate", bitrate, NULL);
+        }
+        if (fps_cap != fps_cap_) {
+            g_object_set(G_OBJECT(videorate_), "max-rate", fps_cap != 0 ? fps_cap : G_MAXINT, NULL);
+        }
+        hold_ = bitrate < bitrate_ || fps_cap != fps_cap_ ? 1 : 0;
+        bitrate_ = bitrate;
+        fps_cap_ = fps_cap;
+    }
+
+};
@@ -0,0 +1,105 @@
+/**
+ * @file    rate-control.h
+ * @brief   Adapts the sender's bitrate and frame rate to RTCP receiver reports
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Every receiver report carries, for our SSRC, the fraction of packets lost
+ * since the last report, the interarrival jitter and the highest sequence
+ * number received. From two reports and the bytes sent meanwhile the
+ * controller also estimates the rate that actually got through.
+ *
+ * The bitrate follows AIMD: above LOSS_HIGH it is cut in proportion to the
+ * loss and never above what was received, below LOSS_LOW with a calm jitter
+ * it grows by a few percent per report, up to the profile's bitrate. If the
+ * loss goes on at the lowest bitrate the frame rate is halved through
+ * videorate, and given back once the bitrate recovers.
+ *
+ * The same RTCP may carry a PLI or FIR for our SSRC when the receiver lost
+ * its reference picture. It becomes an upstream force-key-unit event from
+ * the payloader, which x264enc answers with an IDR and a camera source with
+ * a keyframe of its own.
+ */
+#ifndef __RATE_CONTROL_H
+#define __RATE_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <gst/gst.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+
+namespace local {
+
+    /** @brief One report block about our stream */
+    typedef struct {
+        uint8_t fraction_lost;      // Out of 256, since the previous report
+        int32_t cumulative_lost;
+        uint32_t highest_seq;       // Extended, wraps counted
+        uint32_t jitter;            // RTP timestamp units
+    } report_t;
+
+    class rate_controller {
+    public:
+        /**
+         * @param max_bitrate kbit/s, the profile's bitrate
+         * @param adapt       false only logs what the reports say
+         */
+        rate_controller(GstElement *h264enc, GstElement *videorate, guint max_bitrate, bool adapt);
+
+        rate_controller(const rate_controller &) = delete;
+        rate_controller &operator=(const rate_controller &) = delete;
+
+        /** @brief Count the RTP going into rtp_sink, read the reports coming out of rtcp_src */
+        bool attach(GstElement *rtp_sink, GstElement *rtcp_src);
+
+        /** @brief Answer PLI and FIR with a keyframe from whatever feeds the payloader */
+        void honor_keyframe_requests(GstElement *payloader);
+
+        uint64_t keyframes_forced() const { return keyframes_forced_.load(std::memory_order_relaxed); }
+
+        /** @brief false once there is no encoder to adapt, e.g. H.264 input sent as it is */
+        void set_adaptive(bool adapt) { adapt_.store(adapt, std::memory_order_relaxed); }
+
+        /** @brief Frame rate of the raw video, the limit when restoring it */
+        void set_source_fps(gint fps) { source_fps_.store(fps, std::memory_order_relaxed); }
+
+    private:
+        static GstPadProbeReturn cb_sent(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static gboolean packet_sent(GstBuffer **buffer, guint idx, gpointer user_data);
+        static GstPadProbeReturn cb_rtcp(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static bool is_keyframe_request(GstRTCPPacket *packet, uint32_t own_ssrc);
+
+        void on_report(const report_t &report);
+        void on_keyframe_request();
+
+        GstElement *h264enc_;
+        GstElement *videorate_;
+        std::atomic<bool> adapt_;
+        guint max_bitrate_;
+        guint min_bitrate_;
+
+        // RTP streaming thread
+        std::atomic<uint32_t> ssrc_{0};
+        std::atomic<bool> have_ssrc_{false};
+        std::atomic<uint64_t> bytes_sent_{0};
+        std::atomic<uint64_t> packets_sent_{0};
+        std::atomic<gint> source_fps_{30};
+
+        // RTCP streaming thread
+        GstPad *payloader_sink_ = NULL;
+        std::chrono::steady_clock::time_point last_keyframe_;
+        std::atomic<uint64_t> keyframes_forced_{0};
+        guint bitrate_;
+        gint fps_cap_ = 0;              // 0 = no cap
+        int hold_ = 0;                  // Reports to wait for a change to show up
+        bool have_last_ = false;
+        report_t last_ = {};
+        uint64_t last_bytes_ = 0;
+        uint64_t last_packets_ = 0;
+        std::chrono::steady_clock::time_point last_time_;
+    };
+
+};
+
+#endif // __RATE_CONTROL_H
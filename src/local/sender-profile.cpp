@@ -0,0 +1,69 @@
+/**
+ * @file    sender-profile.cpp
+ * @brief   Named encoder, payloader and socket settings for gstreamer-local
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include "sender-profile.h"
+
+namespace local {
+
+    static const sender_profile_t profiles[] = {
+        // No lookahead, no B-frames, slices instead of frame threads: a frame
+        // is on the wire as soon as it is encoded. Small VBV and packets keep
+        // keyframe bursts from overflowing receive buffers.
+        {"low-latency", "zerolatency", "ultrafast", 4000, 30, 0, 0, 100, 0, TRUE, 1200, -1, 1048576},
+        // A short lookahead and frame threads, a few frames of delay for
+        // noticeably better quality at the same bitrate.
+        {"balanced", "", "veryfast", 6000, 60, 0, 10, 600, 0, FALSE, 1400, -1, 2097152},
+        // Recorded or analysed offline, latency does not matter.
+        {"max-quality-per-bit", "", "slow", 3000, 250, 3, 40, 1000, 0, FALSE, 1400, -1, 2097152},
+    };
+
+    const sender_profile_t *find_profile(const std::string &name) {
+        for (const auto &profile : profiles) {
+            if (name == profile.name) {
+                return &profile;
+            }
+        }
+        return NULL;
+    }
+
+    std::string profile_names() {
+        std::string names;
+        for (const auto &profile : profiles) {
+            if (!names.empty()) {
+                names += ", ";
+            }
+            names += profile.name;
+        }
+        return names;
+    }
+
+    void apply_profile(const sender_profile_t &profile, GstElement *h264enc, GstElement *rtp_pay,
+                       GstElement *udpsink) {
+        // Enum and flags properties are set by nick, the enum types are private to the plugin
+        if (profile.tune[0] != '\0') {
+            gst_util_set_object_arg(G_OBJECT(h264enc), "tune", profile.tune);
+        }
+        gst_util_set_object_arg(G_OBJECT(h264enc), "speed-preset", profile.speed_preset);
+        g_object_set(G_OBJECT(h264enc),
+            "bitrate", profile.bitrate,
+            "key-int-max", profile.key_int_max,
+            "bframes", profile.bframes,
+            "rc-lookahead", profile.rc_lookahead,
+            "vbv-buf-capacity", profile.vbv_buf_capacity,
+            "threads", profile.threads,
+            "sliced-threads", profile.sliced_threads, NULL);
+
+        g_object_set(G_OBJECT(rtp_pay),
+            "mtu", profile.mtu,
+            "config-interval", profile.config_interval, NULL);
+
+        if (profile.send_buffer > 0) {
+            g_object_set(G_OBJECT(udpsink), "buffer-size", profile.send_buffer, NULL);
+        }
+    }
+
+};
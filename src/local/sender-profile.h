@@ -0,0 +1,48 @@
+/**
+ * @file    sender-profile.h
+ * @brief   Named encoder, payloader and socket settings for gstreamer-local
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * x264enc defaults are tuned for files: a 40 frame lookahead, B-frames and
+ * frame threading hold back several hundred ms of video before the first
+ * packet leaves. A profile sets everything that trades latency against
+ * quality per bit in one place so every sender runs the same settings.
+ */
+#ifndef __SENDER_PROFILE_H
+#define __SENDER_PROFILE_H
+
+#include <string>
+#include <gst/gst.h>
+
+namespace local {
+
+    typedef struct {
+        const char *name;
+        const char *tune;           // x264enc "tune" flags, "" for none
+        const char *speed_preset;   // x264enc "speed-preset" nick
+        guint bitrate;              // kbit/s
+        guint key_int_max;          // Frames between keyframes
+        guint bframes;
+        gint rc_lookahead;          // Frames the rate control looks ahead
+        guint vbv_buf_capacity;     // ms of video the rate control may burst, caps keyframe size
+        guint threads;              // 0 = x264 picks
+        gboolean sliced_threads;    // Split every frame instead of pipelining frames
+        guint mtu;                  // rtph264pay packet size
+        gint config_interval;       // SPS/PPS every N s, -1 = with every IDR
+        gint send_buffer;           // udpsink SO_SNDBUF bytes, 0 = kernel default
+    } sender_profile_t;
+
+    /** @brief The profile called name, NULL if there is none */
+    const sender_profile_t *find_profile(const std::string &name);
+
+    /** @brief Names of all profiles, for error messages */
+    std::string profile_names();
+
+    /** @brief Set the profile on x264enc, rtph264pay and udpsink */
+    void apply_profile(const sender_profile_t &profile, GstElement *h264enc, GstElement *rtp_pay,
+                       GstElement *udpsink);
+
+};
+
+#endif // __SENDER_PROFILE_H
@@ -0,0 +1,200 @@
+/**
+ * @file    encode-pool.cpp
+ * @brief   JPEG encoding spread over worker threads, emitted in input order
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <iostream>
+#include <string>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
+
+#include "encode-pool.h"
+
+namespace remote {
+
+    // A worker whose encoder stalls gives up on the frame after this long, so
+    // one bad frame can't hold the reorder window forever
+    static constexpr GstClockTime encode_timeout = GST_SECOND;
+
+    encode_pool::encode_pool(size_t threads, size_t window, emit_fn emit)
+        : window_(window >= threads ? window : threads), emit_(std::move(emit)),
+          workers_(threads > 0 ? threads : 1), reorder_(window_) {
+        for (auto &result : reorder_) {
+            result = {false, NULL, 0};
+        }
+    }
+
+    encode_pool::~encode_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        job_ready_.notify_all();
+        slot_free_.notify_all();
+
+        for (auto &worker : workers_) {
+            if (worker.thread.joinable()) {
+                worker.thread.join();
+            }
+            if (worker.pipeline != NULL) {
+                gst_element_set_state(worker.pipeline, GST_STATE_NULL);
+                gst_object_unref(worker.pipeline);
+            }
+        }
+        for (auto &job : jobs_) {
+            gst_sample_unref(job.sample);
+        }
+        for (auto &result : reorder_) {
+            if (result.sample != NULL) {
+                gst_sample_unref(result.sample);
+            }
+        }
+    }
+
+    bool encode_pool::start() {
+        for (size_t i = 0; i < workers_.size(); i++) {
+            worker_t &worker = workers_[i];
+            std::string name = "jpeg_worker_" + std::to_string(i);
+
+            worker.pipeline = gst_pipeline_new(name.c_str());
+            worker.src = gst_element_factory_make("appsrc", NULL);
+            GstElement *enc = gst_element_factory_make("jpegenc", NULL);
+            worker.sink = gst_element_factory_make("appsink", NULL);
+            if (worker.pipeline == NULL || worker.src == NULL || enc == NULL || worker.sink == NULL) {
+                g_printerr("Encode pool: not all elements could be created.\n");
+                return false;
+            }
+
+            // Caps come with every pushed sample, timestamps are kept as they are
+            g_object_set(G_OBJECT(worker.src), "format", GST_FORMAT_TIME, "is-live", TRUE, NULL);
+            g_object_set(G_OBJECT(worker.sink), "emit-signals", FALSE, "sync", FALSE, NULL);
+
+            gst_bin_add_many(GST_BIN(worker.pipeline), worker.src, enc, worker.sink, NULL);
+            if (gst_element_link_many(worker.src, enc, worker.sink, NULL) != TRUE) {
+                g_printerr("Encode pool: elements could not be linked.\n");
+                return false;
+            }
+            if (gst_element_set_state(worker.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+                g_printerr("Encode pool: unable to start %s.\n", name.c_str());
+                return false;
+            }
+        }
+
+        for (auto &worker : workers_) {
+            worker.thread = std::thread(&encode_pool::run, this, &worker);
+        }
+        std::cout << "Encode pool: " << workers_.size() << " jpegenc workers, reorder window "
+                  << window_ << std::endl;
+        return true;
+    }
+
+    void encode_pool::submit(GstSample *sample, uint32_t tag) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        slot_free_.wait(lock, [this] { return stopping_ || next_seq_ - next_emit_ < window_; });
+        if (stopping_) {
+            gst_sample_unref(sample);
+            return;
+        }
+
+        jobs_.push_back({next_seq_++, sample, tag});
+        size_t in_flight = next_seq_ - next_emit_;
+        if (in_flight > max_in_flight_.load(std::memory_order_relaxed)) {
+            max_in_flight_.store(in_flight, std::memory_order_relaxed);
+        }
+        submitted_.fetch_add(1, std::memory_order_relaxed);
+        lock.unlock();
+        job_ready_.notify_one();
+    }
+
+    void encode_pool::run(worker_t *worker) {
+        GstAppSrc *src = GST_APP_SRC_CAST(worker->src);
+        GstAppSink *sink = GST_APP_SINK_CAST(worker->sink);
+
+        while (true) {
+            job_t job;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                job_ready_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (stopping_) {
+                    break;
+                }
+                job = jobs_.front();
+                jobs_.pop_front();
+            }
+
+            // Output of a frame that timed out earlier would pass for this one
+            drain(sink);
+
+            // jpegenc encodes in the appsrc streaming thread, the result shows
+            // up in this worker's appsink
+            GstBuffer *buffer = gst_sample_get_buffer(job.sample);
+            GstClockTime pts = buffer != NULL ? GST_BUFFER_PTS(buffer) : GST_CLOCK_TIME_NONE;
+            GstSample *encoded = NULL;
+            if (gst_app_src_push_sample(src, job.sample) == GST_FLOW_OK) {
+                encoded = pull(sink, pts);
+            }
+            gst_sample_unref(job.sample);
+            complete(job, encoded);
+        }
+        gst_app_src_end_of_stream(src);
+    }
+
+    void encode_pool::drain(GstAppSink *sink) {
+        GstSample *stale;
+        while ((stale = gst_app_sink_try_pull_sample(sink, 0)) != NULL) {
+            stale_.fetch_add(1, std::memory_order_relaxed);
+            gst_sample_unref(stale);
+        }
+    }
+
+    /* jpegenc keeps the PTS, a sample with another one is late output of an older frame */
+    GstSample *encode_pool::pull(GstAppSink *sink, GstClockTime pts) {
+        gint64 deadline = g_get_monotonic_time() + encode_timeout / GST_USECOND;
+        while (true) {
+            gint64 left = deadline - g_get_monotonic_time();
+            GstSample *sample = gst_app_sink_try_pull_sample(sink, left > 0 ? left * GST_USECOND : 0);
+            if (sample == NULL) {
+                return NULL;
+            }
+            GstBuffer *buffer = gst_sample_get_buffer(sample);
+            if (!GST_CLOCK_TIME_IS_VALID(pts) || (buffer != NULL && GST_BUFFER_PTS(buffer) == pts)) {
+                return sample;
+            }
+            stale_.fetch_add(1, std::memory_order_relaxed);
+            gst_sample_unref(sample);
+        }
+    }
+
+    void encode_pool::complete(const job_t &job, GstSample *encoded) {
+        if (encoded != NULL) {
+            encoded_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            failed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        reorder_[job.seq % window_] = {true, encoded, job.tag};
+
+        // Emitting under the lock keeps the output in order and gives the
+        // consumer a single producer at any time
+        bool freed = false;
+        while (reorder_[next_emit_ % window_].done) {
+            result_t &result = reorder_[next_emit_ % window_];
+            if (result.sample != NULL) {
+                emit_(result.sample, result.tag);
+            }
+            result = {false, NULL, 0};
+            next_emit_++;
+            freed = true;
+        }
+        lock.unlock();
+
+        if (freed) {
+            slot_free_.notify_all();
+        }
+    }
+
+};
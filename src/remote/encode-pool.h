@@ -0,0 +1,108 @@
+/**
+ * @file    encode-pool.h
+ * @brief   JPEG encoding spread over worker threads, emitted in input order
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Every worker owns a private "appsrc ! jpegenc ! appsink" pipeline, so the
+ * encoders never share state. Raw samples get a sequence number on submit(),
+ * any idle worker encodes the next one, and finished frames wait in a reorder
+ * window until all older ones are done. At most window frames are in flight;
+ * submit() blocks beyond that, which pushes back on the main pipeline's
+ * appsink exactly like a slow inline jpegenc would.
+ */
+#ifndef __ENCODE_POOL_H
+#define __ENCODE_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+
+namespace remote {
+
+    class encode_pool {
+    public:
+        /**
+         * @brief Called with every encoded sample in submit() order, from one
+         *        worker at a time, along with the tag it was submitted with.
+         *        It takes over the sample reference.
+         */
+        using emit_fn = std::function<void(GstSample *sample, uint32_t tag)>;
+
+        encode_pool(size_t threads, size_t window, emit_fn emit);
+        ~encode_pool();
+
+        encode_pool(const encode_pool &) = delete;
+        encode_pool &operator=(const encode_pool &) = delete;
+
+        /** @brief Build and start the worker pipelines */
+        bool start();
+
+        /** @brief Queue a raw sample for encoding, takes over the reference */
+        void submit(GstSample *sample, uint32_t tag = 0);
+
+        size_t threads() const { return workers_.size(); }
+        size_t window() const { return window_; }
+
+        uint64_t submitted() const { return submitted_.load(std::memory_order_relaxed); }
+        uint64_t encoded() const { return encoded_.load(std::memory_order_relaxed); }
+        uint64_t failed() const { return failed_.load(std::memory_order_relaxed); }
+        /** @brief Late encoder output of a frame already given up on, discarded */
+        uint64_t stale() const { return stale_.load(std::memory_order_relaxed); }
+        size_t max_in_flight() const { return max_in_flight_.load(std::memory_order_relaxed); }
+
+    private:
+        typedef struct {
+            GstElement *pipeline;
+            GstElement *src;
+            GstElement *sink;
+            std::thread thread;
+        } worker_t;
+
+        typedef struct {
+            uint64_t seq;
+            GstSample *sample;
+            uint32_t tag;
+        } job_t;
+
+        typedef struct {
+            bool done;
+            GstSample *sample;              // NULL when encoding failed
+            uint32_t tag;
+        } result_t;
+
+        void run(worker_t *worker);
+        void drain(GstAppSink *sink);
+        GstSample *pull(GstAppSink *sink, GstClockTime pts);
+        void complete(const job_t &job, GstSample *encoded);
+
+        size_t window_;
+        emit_fn emit_;
+        std::vector<worker_t> workers_;
+
+        std::mutex mtx_;
+        std::condition_variable job_ready_;
+        std::condition_variable slot_free_;
+        std::deque<job_t> jobs_;
+        std::vector<result_t> reorder_;     // Indexed by seq % window
+        uint64_t next_seq_ = 0;             // Given to the next submitted frame
+        uint64_t next_emit_ = 0;            // Oldest frame not emitted yet
+        bool stopping_ = false;
+
+        std::atomic<uint64_t> submitted_{0};
+        std::atomic<uint64_t> encoded_{0};
+        std::atomic<uint64_t> failed_{0};
+        std::atomic<uint64_t> stale_{0};
+        std::atomic<size_t> max_in_flight_{0};
+    };
+
+};
+
+#endif // __ENCODE_POOL_H
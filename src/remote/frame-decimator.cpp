@@ -0,0 +1,167 @@
+/**
+ * @file    frame-decimator.cpp
+ * @brief   Cuts the decoded frame rate down to a target as early as possible
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <cstring>
+
+#include "frame-decimator.h"
+
+namespace remote {
+
+    frame_decimator::frame_decimator(double target_fps)
+        : target_fps_(target_fps), interval_(static_cast<GstClockTime>(GST_SECOND / target_fps)) {}
+
+    bool frame_decimator::attach(GstElement *decoder) {
+        GstPad *sink_pad = gst_element_get_static_pad(decoder, "sink");
+        GstPad *src_pad = gst_element_get_static_pad(decoder, "src");
+        if (sink_pad == NULL || src_pad == NULL) {
+            if (sink_pad) gst_object_unref(sink_pad);
+            if (src_pad) gst_object_unref(src_pad);
+            return false;
+        }
+        gst_pad_add_probe(sink_pad,
+            static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+            cb_encoded, this, NULL);
+        gst_pad_add_probe(src_pad, GST_PAD_PROBE_TYPE_BUFFER, cb_decoded, this, NULL);
+        gst_object_unref(sink_pad);
+        gst_object_unref(src_pad);
+        return true;
+    }
+
+    /* Frames without a PTS can't be scheduled and a PTS far behind the schedule is a restart, both pass */
+    bool frame_decimator::due(GstClockTime pts) const {
+        GstClockTime next = next_due_.load(std::memory_order_relaxed);
+        return !GST_CLOCK_TIME_IS_VALID(pts) || pts >= next || pts + GST_SECOND < next;
+    }
+
+    void frame_decimator::parse_caps(GstCaps *caps) {
+        GstStructure *s = gst_caps_get_structure(caps, 0);
+        const gchar *format = gst_structure_get_string(s, "stream-format");
+        avc_ = format != NULL && g_str_has_prefix(format, "avc");
+        nal_length_size_ = 4;
+
+        // avcC: the low two bits of byte 4 are the NAL length size minus one
+        const GValue *value = gst_structure_get_value(s, "codec_data");
+        if (avc_ && value != NULL && G_VALUE_HOLDS(value, GST_TYPE_BUFFER)) {
+            GstBuffer *codec_data = gst_value_get_buffer(value);
+            guint8 byte;
+            if (gst_buffer_extract(codec_data, 4, &byte, 1) == 1) {
+                nal_length_size_ = (byte & 0x03) + 1;
+            }
+        }
+    }
+
+    /* True when no NAL of the access unit is referenced, so skipping its decode is safe */
+    bool frame_decimator::is_non_reference(GstBuffer *buffer) const {
+        GstMapInfo map;
+        if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            return false;
+        }
+        const guint8 *data = map.data;
+        size_t size = map.size;
+        bool slice = false, referenced = false;
+
+        auto check = [&](const guint8 *nal, size_t len) {
+            if (len == 0) {
+                return;
+            }
+            guint8 type = nal[0] & 0x1f;
+            referenced |= (nal[0] & 0x60) != 0;
+            slice |= type >= 1 && type <= 5;
+        };
+
+        if (avc_) {
+            size_t pos = 0;
+            while (pos + nal_length_size_ <= size && !referenced) {
+                size_t len = 0;
+                for (unsigned i = 0; i < nal_length_size_; i++) {
+                    len = (len << 8) | data[pos + i];
+                }
+                pos += nal_length_size_;
+                if (len > size - pos) {
+                    referenced = true;      // Corrupt, don't risk dropping it
+                    break;
+                }
+                check(data + pos, len);
+                pos += len;
+            }
+        }
+        else {
+            // Byte-stream: the NAL header is the byte after each 00 00 01
+            for (size_t i = 0; i + 3 < size && !referenced; i++) {
+                if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+                    check(data + i + 3, size - i - 3);
+                    i += 2;
+                }
+            }
+        }
+
+        gst_buffer_unmap(buffer, &map);
+        return slice && !referenced;
+    }
+
+    GstPadProbeReturn frame_decimator::cb_encoded(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<frame_decimator *>(user_data);
+
+        if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+            GstEvent *event = gst_pad_probe_info_get_event(info);
+            if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+                GstCaps *caps;
+                gst_event_parse_caps(event, &caps);
+                self->parse_caps(caps);
+            }
+            return GST_PAD_PROBE_OK;
+        }
+
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        self->in_.fetch_add(1, std::memory_order_relaxed);
+        if (buffer == NULL || self->due(GST_BUFFER_PTS(buffer)) || !self->is_non_reference(buffer)) {
+            return GST_PAD_PROBE_OK;
+        }
+        self->dropped_encoded_.fetch_add(1, std::memory_order_relaxed);
+        return GST_PAD_PROBE_DROP;
+    }
+
+    GstPadProbeReturn frame_decimator::cb_decoded(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<frame_decimator *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        if (buffer == NULL) {
+            return GST_PAD_PROBE_OK;
+        }
+
+        GstClockTime pts = GST_BUFFER_PTS(buffer);
+        if (!self->due(pts)) {
+            self->dropped_decoded_.fetch_add(1, std::memory_order_relaxed);
+            return GST_PAD_PROBE_DROP;
+        }
+        if (GST_CLOCK_TIME_IS_VALID(pts)) {
+            // Keep the cadence, but don't try to catch up after a gap
+            GstClockTime next = self->next_due_.load(std::memory_order_relaxed) + self->interval_;
+            self->next_due_.store(next > pts + self->interval_ || next <= pts ? pts + self->interval_ : next,
+                                  std::memory_order_relaxed);
+        }
+        self->out_.fetch_add(1, std::memory_order_relaxed);
+        return GST_PAD_PROBE_OK;
+    }
+
+    void frame_decimator::report(std::ostream &out, int stream) {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - last_report_).count();
+        uint64_t frames = frames_out();
+        double fps = seconds > 0 ? (frames - last_out_) / seconds : 0.0;
+        last_out_ = frames;
+        last_report_ = now;
+
+        out << "[Decimate]";
+        if (stream >= 0) {
+            out << " stream " << stream;
+        }
+        out << " target: " << target_fps_ << " fps achieved: " << fps
+            << " | in: " << frames_in() << " out: " << frames << " dropped before decode: "
+            << dropped_before_decode() << " after decode: " << dropped_after_decode() << std::endl;
+    }
+
+};
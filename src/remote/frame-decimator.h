@@ -0,0 +1,75 @@
+/**
+ * @file    frame-decimator.h
+ * @brief   Cuts the decoded frame rate down to a target as early as possible
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __FRAME_DECIMATOR_H
+#define __FRAME_DECIMATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <gst/gst.h>
+
+namespace remote {
+
+    /**
+     * @brief Lets through one frame per 1/target_fps of PTS.
+     *
+     * Two probes share the schedule. On the decoder's sink pad, access units
+     * that no other frame references (every NAL has nal_ref_idc == 0) and
+     * are not due yet are dropped before they cost a decode. Reference
+     * frames must be decoded anyway, so on the decoder's src pad everything
+     * that is not due is dropped before conversion and encoding. Streams
+     * without non-reference frames, e.g. x264 zerolatency, only get the
+     * second stage.
+     */
+    class frame_decimator {
+    public:
+        explicit frame_decimator(double target_fps);
+
+        frame_decimator(const frame_decimator &) = delete;
+        frame_decimator &operator=(const frame_decimator &) = delete;
+
+        bool attach(GstElement *decoder);
+
+        double target_fps() const { return target_fps_; }
+
+        uint64_t frames_in() const { return in_.load(std::memory_order_relaxed); }
+        uint64_t frames_out() const { return out_.load(std::memory_order_relaxed); }
+        uint64_t dropped_before_decode() const { return dropped_encoded_.load(std::memory_order_relaxed); }
+        uint64_t dropped_after_decode() const { return dropped_decoded_.load(std::memory_order_relaxed); }
+
+        /** @brief Print the rate achieved since the last report, labelled with stream if >= 0 */
+        void report(std::ostream &out, int stream = -1);
+
+    private:
+        static GstPadProbeReturn cb_encoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static GstPadProbeReturn cb_decoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+        bool due(GstClockTime pts) const;
+        void parse_caps(GstCaps *caps);
+        bool is_non_reference(GstBuffer *buffer) const;
+
+        double target_fps_;
+        GstClockTime interval_;
+        std::atomic<GstClockTime> next_due_{0};
+
+        // Set from the caps event, read in the same streaming thread
+        bool avc_ = false;                  // Length prefixed NALs, else start codes
+        unsigned nal_length_size_ = 4;
+
+        std::atomic<uint64_t> in_{0};
+        std::atomic<uint64_t> out_{0};
+        std::atomic<uint64_t> dropped_encoded_{0};
+        std::atomic<uint64_t> dropped_decoded_{0};
+
+        uint64_t last_out_ = 0;
+        std::chrono::steady_clock::time_point last_report_ = std::chrono::steady_clock::now();
+    };
+
+};
+
+#endif // __FRAME_DECIMATOR_H
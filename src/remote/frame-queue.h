@@ -0,0 +1,97 @@
+/**
+ * @file    frame-queue.h
+ * @brief   Bounded single-producer/single-consumer ring of frame slots
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * The appsink thread is the only producer and the socket thread the only
+ * consumer, so head and tail are plain atomics and no lock is taken on either
+ * side. The remote's slots only carry a GstSample reference and the stream
+ * it came from: the producer hands its reference over without copying the
+ * payload, and the consumer takes it out of front() before pop_release(),
+ * into a mapped_frame that unrefs it once every client has sent it.
+ */
+#ifndef __FRAME_QUEUE_H
+#define __FRAME_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace remote {
+
+    template <typename T>
+    class frame_queue {
+    public:
+        explicit frame_queue(size_t capacity)
+            : slots_(capacity > 0 ? capacity : 1) {}
+
+        frame_queue(const frame_queue &) = delete;
+        frame_queue &operator=(const frame_queue &) = delete;
+
+        /**
+         * @brief Producer side: slot to fill in place before push_commit()
+         *
+         * @return nullptr when the ring is full. The frame is then counted as
+         *         dropped, so the producer only has to release its input.
+         */
+        T *producer_slot() {
+            const uint64_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) >= slots_.size()) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &slots_[tail % slots_.size()];
+        }
+
+        /** @brief Producer side: publish the slot returned by producer_slot() */
+        void push_commit() {
+            const uint64_t tail = tail_.load(std::memory_order_relaxed) + 1;
+            tail_.store(tail, std::memory_order_release);
+
+            const uint64_t depth = tail - head_.load(std::memory_order_acquire);
+            uint64_t high = high_watermark_.load(std::memory_order_relaxed);
+            while (depth > high &&
+                   !high_watermark_.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+            }
+        }
+
+        /** @brief Consumer side: oldest frame, or nullptr when empty */
+        T *front() {
+            const uint64_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return &slots_[head % slots_.size()];
+        }
+
+        /** @brief Consumer side: hand the slot returned by front() back to the producer */
+        void pop_release() {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t capacity() const { return slots_.size(); }
+
+        size_t depth() const {
+            return static_cast<size_t>(tail_.load(std::memory_order_acquire) -
+                                       head_.load(std::memory_order_acquire));
+        }
+
+        uint64_t pushed() const { return tail_.load(std::memory_order_relaxed); }
+        uint64_t popped() const { return head_.load(std::memory_order_relaxed); }
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+        uint64_t high_watermark() const { return high_watermark_.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<T> slots_;
+
+        alignas(64) std::atomic<uint64_t> head_{0};   // next slot to consume
+        alignas(64) std::atomic<uint64_t> tail_{0};   // next slot to produce
+        alignas(64) std::atomic<uint64_t> dropped_{0};
+        std::atomic<uint64_t> high_watermark_{0};
+    };
+
+};
+
+#endif // __FRAME_QUEUE_H
@@ -0,0 +1,622 @@
+/**
+ * @file    frame-server.cpp
+ * @brief   Event driven TCP server that fans frames out to every consumer
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <crc32c.h>
+
+#include "frame-server.h"
+
+namespace remote {
+
+    static constexpr int max_events = 64;
+    static constexpr size_t max_iov = 64;   //Per sendmsg(), well below IOV_MAX
+    static constexpr int keepalive_idle_s = 5;
+    static constexpr int keepalive_interval_s = 1;
+    static constexpr int keepalive_count = 3;
+    static constexpr unsigned user_timeout_ms = 5000;   //Unacknowledged data before the kernel gives up
+
+    static uint64_t monotonic_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    bool parse_slow_client_policy(const std::string &name, slow_client_policy &policy) {
+        if (name == "drop-oldest") {
+            policy = slow_client_policy::drop_oldest;
+        }
+        else if (name == "latest") {
+            policy = slow_client_policy::latest;
+        }
+        else if (name == "disconnect") {
+            policy = slow_client_policy::disconnect;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *slow_client_policy_name(slow_client_policy policy) {
+        switch (policy) {
+            case slow_client_policy::drop_oldest: return "drop-oldest";
+            case slow_client_policy::latest:      return "latest";
+            case slow_client_policy::disconnect:  return "disconnect";
+        }
+        return "unknown";
+    }
+
+    bool parse_protocol_mode(const std::string &name, protocol_mode &mode) {
+        if (name == "1") {
+            mode = protocol_mode::v1;
+        }
+        else if (name == "auto") {
+            mode = protocol_mode::automatic;
+        }
+        else if (name == "2") {
+            mode = protocol_mode::v2;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    const char *protocol_mode_name(protocol_mode mode) {
+        switch (mode) {
+            case protocol_mode::v1:        return "1";
+            case protocol_mode::automatic: return "auto";
+            case protocol_mode::v2:        return "2";
+        }
+        return "unknown";
+    }
+
+    frame_server::frame_server(uint16_t port, size_t client_queue, slow_client_policy policy)
+        : port_(port), client_queue_(client_queue > 0 ? client_queue : 1), policy_(policy) {}
+
+    frame_server::~frame_server() {
+        while (!clients_.empty()) {
+            close_client(clients_.begin()->first, "server shutdown");
+        }
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+        }
+    }
+
+    bool frame_server::start() {
+        struct sockaddr_in server_addr = {};
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            perror("socket failed");
+            return false;
+        }
+
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port_);
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+
+        if (bind(listen_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            perror("bind failed");
+            return false;
+        }
+        if (listen(listen_fd_, SOMAXCONN) < 0) {
+            perror("listen");
+            return false;
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            perror("epoll_create1");
+            return false;
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = listen_fd_;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev) < 0) {
+            perror("epoll_ctl");
+            return false;
+        }
+
+        std::cout << "Frame server on port " << port_ << ", client queue: " << client_queue_
+                  << ", slow client policy: " << slow_client_policy_name(policy_)
+                  << ", protocol: " << protocol_mode_name(protocol_) << std::endl;
+        return true;
+    }
+
+    bool frame_server::add_wakeup_fd(int fd) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            perror("epoll_ctl");
+            return false;
+        }
+        wakeup_fd_ = fd;
+        return true;
+    }
+
+    bool frame_server::poll(int timeout_ms) {
+        struct epoll_event events[max_events];
+        bool woken = false;
+
+        // Wake up in time to settle consumers that never send a hello
+        if (awaiting_hello_ > 0) {
+            int hello_ms = static_cast<int>(hello_wait_ns_ / 1000000) + 1;
+            timeout_ms = timeout_ms < 0 ? hello_ms : std::min(timeout_ms, hello_ms);
+        }
+
+        int n = epoll_wait(epoll_fd_, events, max_events, timeout_ms);
+        if (n < 0) {
+            if (errno != EINTR) {
+                perror("epoll_wait");
+            }
+            return false;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == wakeup_fd_) {
+                // Coalesced counter, the caller drains its queue anyway
+                uint64_t count;
+                while (read(fd, &count, sizeof(count)) < 0 && errno == EINTR) {
+                }
+                woken = true;
+                continue;
+            }
+
+            if (fd == listen_fd_) {
+                accept_clients();
+                continue;
+            }
+
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) {
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                close_client(fd, "hang up");
+                continue;
+            }
+
+            if ((events[i].events & EPOLLIN) && it->second.version == 0) {
+                read_hello(it->second);
+                if (clients_.find(fd) == clients_.end()) {
+                    continue;
+                }
+            }
+            else if (events[i].events & EPOLLIN) {
+                // Past the hello consumers don't talk back, anything they send is discarded
+                uint8_t scratch[256];
+                ssize_t got = recv(fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+                if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    close_client(fd, "closed by peer");
+                    continue;
+                }
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                if (!flush(it->second)) {
+                    close_client(fd, "send error");
+                }
+            }
+        }
+        expire_hellos();
+        publish_stats();
+        return woken;
+    }
+
+    void frame_server::broadcast(const std::shared_ptr<mapped_frame> &frame, int32_t number,
+                                 const frame_protocol::meta_t *meta, const frame_info_t *info) {
+        pending_frame entry;
+        entry.frame = frame;
+        entry.header.number = number;
+        entry.header.length = frame->size();
+        entry.meta_len = meta != nullptr ? sizeof(entry.meta) : 0;
+        if (meta != nullptr) {
+            entry.meta = *meta;
+        }
+
+        frame_protocol::header_v2_t &h = entry.header_v2;
+        h = {};
+        h.magic = frame_protocol::magic;
+        h.version = frame_protocol::version_2;
+        h.size = sizeof(h);
+        h.sequence = sequence_++;
+        h.pts = frame_protocol::unknown_pts;
+        h.length = frame->size();
+        if (info != nullptr) {
+            h.pts = info->pts;
+            h.format = info->format;
+            h.width = info->width;
+            h.height = info->height;
+            h.stride = info->stride;
+            h.stream_id = info->stream_id;
+            if (info->keyframe) {
+                h.flags |= frame_protocol::flag_keyframe;
+            }
+        }
+        if (meta != nullptr) {
+            h.flags |= frame_protocol::flag_meta;
+        }
+        if (crc_clients_ > 0) {
+            uint32_t crc = crc32c::initial;
+            for (auto &chunk : frame->payload()) {
+                crc = crc32c::update(crc, chunk.iov_base, chunk.iov_len);
+            }
+            h.crc = crc32c::finish(crc);
+            h.flags |= frame_protocol::flag_crc;
+        }
+
+        last_broadcast_ = number;
+        if (replay_) {
+            latest_ = entry;
+            latest_ns_ = monotonic_ns();
+        }
+        std::vector<int> failed;
+        for (auto &it : clients_) {
+            client_t &client = it.second;
+            if (client.version == 0) {
+                continue;
+            }
+            size_t waiting = client.queue.size() - (client.offset > 0 ? 1 : 0);
+
+            if (waiting >= client_queue_ && policy_ == slow_client_policy::disconnect) {
+                failed.push_back(client.fd);
+                continue;
+            }
+            enqueue(client, entry);
+
+            // Queued frames mean the socket is already backed up and EPOLLOUT
+            // will drain it, only write eagerly when this is the only frame
+            if (!client.want_write && !flush(client)) {
+                failed.push_back(client.fd);
+            }
+        }
+
+        for (int fd : failed) {
+            close_client(fd, policy_ == slow_client_policy::disconnect ? "too slow" : "send error");
+        }
+        publish_stats();
+    }
+
+    /* At most every 100 ms unless a client came or went, copying a few counters per client */
+    void frame_server::publish_stats() {
+        uint64_t now = monotonic_ns();
+        if (!clients_changed_ && now - last_publish_ns_ < 100000000ull) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(stats_mtx_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        last_publish_ns_ = now;
+        clients_changed_ = false;
+        published_.clear();
+        for (auto &it : clients_) {
+            const client_t &client = it.second;
+            int64_t lag = client.last_number >= 0 ? static_cast<int64_t>(last_broadcast_) - client.last_number
+                                                  : static_cast<int64_t>(client.queue.size());
+            published_.push_back({client.peer, client.queue.size(), lag, client.sent, client.dropped, client.bytes});
+        }
+    }
+
+    std::vector<client_stats_t> frame_server::client_stats() const {
+        std::lock_guard<std::mutex> lock(stats_mtx_);
+        return published_;
+    }
+
+    void frame_server::accept_clients() {
+        while (true) {
+            struct sockaddr_in client_addr;
+            socklen_t sin_size = sizeof(client_addr);
+
+            int fd = accept4(listen_fd_, (struct sockaddr*)&client_addr, &sin_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    perror("accept");
+                }
+                return;
+            }
+
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            // A consumer that vanished without a FIN (cable, crash of its host)
+            // would otherwise keep its slot and queue until the frames fill it
+            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &keepalive_idle_s, sizeof(keepalive_idle_s));
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &keepalive_interval_s, sizeof(keepalive_interval_s));
+            setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &keepalive_count, sizeof(keepalive_count));
+            setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout_ms, sizeof(user_timeout_ms));
+
+            struct epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                perror("epoll_ctl");
+                close(fd);
+                continue;
+            }
+
+            client_t client;
+            client.fd = fd;
+            client.peer = std::string(inet_ntoa(client_addr.sin_addr)) + ":" + std::to_string(ntohs(client_addr.sin_port));
+            client.connected_ns = monotonic_ns();
+            std::cout << "Got connection from " << client.peer << " (" << clients_.size() + 1 << " clients)" << std::endl;
+            client_t &added = clients_.emplace(fd, std::move(client)).first->second;
+            client_count_.store(clients_.size(), std::memory_order_relaxed);
+            connects_.fetch_add(1, std::memory_order_relaxed);
+            clients_changed_ = true;
+
+            if (protocol_ == protocol_mode::v1) {
+                start_sending(added, frame_protocol::version_1);
+            }
+            else {
+                awaiting_hello_++;
+            }
+        }
+    }
+
+    /* The hello may arrive in pieces, the version is picked once it is whole */
+    void frame_server::read_hello(client_t &client) {
+        auto dst = reinterpret_cast<uint8_t *>(&client.hello) + client.hello_len;
+        ssize_t got = recv(client.fd, dst, sizeof(client.hello) - client.hello_len, MSG_DONTWAIT);
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return;
+        }
+        if (got <= 0) {
+            close_client(client.fd, "closed by peer");
+            return;
+        }
+        client.hello_len += got;
+        if (client.hello_len < sizeof(client.hello)) {
+            return;
+        }
+
+        const frame_protocol::hello_t &hello = client.hello;
+        if (hello.magic != frame_protocol::magic) {
+            if (protocol_ == protocol_mode::v2) {
+                close_client(client.fd, "no hello");
+                return;
+            }
+            // Not a hello, the rest of what it sends is discarded like before
+            awaiting_hello_--;
+            start_sending(client, frame_protocol::version_1);
+            return;
+        }
+
+        // Bytes past sizeof(hello_t) from a newer consumer are discarded later
+        uint16_t lowest = protocol_ == protocol_mode::v2 ? frame_protocol::version_2 : frame_protocol::version_1;
+        uint16_t version = std::min(hello.max_version, frame_protocol::version_2);
+        if (version < hello.min_version || version < lowest) {
+            version = 0;
+        }
+        frame_protocol::hello_t reply = {};
+        reply.magic = frame_protocol::magic;
+        reply.size = sizeof(reply);
+        reply.min_version = version;
+        reply.max_version = version;
+        reply.flags = version == frame_protocol::version_2 ? (hello.flags & frame_protocol::hello_crc) : 0;
+
+        // First bytes on a fresh connection, the socket buffer is empty
+        ssize_t sent = send(client.fd, &reply, sizeof(reply), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent != static_cast<ssize_t>(sizeof(reply))) {
+            close_client(client.fd, "send error");
+            return;
+        }
+        if (version == 0) {
+            std::cout << "Client " << client.peer << " asked for protocol " << hello.min_version << ".."
+                      << hello.max_version << ", not supported" << std::endl;
+            close_client(client.fd, "no common protocol version");
+            return;
+        }
+        awaiting_hello_--;
+        client.crc = (reply.flags & frame_protocol::hello_crc) != 0;
+        if (client.crc) {
+            crc_clients_++;
+        }
+        start_sending(client, version);
+    }
+
+    /* Consumers that stayed silent: version 1 in automatic mode, closed if version 2 is required */
+    void frame_server::expire_hellos() {
+        if (awaiting_hello_ == 0) {
+            return;
+        }
+        uint64_t now = monotonic_ns();
+        std::vector<int> expired;
+        for (auto &it : clients_) {
+            if (it.second.version == 0 && now - it.second.connected_ns >= hello_wait_ns_) {
+                expired.push_back(it.first);
+            }
+        }
+        for (int fd : expired) {
+            if (protocol_ == protocol_mode::v2) {
+                close_client(fd, "no hello");
+            }
+            else {
+                awaiting_hello_--;
+                start_sending(clients_.at(fd), frame_protocol::version_1);
+            }
+        }
+    }
+
+    void frame_server::start_sending(client_t &client, uint16_t version) {
+        client.version = version;
+        if (version != frame_protocol::version_1) {
+            std::cout << "Client " << client.peer << " speaks protocol " << version
+                      << (client.crc ? " with payload CRCs" : "") << std::endl;
+        }
+
+        // Something to show right away instead of waiting for the next frame
+        if (latest_.frame && monotonic_ns() - latest_ns_ <= replay_max_age_ns_) {
+            enqueue(client, latest_);
+            frames_replayed_.fetch_add(1, std::memory_order_relaxed);
+            if (!flush(client)) {
+                close_client(client.fd, "send error");
+            }
+        }
+    }
+
+    void frame_server::enqueue(client_t &client, const pending_frame &entry) {
+        // The frame being written (offset > 0) can't be pulled back out of the
+        // stream, so it never counts against the queue and is never dropped
+        size_t in_flight = client.offset > 0 ? 1 : 0;
+        size_t waiting = client.queue.size() - in_flight;
+
+        if (waiting >= client_queue_) {
+            size_t discard = (policy_ == slow_client_policy::latest) ? waiting : 1;
+            auto first = client.queue.begin() + in_flight;
+            client.queue.erase(first, first + discard);
+            client.dropped += discard;
+            frames_dropped_.fetch_add(discard, std::memory_order_relaxed);
+        }
+        client.queue.push_back(entry);
+    }
+
+    bool frame_server::flush(client_t &client) {
+        std::vector<struct iovec> iov;
+        iov.reserve(max_iov);
+
+        while (!client.queue.empty()) {
+            // Gather as many queued frames as fit in one sendmsg()
+            iov.clear();
+            size_t skip = client.offset;
+            for (auto &entry : client.queue) {
+                if (iov.size() + 2 + entry.frame->payload().size() > max_iov && !iov.empty()) {
+                    break;
+                }
+                auto add = [&](void *base, size_t len) {
+                    if (skip >= len) {
+                        skip -= len;
+                        return;
+                    }
+                    iov.push_back({static_cast<uint8_t *>(base) + skip, len - skip});
+                    skip = 0;
+                };
+                if (client.version == frame_protocol::version_2) {
+                    add(&entry.header_v2, sizeof(entry.header_v2));
+                }
+                else {
+                    add(&entry.header, sizeof(entry.header));
+                }
+                if (entry.meta_len > 0) {
+                    add(&entry.meta, entry.meta_len);
+                }
+                for (auto &chunk : entry.frame->payload()) {
+                    add(chunk.iov_base, chunk.iov_len);
+                }
+            }
+
+            struct msghdr msg = {};
+            msg.msg_iov = iov.data();
+            msg.msg_iovlen = iov.size();
+
+            ssize_t sent = sendmsg(client.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    update_events(client, true);
+                    return true;
+                }
+                return false;
+            }
+
+            client.bytes += static_cast<uint64_t>(sent);
+            bytes_sent_.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+
+            // Retire every frame that is now completely on the wire
+            size_t left = static_cast<size_t>(sent);
+            while (left > 0) {
+                auto &front = client.queue.front();
+                size_t header_len = client.version == frame_protocol::version_2 ? sizeof(front.header_v2)
+                                                                                 : sizeof(front.header);
+                size_t remaining = header_len + front.meta_len + front.frame->size() - client.offset;
+                if (left < remaining) {
+                    client.offset += left;
+                    break;
+                }
+                left -= remaining;
+                client.offset = 0;
+                if (client.sent++ == 0) {
+                    first_frame_.record(monotonic_ns() - client.connected_ns);
+                }
+                client.last_number = front.header.number;
+                client.queue.pop_front();
+            }
+        }
+
+        update_events(client, false);
+        return true;
+    }
+
+    void frame_server::update_events(client_t &client, bool want_write) {
+        if (client.want_write == want_write) {
+            return;
+        }
+
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        if (want_write) {
+            ev.events |= EPOLLOUT;
+        }
+        ev.data.fd = client.fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &ev) == 0) {
+            client.want_write = want_write;
+        }
+    }
+
+    void frame_server::close_client(int fd, const char *reason) {
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) {
+            return;
+        }
+
+        std::cout << "Client " << it->second.peer << " disconnected (" << reason << "), sent: "
+                  << it->second.sent << " dropped: " << it->second.dropped << std::endl;
+
+        if (it->second.version == 0) {
+            awaiting_hello_--;
+        }
+        if (it->second.crc) {
+            crc_clients_--;
+        }
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        clients_.erase(it);
+        client_count_.store(clients_.size(), std::memory_order_relaxed);
+        disconnects_.fetch_add(1, std::memory_order_relaxed);
+        clients_changed_ = true;
+    }
+
+};
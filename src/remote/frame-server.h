@@ -0,0 +1,212 @@
+/**
+ * @file    frame-server.h
+ * @brief   Event driven TCP server that fans frames out to every consumer
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __FRAME_SERVER_H
+#define __FRAME_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <frame-protocol.h>
+
+#include "mapped-frame.h"
+#include "metrics.h"
+
+namespace remote {
+
+    typedef frame_protocol::header_t frame_header_t;
+
+    /** @brief What to do with a client whose send queue is full */
+    enum class slow_client_policy {
+        drop_oldest,                //Discard the oldest queued frame
+        latest,                     //Discard everything queued, keep only the new frame
+        disconnect                  //Close the connection
+    };
+
+    /** @brief Which wire format versions consumers get */
+    enum class protocol_mode {
+        v1,                         //Version 1 for everyone, hellos are ignored
+        automatic,                  //Version 2 to consumers that ask for it, version 1 to those that stay silent
+        v2                          //Consumers must ask for version 2
+    };
+
+    /** @brief What the version 2 header says about a frame, see frame_server::broadcast() */
+    typedef struct {
+        uint32_t format;            //frame_protocol::format_t
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;            //Raw formats only
+        uint32_t stream_id;
+        uint64_t pts;
+        bool keyframe;
+    } frame_info_t;
+
+    /** @brief What one consumer got so far, see frame_server::client_stats() */
+    typedef struct {
+        std::string peer;
+        size_t queued;              //Frames waiting in its send queue
+        int64_t lag;                //Frames broadcast since the last one it fully received
+        uint64_t sent;
+        uint64_t dropped;
+        uint64_t bytes;
+    } client_stats_t;
+
+    bool parse_slow_client_policy(const std::string &name, slow_client_policy &policy);
+    const char *slow_client_policy_name(slow_client_policy policy);
+    bool parse_protocol_mode(const std::string &name, protocol_mode &mode);
+    const char *protocol_mode_name(protocol_mode mode);
+
+    /**
+     * @brief Non-blocking epoll server. Every consumer gets its own bounded
+     *        send queue of shared frames, so one mapped sample is written to
+     *        all clients without copies and a slow client only affects itself.
+     *
+     * Not thread safe: poll() and broadcast() must run on the same thread.
+     */
+    class frame_server {
+    public:
+        frame_server(uint16_t port, size_t client_queue, slow_client_policy policy);
+        ~frame_server();
+
+        frame_server(const frame_server &) = delete;
+        frame_server &operator=(const frame_server &) = delete;
+
+        /** @brief Bind, listen and create the epoll set */
+        bool start();
+
+        /**
+         * @brief Also wake poll() when fd becomes readable, e.g. an
+         *        event_notifier signalled by the frame producer
+         */
+        bool add_wakeup_fd(int fd);
+
+        /**
+         * @brief Wait up to timeout_ms for socket events and service them
+         *
+         * @return true if the wake-up fd fired
+         */
+        bool poll(int timeout_ms);
+
+        /**
+         * @brief Queue a frame on every connected client and try to send it.
+         *        meta, when given, goes out between the header and the payload.
+         *        info fills the version 2 header, which is left mostly empty without it.
+         */
+        void broadcast(const std::shared_ptr<mapped_frame> &frame, int32_t number,
+                       const frame_protocol::meta_t *meta = nullptr, const frame_info_t *info = nullptr);
+
+        /**
+         * @brief Negotiate the wire format version. A new consumer gets no
+         *        frames until it sent a hello or hello_wait_ms passed; in
+         *        automatic mode it then falls back to version 1.
+         */
+        void set_protocol(protocol_mode mode, uint32_t hello_wait_ms) { protocol_ = mode; hello_wait_ns_ = hello_wait_ms * 1000000ull; }
+
+        /**
+         * @brief Hold the newest frame and send it to a consumer as soon as it
+         *        connects, if it is younger than max_age_ms
+         */
+        void set_replay_latest(bool replay, uint32_t max_age_ms) { replay_ = replay; replay_max_age_ns_ = max_age_ms * 1000000ull; }
+
+        // Counters are atomic so the stats reporter can read them from another thread
+        size_t client_count() const { return client_count_.load(std::memory_order_relaxed); }
+        uint64_t frames_dropped() const { return frames_dropped_.load(std::memory_order_relaxed); }
+        uint64_t disconnects() const { return disconnects_.load(std::memory_order_relaxed); }
+        uint64_t bytes_sent() const { return bytes_sent_.load(std::memory_order_relaxed); }
+        uint64_t frames_replayed() const { return frames_replayed_.load(std::memory_order_relaxed); }
+        uint64_t connects() const { return connects_.load(std::memory_order_relaxed); }
+
+        /** @brief Time from accept() to the first frame fully written, per client */
+        const cumulative_histogram &first_frame() const { return first_frame_; }
+
+        /**
+         * @brief Per client counters as of the last poll() or broadcast(),
+         *        safe to call from any thread
+         */
+        std::vector<client_stats_t> client_stats() const;
+
+    private:
+        struct pending_frame {
+            std::shared_ptr<mapped_frame> frame;
+            frame_header_t header;
+            frame_protocol::header_v2_t header_v2;
+            frame_protocol::meta_t meta;
+            size_t meta_len;        //0 or sizeof(meta)
+        };
+
+        struct client_t {
+            int fd;
+            std::string peer;
+            std::deque<pending_frame> queue;
+            size_t offset = 0;      //Bytes of queue.front() already written
+            bool want_write = false;
+            uint64_t sent = 0;
+            uint64_t dropped = 0;
+            uint64_t bytes = 0;
+            int32_t last_number = -1; //Of the last frame completely written
+            uint64_t connected_ns = 0;
+            uint16_t version = 0;   //Wire format, 0 while the hello is awaited
+            bool crc = false;       //Asked for payload CRCs
+            frame_protocol::hello_t hello = {};
+            size_t hello_len = 0;   //Bytes of hello received so far
+        };
+
+        void accept_clients();
+        void read_hello(client_t &client);
+        void expire_hellos();
+        void start_sending(client_t &client, uint16_t version);
+        void enqueue(client_t &client, const pending_frame &entry);
+        bool flush(client_t &client);
+        void update_events(client_t &client, bool want_write);
+        void close_client(int fd, const char *reason);
+        void publish_stats();
+
+        uint16_t port_;
+        size_t client_queue_;
+        slow_client_policy policy_;
+        protocol_mode protocol_ = protocol_mode::v1;
+        uint64_t hello_wait_ns_ = 0;
+        size_t awaiting_hello_ = 0;
+        size_t crc_clients_ = 0;    //Payload CRCs are only computed while someone wants them
+        uint64_t sequence_ = 0;
+
+        int listen_fd_ = -1;
+        int epoll_fd_ = -1;
+        int wakeup_fd_ = -1;
+        std::unordered_map<int, client_t> clients_;
+
+        // Newest frame for consumers that connect between two frames
+        bool replay_ = false;
+        uint64_t replay_max_age_ns_ = 0;
+        pending_frame latest_ = {};
+        uint64_t latest_ns_ = 0;
+
+        std::atomic<size_t> client_count_{0};
+        std::atomic<uint64_t> frames_dropped_{0};
+        std::atomic<uint64_t> disconnects_{0};
+        std::atomic<uint64_t> bytes_sent_{0};
+        std::atomic<uint64_t> frames_replayed_{0};
+        std::atomic<uint64_t> connects_{0};
+        cumulative_histogram first_frame_;
+
+        // Snapshot for other threads. The server thread only try_lock()s, a
+        // reader holding the lock delays the snapshot and never the frames
+        int32_t last_broadcast_ = -1;
+        uint64_t last_publish_ns_ = 0;
+        bool clients_changed_ = false;
+        mutable std::mutex stats_mtx_;
+        std::vector<client_stats_t> published_;
+    };
+
+};
+
+#endif // __FRAME_SERVER_H
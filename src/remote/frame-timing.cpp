@@ -0,0 +1,200 @@
+/**
+ * @file    frame-timing.cpp
+ * @brief   Follows every frame through the remote pipeline by its PTS
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <ctime>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "frame-timing.h"
+
+namespace remote {
+
+    // Frames still tracked when they were dropped somewhere, oldest go first
+    static constexpr size_t max_tracked = 256;
+
+    static const char *span_names[frame_timing::span_count] = {
+        "total", "decode", "encode", "appsink", "queue"
+    };
+
+    const char *frame_timing::span_name(uint32_t span) {
+        return span < span_count ? span_names[span] : "unknown";
+    }
+
+    uint64_t frame_timing::realtime_ns() {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    static GstPad *static_pad(GstElement *element, const char *name) {
+        return element != NULL ? gst_element_get_static_pad(element, name) : NULL;
+    }
+
+    bool frame_timing::attach(GstElement *pipeline, GstElement *depay, GstElement *decoder, GstElement *encoder) {
+        pipeline_ = pipeline;
+
+        struct {
+            GstElement *element;
+            const char *pad;
+            GstPadProbeCallback callback;
+        } probes[] = {
+            {depay, "sink", cb_depay_in},
+            {depay, "src", cb_depay_out},
+            {decoder, "src", cb_decoded},
+            {encoder, "src", cb_encoded},
+        };
+
+        for (auto &probe : probes) {
+            if (probe.element == NULL) {
+                continue;
+            }
+            GstPad *pad = static_pad(probe.element, probe.pad);
+            if (pad == NULL) {
+                return false;
+            }
+            gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, probe.callback, this, NULL);
+            gst_object_unref(pad);
+        }
+        return true;
+    }
+
+    frame_protocol::meta_t &frame_timing::entry(GstClockTime pts) {
+        auto it = frames_.find(pts);
+        if (it != frames_.end()) {
+            return it->second;
+        }
+        if (frames_.size() >= max_tracked) {
+            frames_.erase(frames_.begin());
+        }
+        frame_protocol::meta_t &meta = frames_[pts];
+        meta = {};
+        meta.size = sizeof(frame_protocol::meta_t);
+        meta.version = frame_protocol::meta_version;
+        meta.pts = pts;
+        return meta;
+    }
+
+    /* udpsrc stamped the packet with the running time it arrived at */
+    uint64_t frame_timing::arrival_ns(GstClockTime pts) const {
+        uint64_t now = realtime_ns();
+        GstClock *clock = pipeline_ != NULL ? gst_element_get_clock(pipeline_) : NULL;
+        if (clock == NULL) {
+            return now;
+        }
+        GstClockTime running = gst_clock_get_time(clock) - gst_element_get_base_time(pipeline_);
+        gst_object_unref(clock);
+        return running > pts ? now - (running - pts) : now;
+    }
+
+    void frame_timing::mark(GstClockTime pts, frame_protocol::stage_t stage) {
+        if (!GST_CLOCK_TIME_IS_VALID(pts)) {
+            return;
+        }
+        uint64_t now = realtime_ns();
+        std::lock_guard<std::mutex> lock(mtx_);
+        entry(pts).stage_ns[stage] = now;
+    }
+
+    void frame_timing::take(GstClockTime pts, frame_protocol::meta_t &meta) {
+        meta = {};
+        meta.size = sizeof(frame_protocol::meta_t);
+        meta.version = frame_protocol::meta_version;
+        meta.pts = GST_CLOCK_TIME_IS_VALID(pts) ? pts : frame_protocol::unknown_pts;
+        if (!GST_CLOCK_TIME_IS_VALID(pts)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = frames_.find(pts);
+        if (it != frames_.end()) {
+            meta = it->second;
+            frames_.erase(frames_.begin(), std::next(it));
+        }
+    }
+
+    void frame_timing::record(const frame_protocol::meta_t &meta) {
+        const uint64_t *t = meta.stage_ns;
+        for (uint32_t stage = 1; stage < frame_protocol::stage_count; stage++) {
+            if (t[stage - 1] != 0 && t[stage] >= t[stage - 1]) {
+                spans_[stage].record(t[stage] - t[stage - 1]);
+                totals_[stage].record(t[stage] - t[stage - 1]);
+            }
+        }
+        uint32_t last = frame_protocol::stage_count - 1;
+        if (t[0] != 0 && t[last] >= t[0]) {
+            spans_[0].record(t[last] - t[0]);
+            totals_[0].record(t[last] - t[0]);
+        }
+    }
+
+    void frame_timing::report(std::ostream &out) {
+        out << "[Latency] ms p50/p99/max";
+        for (uint32_t i = 0; i < span_count; i++) {
+            auto s = spans_[i].take_summary();
+            out << " | " << span_names[i] << " " << s.p50 / 1000.0 << "/" << s.p99 / 1000.0
+                << "/" << s.max / 1000.0;
+        }
+        out << std::endl;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    GstPadProbeReturn frame_timing::cb_depay_in(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<frame_timing *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+        if (buffer == NULL || !GST_BUFFER_PTS_IS_VALID(buffer) || !gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) {
+            return GST_PAD_PROBE_OK;
+        }
+        uint32_t rtp_ts = gst_rtp_buffer_get_timestamp(&rtp);
+        gst_rtp_buffer_unmap(&rtp);
+
+        std::lock_guard<std::mutex> lock(self->mtx_);
+        if (self->rtp_by_pts_.size() >= max_tracked) {
+            self->rtp_by_pts_.erase(self->rtp_by_pts_.begin());
+        }
+        self->rtp_by_pts_[GST_BUFFER_PTS(buffer)] = rtp_ts;
+        return GST_PAD_PROBE_OK;
+    }
+
+    /* A complete access unit, stamped with the PTS of one of its packets */
+    GstPadProbeReturn frame_timing::cb_depay_out(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<frame_timing *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        if (buffer == NULL || !GST_BUFFER_PTS_IS_VALID(buffer)) {
+            return GST_PAD_PROBE_OK;
+        }
+        GstClockTime pts = GST_BUFFER_PTS(buffer);
+        uint64_t arrival = self->arrival_ns(pts);
+
+        std::lock_guard<std::mutex> lock(self->mtx_);
+        frame_protocol::meta_t &meta = self->entry(pts);
+        meta.stage_ns[frame_protocol::stage_arrival] = arrival;
+        auto it = self->rtp_by_pts_.find(pts);
+        if (it != self->rtp_by_pts_.end()) {
+            meta.rtp_timestamp = it->second;
+            self->rtp_by_pts_.erase(self->rtp_by_pts_.begin(), std::next(it));
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstPadProbeReturn frame_timing::cb_decoded(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        if (buffer != NULL) {
+            static_cast<frame_timing *>(user_data)->mark(GST_BUFFER_PTS(buffer), frame_protocol::stage_decoded);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstPadProbeReturn frame_timing::cb_encoded(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        if (buffer != NULL) {
+            static_cast<frame_timing *>(user_data)->mark(GST_BUFFER_PTS(buffer), frame_protocol::stage_encoded);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+};
@@ -0,0 +1,87 @@
+/**
+ * @file    frame-timing.h
+ * @brief   Follows every frame through the remote pipeline by its PTS
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __FRAME_TIMING_H
+#define __FRAME_TIMING_H
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <gst/gst.h>
+#include <frame-protocol.h>
+
+#include "latency-histogram.h"
+#include "metrics.h"
+
+namespace remote {
+
+    /**
+     * @brief Records when each frame reached every stage of the pipeline.
+     *
+     * Frames are keyed by PTS, which udpsrc sets to the arrival running time
+     * of the packet and which depayloader, decoder and encoder pass on
+     * unchanged. Pad probes fill in arrival, decode and encode, the
+     * application marks the rest and take()s the result when it sends the
+     * frame. Stage times are CLOCK_REALTIME so consumers on the same host,
+     * or with a synced clock, can put their own receive time next to them.
+     */
+    class frame_timing {
+    public:
+        /** @brief Spans reported by report(), stage i - 1 to stage i, 0 = total */
+        static constexpr uint32_t span_count = frame_protocol::stage_count;
+
+        frame_timing() = default;
+
+        frame_timing(const frame_timing &) = delete;
+        frame_timing &operator=(const frame_timing &) = delete;
+
+        /**
+         * @brief Install the probes. encoder may be NULL when encoding is done
+         *        outside the pipeline, mark() stage_encoded then.
+         */
+        bool attach(GstElement *pipeline, GstElement *depay, GstElement *decoder, GstElement *encoder);
+
+        void mark(GstClockTime pts, frame_protocol::stage_t stage);
+
+        /**
+         * @brief Move what is known about frame pts into meta and forget it,
+         *        along with every older frame that was never taken
+         */
+        void take(GstClockTime pts, frame_protocol::meta_t &meta);
+
+        /** @brief Add a finished frame's stage deltas to the histograms */
+        void record(const frame_protocol::meta_t &meta);
+
+        /** @brief Print p50/p99/max per span since the last report */
+        void report(std::ostream &out);
+
+        /** @brief Every span recorded since the start, for the metrics endpoint */
+        const cumulative_histogram &total(uint32_t span) const { return totals_[span]; }
+
+        static const char *span_name(uint32_t span);
+
+        static uint64_t realtime_ns();
+
+    private:
+        static GstPadProbeReturn cb_depay_in(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static GstPadProbeReturn cb_depay_out(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static GstPadProbeReturn cb_decoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        static GstPadProbeReturn cb_encoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+        frame_protocol::meta_t &entry(GstClockTime pts);
+        uint64_t arrival_ns(GstClockTime pts) const;
+
+        GstElement *pipeline_ = NULL;
+        std::mutex mtx_;
+        std::map<GstClockTime, uint32_t> rtp_by_pts_;       // Packets seen by the depayloader
+        std::map<GstClockTime, frame_protocol::meta_t> frames_;
+        latency_histogram spans_[span_count];
+        cumulative_histogram totals_[span_count];
+    };
+
+};
+
+#endif // __FRAME_TIMING_H
@@ -0,0 +1,103 @@
+/**
+ * @file    latency-histogram.h
+ * @brief   Lock-free log-linear latency histogram with percentile queries
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Values are bucketed in microseconds: exact below 16 us, then 16 linear
+ * buckets per power of two, so any percentile is within about 6% of the
+ * real value. Anything above ~67 s lands in the last bucket. record() is a
+ * couple of relaxed atomic adds and can be called from any thread.
+ */
+#ifndef __LATENCY_HISTOGRAM_H
+#define __LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace remote {
+
+    class latency_histogram {
+    public:
+        static constexpr uint32_t sub_buckets = 16;
+        static constexpr uint32_t max_exponent = 26;
+        static constexpr uint32_t bucket_count = sub_buckets * (max_exponent - 2);
+
+        /** @brief Percentiles of one reporting window, in microseconds */
+        typedef struct {
+            uint64_t count;
+            uint64_t p50;
+            uint64_t p99;
+            uint64_t max;
+        } summary_t;
+
+        void record(uint64_t value_ns) {
+            uint64_t us = value_ns / 1000;
+            buckets_[index(us)].fetch_add(1, std::memory_order_relaxed);
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while (us > max && !max_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+            }
+        }
+
+        /** @brief Percentiles since the last call, then start a new window */
+        summary_t take_summary() {
+            std::array<uint64_t, bucket_count> counts;
+            summary_t summary = {0, 0, 0, max_.exchange(0, std::memory_order_relaxed)};
+            for (uint32_t i = 0; i < bucket_count; i++) {
+                counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+                summary.count += counts[i];
+            }
+            summary.p50 = percentile(counts, summary.count, 0.50);
+            summary.p99 = percentile(counts, summary.count, 0.99);
+            // Bucket bounds are approximate, never report past the real max
+            if (summary.p50 > summary.max) summary.p50 = summary.max;
+            if (summary.p99 > summary.max) summary.p99 = summary.max;
+            return summary;
+        }
+
+    private:
+        static uint32_t index(uint64_t us) {
+            if (us < sub_buckets) {
+                return static_cast<uint32_t>(us);
+            }
+            uint32_t exponent = 63 - __builtin_clzll(us);     // >= 4
+            if (exponent > max_exponent) {
+                return bucket_count - 1;
+            }
+            uint32_t sub = static_cast<uint32_t>(us >> (exponent - 4)) & (sub_buckets - 1);
+            return sub_buckets * (exponent - 3) + sub;
+        }
+
+        /** @brief Upper bound of bucket i, in microseconds */
+        static uint64_t upper_bound(uint32_t i) {
+            if (i < sub_buckets) {
+                return i;
+            }
+            uint32_t exponent = i / sub_buckets + 3;
+            uint64_t sub = i % sub_buckets;
+            return ((sub_buckets + sub + 1) << (exponent - 4)) - 1;
+        }
+
+        static uint64_t percentile(const std::array<uint64_t, bucket_count> &counts, uint64_t total, double p) {
+            if (total == 0) {
+                return 0;
+            }
+            uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+            uint64_t seen = 0;
+            for (uint32_t i = 0; i < bucket_count; i++) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return upper_bound(i);
+                }
+            }
+            return upper_bound(bucket_count - 1);
+        }
+
+        std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+        std::atomic<uint64_t> max_{0};
+    };
+
+};
+
+#endif // __LATENCY_HISTOGRAM_H
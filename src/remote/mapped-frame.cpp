@@ -0,0 +1,70 @@
+/**
+ * @file    mapped-frame.cpp
+ * @brief   Read-only view of a GstSample payload for scatter-gather sends
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include "mapped-frame.h"
+
+namespace remote {
+
+    // Above this many memory blocks the buffer is mapped as a whole, which
+    // makes GStreamer merge (copy) them, but keeps the iovec list bounded
+    static constexpr guint max_mapped_memories = 16;
+
+    mapped_frame::mapped_frame(GstSample *sample) : sample_(sample) {
+        if (sample_ == NULL) {
+            return;
+        }
+        buffer_ = gst_sample_get_buffer(sample_);
+        if (buffer_ == NULL) {
+            return;
+        }
+
+        guint n_memory = gst_buffer_n_memory(buffer_);
+        if (n_memory > max_mapped_memories) {
+            GstMapInfo info;
+            if (!gst_buffer_map(buffer_, &info, GST_MAP_READ)) {
+                return;
+            }
+            merged_ = true;
+            maps_.push_back(info);
+        }
+        else {
+            maps_.reserve(n_memory);
+            for (guint i = 0; i < n_memory; i++) {
+                GstMapInfo info;
+                if (!gst_memory_map(gst_buffer_peek_memory(buffer_, i), &info, GST_MAP_READ)) {
+                    return;
+                }
+                maps_.push_back(info);
+            }
+        }
+
+        iov_.reserve(maps_.size());
+        for (auto &info : maps_) {
+            if (info.size == 0) {
+                continue;
+            }
+            iov_.push_back({info.data, info.size});
+            size_ += info.size;
+        }
+        valid_ = true;
+    }
+
+    mapped_frame::~mapped_frame() {
+        if (merged_) {
+            gst_buffer_unmap(buffer_, &maps_.front());
+        }
+        else {
+            for (auto &info : maps_) {
+                gst_memory_unmap(info.memory, &info);
+            }
+        }
+        if (sample_ != NULL) {
+            gst_sample_unref(sample_);
+        }
+    }
+
+};
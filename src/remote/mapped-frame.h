@@ -0,0 +1,51 @@
+/**
+ * @file    mapped-frame.h
+ * @brief   Read-only view of a GstSample payload for scatter-gather sends
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __MAPPED_FRAME_H
+#define __MAPPED_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/uio.h>
+#include <gst/gst.h>
+
+namespace remote {
+
+    /**
+     * @brief Owns one reference to a GstSample and keeps every GstMemory of its
+     *        buffer mapped for reading, so the payload can go to the socket
+     *        without being copied. Unmaps and unrefs on destruction.
+     */
+    class mapped_frame {
+    public:
+        explicit mapped_frame(GstSample *sample);
+        ~mapped_frame();
+
+        mapped_frame(const mapped_frame &) = delete;
+        mapped_frame &operator=(const mapped_frame &) = delete;
+
+        bool valid() const { return valid_; }
+        size_t size() const { return size_; }
+        GstBuffer *buffer() const { return buffer_; }
+        GstSample *sample() const { return sample_; }
+
+        /** @brief One iovec per mapped memory block, in payload order */
+        const std::vector<struct iovec> &payload() const { return iov_; }
+
+    private:
+        GstSample *sample_;
+        GstBuffer *buffer_ = nullptr;
+        std::vector<GstMapInfo> maps_;
+        std::vector<struct iovec> iov_;
+        size_t size_ = 0;
+        bool merged_ = false;
+        bool valid_ = false;
+    };
+
+};
+
+#endif // __MAPPED_FRAME_H
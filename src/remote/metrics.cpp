@@ -0,0 +1,198 @@
+/**
+ * @file    metrics.cpp
+ * @brief   Prometheus text format metrics served over HTTP
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+namespace remote {
+
+    const uint64_t cumulative_histogram::bounds_ns[bound_count] = {
+        500000, 1000000, 2500000, 5000000, 10000000, 25000000,
+        50000000, 100000000, 250000000, 500000000, 1000000000
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /* Counters print as integers, everything else with full precision */
+    static void write_value(std::ostream &out, double value) {
+        if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+            out << static_cast<int64_t>(value);
+        }
+        else {
+            char text[32];
+            snprintf(text, sizeof(text), "%.17g", value);
+            out << text;
+        }
+    }
+
+    void metrics_writer::family(const char *name, const char *type, const char *help) {
+        out_ << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+
+    void metrics_writer::sample(const char *name, double value, const std::string &labels) {
+        out_ << name;
+        if (!labels.empty()) {
+            out_ << "{" << labels << "}";
+        }
+        out_ << " ";
+        write_value(out_, value);
+        out_ << "\n";
+    }
+
+    void metrics_writer::histogram(const char *name, const cumulative_histogram &histogram, const std::string &labels) {
+        const std::string prefix = labels.empty() ? "" : labels + ",";
+        const std::string bucket = std::string(name) + "_bucket";
+        uint64_t count = 0;
+        for (size_t i = 0; i < cumulative_histogram::bound_count; i++) {
+            count += histogram.bucket(i);
+            char le[32];
+            snprintf(le, sizeof(le), "%g", cumulative_histogram::bounds_ns[i] / 1e9);
+            sample(bucket.c_str(), count, prefix + label("le", le));
+        }
+        count += histogram.bucket(cumulative_histogram::bound_count);
+        sample(bucket.c_str(), count, prefix + label("le", "+Inf"));
+        sample((std::string(name) + "_sum").c_str(), histogram.sum_ns() / 1e9, labels);
+        sample((std::string(name) + "_count").c_str(), count, labels);
+    }
+
+    std::string metrics_writer::label(const char *key, const std::string &value) {
+        std::string text = std::string(key) + "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                text += '\\';
+                text += c;
+            }
+            else if (c == '\n') {
+                text += "\\n";
+            }
+            else {
+                text += c;
+            }
+        }
+        return text + "\"";
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    metrics_server::metrics_server(uint16_t port, collect_fn collect)
+        : port_(port), collect_(std::move(collect)) {}
+
+    metrics_server::~metrics_server() {
+        running_.store(false);
+        if (listen_fd_ >= 0) {
+            // Wakes accept() up
+            shutdown(listen_fd_, SHUT_RDWR);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (listen_fd_ >= 0) {
+            close(listen_fd_);
+        }
+    }
+
+    bool metrics_server::start() {
+        struct sockaddr_in server_addr = {};
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0) {
+            perror("socket failed");
+            return false;
+        }
+
+        int on = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port_);
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+
+        if (bind(listen_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            perror("bind failed");
+            return false;
+        }
+        if (listen(listen_fd_, 8) < 0) {
+            perror("listen");
+            return false;
+        }
+
+        running_.store(true);
+        thread_ = std::thread(&metrics_server::run, this);
+        std::cout << "Metrics on http://0.0.0.0:" << port_ << "/metrics" << std::endl;
+        return true;
+    }
+
+    void metrics_server::run() {
+        while (running_.load()) {
+            int fd = accept4(listen_fd_, NULL, NULL, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno != EINTR && running_.load()) {
+                    perror("accept");
+                }
+                continue;
+            }
+            serve(fd);
+            close(fd);
+        }
+    }
+
+    /* One request per connection, a scraper that stalls is cut off after a second */
+    void metrics_server::serve(int fd) {
+        struct timeval timeout = {1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // Only the request line matters, the headers are not read to the end
+        char request[1024];
+        size_t got = 0;
+        while (got < sizeof(request) - 1 && memchr(request, '\n', got) == NULL) {
+            ssize_t n = recv(fd, request + got, sizeof(request) - 1 - got, 0);
+            if (n <= 0) {
+                return;
+            }
+            got += static_cast<size_t>(n);
+        }
+        request[got] = '\0';
+
+        std::ostringstream body;
+        const char *status = "200 OK";
+        if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+            metrics_writer writer(body);
+            collect_(writer);
+        }
+        else {
+            status = "404 Not Found";
+            body << "Only GET /metrics is served\n";
+        }
+
+        const std::string content = body.str();
+        std::ostringstream response;
+        response << "HTTP/1.1 " << status << "\r\n"
+                 << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                 << "Content-Length: " << content.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << content;
+        const std::string out = response.str();
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+};
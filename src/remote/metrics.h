@@ -0,0 +1,102 @@
+/**
+ * @file    metrics.h
+ * @brief   Prometheus text format metrics served over HTTP
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * The pipeline only bumps relaxed atomics; everything is read and formatted
+ * on the metrics thread when Prometheus scrapes, so an idle endpoint costs
+ * nothing and a scrape never blocks a streaming thread.
+ */
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace remote {
+
+    /**
+     * @brief Durations in fixed buckets that only ever grow, as a Prometheus
+     *        histogram wants. record() is lock-free and callable from any thread.
+     */
+    class cumulative_histogram {
+    public:
+        static constexpr size_t bound_count = 11;
+        static const uint64_t bounds_ns[bound_count];   // Upper bounds, +Inf is implicit
+
+        void record(uint64_t value_ns) {
+            size_t i = 0;
+            while (i < bound_count && value_ns > bounds_ns[i]) {
+                i++;
+            }
+            buckets_[i].fetch_add(1, std::memory_order_relaxed);
+            sum_ns_.fetch_add(value_ns, std::memory_order_relaxed);
+        }
+
+        /** @brief Values in bucket i alone, i == bound_count is the overflow */
+        uint64_t bucket(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+        uint64_t sum_ns() const { return sum_ns_.load(std::memory_order_relaxed); }
+
+    private:
+        std::array<std::atomic<uint64_t>, bound_count + 1> buckets_{};
+        std::atomic<uint64_t> sum_ns_{0};
+    };
+
+    /** @brief Writes one scrape in the Prometheus text exposition format */
+    class metrics_writer {
+    public:
+        explicit metrics_writer(std::ostream &out) : out_(out) {}
+
+        /** @brief HELP and TYPE lines, once before the samples of a metric */
+        void family(const char *name, const char *type, const char *help);
+
+        /** @brief labels is empty or a list made with label(), e.g. stream="0" */
+        void sample(const char *name, double value, const std::string &labels = "");
+
+        /** @brief _bucket, _sum and _count samples, in seconds */
+        void histogram(const char *name, const cumulative_histogram &histogram, const std::string &labels = "");
+
+        /** @brief key="value" with value escaped */
+        static std::string label(const char *key, const std::string &value);
+
+    private:
+        std::ostream &out_;
+    };
+
+    /**
+     * @brief Minimal HTTP server for GET /metrics, one connection at a time
+     *        on its own thread. collect runs for every scrape.
+     */
+    class metrics_server {
+    public:
+        typedef std::function<void(metrics_writer &)> collect_fn;
+
+        metrics_server(uint16_t port, collect_fn collect);
+        ~metrics_server();
+
+        metrics_server(const metrics_server &) = delete;
+        metrics_server &operator=(const metrics_server &) = delete;
+
+        /** @brief Bind, listen and start serving */
+        bool start();
+
+    private:
+        void run();
+        void serve(int fd);
+
+        uint16_t port_;
+        collect_fn collect_;
+        int listen_fd_ = -1;
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+    };
+
+};
+
+#endif // __METRICS_H
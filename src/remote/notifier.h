@@ -0,0 +1,70 @@
+/**
+ * @file    notifier.h
+ * @brief   eventfd based wake-up from a producer thread to a poll loop
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __NOTIFIER_H
+#define __NOTIFIER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace remote {
+
+    /**
+     * @brief The producer calls notify() after publishing work, the consumer
+     *        either blocks in wait() or adds fd() to its own epoll set and
+     *        calls drain() when it becomes readable. Wake-ups coalesce, so
+     *        the consumer must empty its queue after every one.
+     */
+    class event_notifier {
+    public:
+        event_notifier() : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+        ~event_notifier() {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+        }
+
+        event_notifier(const event_notifier &) = delete;
+        event_notifier &operator=(const event_notifier &) = delete;
+
+        bool valid() const { return fd_ >= 0; }
+        int fd() const { return fd_; }
+
+        void notify() {
+            uint64_t one = 1;
+            while (write(fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+            }
+        }
+
+        void drain() {
+            uint64_t count;
+            while (read(fd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+            }
+        }
+
+        /** @brief Block until notified or timeout_ms elapses (-1 waits forever) */
+        bool wait(int timeout_ms) {
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            int n;
+            while ((n = ::poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+            }
+            if (n <= 0) {
+                return false;
+            }
+            drain();
+            return true;
+        }
+
+    private:
+        int fd_;
+    };
+
+};
+
+#endif // __NOTIFIER_H
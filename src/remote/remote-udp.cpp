@@ -47,6 +47,7 @@ gst-launch-1.0 udpsrc port={self._port} ! application/x-rtp, encoding-name=H264,
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>   //For appsink
 #include <utils.h>
+#include <udp-frame.h>
 #include <thread>                 //For thread
 #include <iomanip>                //For setfill
 #include <sstream>                //For stringstream
@@ -55,9 +56,16 @@ gst-launch-1.0 udpsrc port={self._port} ! application/x-rtp, encoding-name=H264,
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>               //For write
+
+#include "frame-queue.h"
+#include "mapped-frame.h"
+#include "notifier.h"
 ////////////////////////////////////////////////////////////////////////////////
-#define SERVER_PORT_DATA      4008 //htons??
+#define SERVER_PORT_DATA      4008  //Default, override with GST_REMOTE_UDP_PORT
 #define SERVER_PORT_HANDSHAKE 4008
+#define FRAME_QUEUE_CAPACITY  8     //Default, override with GST_REMOTE_QUEUE_CAPACITY
+#define UDP_DEST_HOST         "127.0.0.1" //Default, override with GST_REMOTE_UDP_HOST
+#define UDP_MTU               1500  //Default, override with GST_REMOTE_UDP_MTU
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef struct {
@@ -71,13 +79,16 @@ typedef struct {
   GstCaps    *filtercaps;
 } pipeline_t;
 
-pipeline_t p;                       //Accessed by the thread
-std::vector<uint8_t> appsinkbuffer;
-std::vector<uint32_t> buffersize;
+typedef struct {
+  GstSample *sample;                //Owned by the slot until the socket thread sends it
+} frame_t;
 
-pthread_mutex_t mtx_buff;
+pipeline_t p;                       //Accessed by the thread
+remote::frame_queue<frame_t> *frames; //appsink_thread -> socket_thread
+remote::event_notifier *frames_ready; //Wakes socket_thread when a frame is queued
 std::thread appsink_thread, socket_thread;
 bool m_isRunning = true;
+struct sockaddr_in dest_addr;       //Where the frames go, read from the environment in main
 
 ////////////////////////////////////////////////////////////////////////////////
 int main (int argc, char *argv[])
@@ -108,6 +119,29 @@ int main (int argc, char *argv[])
     exit(EXIT_FAILURE);
   }
 
+  std::string dest_host = UDP_DEST_HOST;
+  auto dest_host_str = std::getenv("GST_REMOTE_UDP_HOST");
+  if (dest_host_str != nullptr) {
+    dest_host = dest_host_str;
+  }
+  auto dest_port = utils::get_env_ulong("GST_REMOTE_UDP_PORT", SERVER_PORT_DATA);
+  dest_addr = {};
+  dest_addr.sin_family = AF_INET;
+  dest_addr.sin_port = htons(dest_port);
+  if (dest_port == 0 || dest_port > utils::port_range_max || !utils::validate_ip(dest_host) ||
+      inet_pton(AF_INET, dest_host.c_str(), &dest_addr.sin_addr) != 1) {
+    std::cout << "Not valid GST_REMOTE_UDP_HOST / GST_REMOTE_UDP_PORT. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cout << "Sending frames to: " << dest_host << ":" << dest_port << std::endl;
+
+  frames = new remote::frame_queue<frame_t>(utils::get_env_ulong("GST_REMOTE_QUEUE_CAPACITY", FRAME_QUEUE_CAPACITY));
+  frames_ready = new remote::event_notifier();
+  if (!frames_ready->valid()) {
+    perror("eventfd");
+    exit(EXIT_FAILURE);
+  }
+
   /* Initialize GStreamer */
   gst_init (&argc, &argv);
 
@@ -165,35 +199,19 @@ int main (int argc, char *argv[])
           GstBuffer * buffer  = gst_sample_get_buffer (sample);
           if (buffer == NULL)
           {
+            gst_sample_unref(sample);
             continue;
           }
-          gsize datalen = gst_buffer_get_size(buffer);
-          // Extract buffer
-          uint8_t *rawData = (uint8_t *) malloc(datalen);
-          if (rawData == NULL) {
-            std::cout << " build_pipeline() allocation fails" << std::endl;
-            return false;
+          //Hand the sample over without copying, drop it if the socket thread is behind
+          frame_t *slot = frames->producer_slot();
+          if (slot != NULL) {
+            slot->sample = sample;
+            frames->push_commit();
+            frames_ready->notify();
+          }
+          else {
+            gst_sample_unref(sample);
           }
-          memset(rawData, 0, datalen);
-          gst_buffer_extract(buffer, 0, rawData, datalen);
-          //Append to a local buffer
-          pthread_mutex_lock(&mtx_buff);
-          appsinkbuffer.insert( appsinkbuffer.end(), rawData, rawData + datalen );
-          buffersize.push_back(datalen);
-          pthread_mutex_unlock(&mtx_buff);
-          ////////////////////////////////////
-          // //Write to files
-          // FILE* pFile;
-          // std::stringstream filename;
-          // std::string fname;
-          // filename << "file_" << std::setw(2) << std::setfill('0') << filecount << ".raw";
-          // fname = std::string (filename.str());
-          // pFile = fopen(fname.c_str(), "wb");
-          // fwrite(rawData, datalen, 1, pFile);
-          // fclose(pFile);
-          ////////////////////////////////////
-          free(rawData);
-          gst_sample_unref(sample);
           filecount++;
         }
       }
@@ -215,81 +233,45 @@ int main (int argc, char *argv[])
   {
     socket_thread = std::thread([]() 
     {
-      //Socket
-      int server_socket, client_fd;
-      struct sockaddr_in server_addr, client_addr;
-
-      // Creating socket file descriptor
-      // if ((server_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-      if ((server_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+      int client_fd;
+      if ((client_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP)) < 0) {
           perror("socket failed");
           exit(EXIT_FAILURE);
       }
-      
-      server_addr.sin_family = AF_INET;
-      server_addr.sin_port = htons(SERVER_PORT_DATA);
-      server_addr.sin_addr.s_addr = INADDR_ANY;
-
-      // if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-      //     perror("bind failed");
-      //     exit(EXIT_FAILURE);
-      // }
-      // if (listen(server_socket, 1) < 0) {
-      //     perror("listen");
-      //     exit(EXIT_FAILURE);
-      // }
-
-      // socklen_t sin_size=sizeof(client_addr);
-      // client_fd=accept(server_socket,(struct sockaddr*)&client_addr, &sin_size);
-      // //std::cout << "client_fd:" << client_fd << std::endl;
-
-      // if (client_fd < 0) {
-      //   perror("accept");
-      //   exit(EXIT_FAILURE);
-      // };
 
-      client_fd = server_socket;
-      printf("Got connection from %s port %d\n", inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+      //Every frame goes out as MTU sized chunks, see common/udp-frame.h
+      udp_frame::sender sender(client_fd, dest_addr,
+          utils::get_env_ulong("GST_REMOTE_UDP_MTU", UDP_MTU),
+          utils::get_env_ulong("GST_REMOTE_UDP_GSO", 0) != 0);
+      //Parity chunks, in percent of the data chunks of every frame
+      sender.set_fec(utils::get_env_ulong("GST_REMOTE_UDP_FEC", 0));
+      std::cout << "Chunk payload: " << sender.chunk_payload() << " bytes"
+                << (sender.gso() ? ", UDP GSO" : ", sendmmsg")
+                << ", FEC overhead: " << sender.fec() << "%" << std::endl;
 
       int filecount2 = 0;
       std::cout << "------ START Socket Thread ------" << std::endl;
-      uint32_t datalen2=0;
-      uint8_t *rawData2;
       while (true){
-        datalen2=0;
+        //Sleep until the appsink thread queues a frame
+        frames_ready->wait(-1);
+
         //////////////////////////////
-        //Extract from a local buffer                                                                                                                    
-        pthread_mutex_lock(&mtx_buff);
-        if ( ! buffersize.empty()) {
-          datalen2=buffersize.front();
-          buffersize.erase(buffersize.begin(),buffersize.begin()+1);
-        }
-        if (datalen2 != 0) {
-          rawData2 = (uint8_t *) malloc(datalen2);
-          memset(rawData2, 0, datalen2);
-          rawData2=appsinkbuffer.data();
-          std::cout << "[Socket Thread] frame:" << filecount2 << " lenght: " << datalen2 << std::endl;
-          appsinkbuffer.erase( appsinkbuffer.begin(), appsinkbuffer.begin() + datalen2 );
-          //Send Frame Number, Frame Lenght and Frame
-          sendto(client_fd, &(filecount2), sizeof(filecount2),0, reinterpret_cast<const sockaddr*>(&server_addr), sizeof(server_addr));
-          sendto(client_fd, &(datalen2), sizeof(datalen2),0, reinterpret_cast<const sockaddr*>(&server_addr), sizeof(server_addr));
-          sendto(client_fd, rawData2, datalen2, 0, reinterpret_cast<const sockaddr*>(&server_addr), sizeof(server_addr));
-          //std::cout << "Sent: Frame: "<< filecount2 << "[" << sizeof(filecount2) << "] with lenght: " << datalen2 << "[" << sizeof(datalen2) << "]" << std::endl;
+        //Extract from the frame queue
+        frame_t *frame;
+        while ((frame = frames->front()) != NULL) {
+          remote::mapped_frame mapped(frame->sample);
+          frame->sample = NULL;
+          frames->pop_release();
+          if (!mapped.valid()) {
+            continue;
+          }
+          std::cout << "[Socket Thread] frame:" << filecount2 << " lenght: " << mapped.size()
+                    << " datagrams: " << sender.datagrams_sent() << " parity: " << sender.parity_sent() << " errors: " << sender.send_errors() << std::endl;
+          //Frame number and length travel in every chunk header
+          sender.send(filecount2, mapped.payload(), mapped.size());
           filecount2++;
         }
-        pthread_mutex_unlock(&mtx_buff);
-        //////////////////////////////  
-        // //Write to files
-        // FILE* pFile;
-        // std::stringstream filename;
-        // std::string fname;
-        // filename << "file_" << std::setw(2) << std::setfill('0') << filecount2 << ".jpg";
-        // fname = std::string (filename.str());
-        // pFile = fopen(fname.c_str(), "wb");
-        // fwrite(rawData2, datalen2, 1, pFile);
-        // fclose(pFile);
         //////////////////////////////  
-        g_usleep(100000);
       }
       std::cout << "------ END Socket Thread ------" << std::endl;
       return true;
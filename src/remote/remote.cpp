@@ -46,11 +46,19 @@ gst-launch-1.0 udpsrc port={self._port} ! application/x-rtp, encoding-name=H264,
 #include <string>
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>   //For appsink
+#include <gst/video/video.h>      //For raw frame layout
 #include <utils.h>
+#include <shm-ring.h>
+#include <gst-profiler.h>
+#include <startup.h>
 #include <thread>                 //For thread
 #include <iomanip>                //For setfill
 #include <sstream>                //For stringstream
 #include <vector>                 //For vector
+#include <algorithm>              //For max
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -58,29 +66,870 @@ gst-launch-1.0 udpsrc port={self._port} ! application/x-rtp, encoding-name=H264,
 
 #include <cstdlib>                // get port from OS environment var
 
+#include "frame-queue.h"
+#include "mapped-frame.h"
+#include "frame-server.h"
+#include "stage-stats.h"
+#include "notifier.h"
+#include "encode-pool.h"
+#include "frame-timing.h"
+#include "frame-decimator.h"
+#include "tensor-preprocess.h"
+#include "rtp-ingest.h"
+#include "rtcp-session.h"
+#include "metrics.h"
+
 ////////////////////////////////////////////////////////////////////////////////
 #define SERVER_PORT_HANDSHAKE 4008
+#define FRAME_QUEUE_CAPACITY  8     //Default, override with GST_REMOTE_QUEUE_CAPACITY
+#define CLIENT_QUEUE_CAPACITY 4     //Default, override with GST_REMOTE_CLIENT_QUEUE
+#define DROP_QUEUE_CAPACITY   2     //Default, override with GST_REMOTE_DROP_QUEUE
+#define STATS_INTERVAL_S      5     //Default, override with GST_REMOTE_STATS_INTERVAL (0 = off)
+#define SHM_RING_NAME         "/gst-remote-frames" //Default, override with GST_REMOTE_SHM_NAME
+#define SHM_RING_SLOTS        4     //Default, override with GST_REMOTE_SHM_SLOTS
+#define SHM_RAW_FORMAT        "BGR" //Default, override with GST_REMOTE_SHM_FORMAT
+#define ENCODE_THREADS        1     //Default, override with GST_REMOTE_ENCODE_THREADS (1 = inline jpegenc)
+#define TARGET_FPS            0     //Default, override with GST_REMOTE_TARGET_FPS (0 = every frame)
+#define MAX_STREAMS           64    //Default, override with GST_REMOTE_MAX_STREAMS
+#define JITTER_LATENCY_MS     20    //Default, override with GST_REMOTE_JITTER_LATENCY (0 = no jitter buffer)
+#define UDP_RCVBUF            (4 * 1024 * 1024) //Default, override with GST_REMOTE_RCVBUF (0 = kernel default)
+#define RTCP_FEEDBACK         1     //Default, override with GST_REMOTE_RTCP (0 = plain RTP, no receiver reports)
+#define METRICS_PORT          9464  //Default, override with GST_REMOTE_METRICS_PORT (0 = off)
+#define KEYFRAME_REQUESTS     1     //Default, override with GST_REMOTE_KEYFRAME_REQUESTS (0 = wait for the sender's keyframes)
+#define KEYFRAME_WAIT_MS      100   //No frame this long after a stream's first packet: ask for a keyframe
+#define REPLAY_MAX_AGE_MS     1000  //Default, override with GST_REMOTE_REPLAY_AGE
+#define PROTOCOL_MODE         "auto" //Default, override with GST_REMOTE_PROTOCOL (1, auto, 2)
+#define HELLO_WAIT_MS         100   //Default, override with GST_REMOTE_HELLO_WAIT
+#define TRACE_SECONDS         10    //Default, override with GST_REMOTE_TRACE_SECONDS (0 = until exit)
+#define REGISTRY_CACHE        "/var/cache/gstreamer/registry.bin" //Fast start registry, unless GST_REGISTRY is set
+#define TENSOR_SIZE           640   //Default, override with GST_REMOTE_TENSOR_SIZE
+#define TENSOR_PAD            114   //Default, override with GST_REMOTE_TENSOR_PAD (YOLO grey)
 ////////////////////////////////////////////////////////////////////////////////
 
 typedef struct {
   GstElement *pipeline;
-  GstElement *source;
-  GstElement *enc_img;
+  GstElement *source;               //Shared udpsrc when streams are told apart by SSRC
+  GstElement *ssrc_demux;           //rtpssrcdemux after the shared udpsrc
+  remote::rtcp_receiver *rtcp;      //RTP session of the shared udpsrc
+  GstElement *funnel;               //Joins the stream branches, only with more than one stream
   GstElement *sink;
-  GstElement *conv;
-  GstElement *h264dec;
-  GstElement *rtp_dec;
-  GstCaps    *filtercaps;
 } pipeline_t;
 
+/* One incoming RTP stream and its decode branch, up to the funnel */
+typedef struct {
+  guint id;                         //Index in streams, sent as the frame's stream id
+  guint16 port;                     //Own udpsrc port, 0 for streams split by SSRC
+  guint32 ssrc;
+  GstElement *source;               //NULL for streams split by SSRC
+  GstElement *input_queue;          //Own streaming thread for streams split by SSRC
+  remote::rtcp_receiver *rtcp;      //RTP session of the own udpsrc, sends the receiver reports
+  GstElement *jitterbuffer;         //Reorders packets and gives up on lost ones after the latency
+  remote::rtp_ingest *ingest;       //Reorder and loss counters of the incoming packets
+  GstElement *rtp_dec;
+  GstElement *h264dec;
+  GstElement *conv;
+  GstElement *drop_queue;           //Leaky queue, only in bounded backpressure mode
+  GstElement *last_stage;           //jpegenc, the shm capsfilter, or NULL with the encode pool
+  remote::frame_timing *timing;     //Keyed by PTS, which is only unique within one stream
+  remote::frame_decimator *decimator; //Cuts the rate around the decoder with GST_REMOTE_TARGET_FPS
+  std::atomic<uint64_t> frames{0};  //Handed over to the socket thread or the ring
+  std::atomic<uint64_t> first_packet_ns{0}; //Steady clock, for the time to the first frame
+  std::atomic<bool> decoded{false}; //avdec_h264 put out a frame, set even when idle skip drops it later
+} stream_t;
+
+typedef enum {
+  BACKPRESSURE_NONE,                //Unbounded appsink, frames only dropped when the frame queue is full
+  BACKPRESSURE_LATEST,              //Only the newest encoded frame is kept for the consumer
+  BACKPRESSURE_BOUNDED              //Leaky queue at the drop point plus a bounded appsink
+} backpressure_t;
+
+typedef enum {
+  DROP_POINT_CONVERT,               //Before autovideoconvert
+  DROP_POINT_ENCODE                 //Before jpegenc
+} drop_point_t;
+
+typedef enum {
+  OUTPUT_JPEG,                      //jpegenc frames to the TCP frame server
+  OUTPUT_SHM,                       //Decoded raw frames to a shared-memory ring
+  OUTPUT_TENSOR                     //Letterboxed planar float tensors to the TCP frame server
+} output_t;
+
+typedef enum {
+  IDLE_REPLAY,                      //Keep encoding, a new consumer gets the newest frame right away
+  IDLE_SKIP                         //No consumer: decoded frames are dropped before conversion
+} idle_policy_t;
+
+typedef struct {
+  GstSample *sample;                //Owned by the slot until the socket thread sends it
+  guint stream;
+} frame_t;
+
 pipeline_t p;                       //Accessed by the thread
-std::vector<uint8_t> appsinkbuffer;
-std::vector<uint32_t> buffersize;
+remote::frame_queue<frame_t> *frames; //appsink_thread -> socket_thread
+remote::event_notifier *frames_ready; //Wakes socket_thread out of epoll_wait
+remote::frame_server *server;       //Polled by socket_thread, counters read by print_stats
+backpressure_t backpressure = BACKPRESSURE_NONE;
+drop_point_t drop_point = DROP_POINT_ENCODE;
+guint drop_queue_capacity = DROP_QUEUE_CAPACITY;
+output_t output = OUTPUT_JPEG;
+idle_policy_t idle_policy = IDLE_REPLAY;
+std::string shm_format = SHM_RAW_FORMAT;
+shm_ring::ring_writer *shm_writer;  //Written by appsink_thread in shm output mode
+remote::encode_pool *encoder;       //Takes the place of jpegenc with GST_REMOTE_ENCODE_THREADS > 1
+remote::frame_timing *timing;       //Latency of every stream's frames, jpeg output only
+remote::tensor_preprocessor *tensor; //Used by appsink_thread only, shared by every stream
+GstBufferPool *tensor_pool;         //Tensor blobs go back here once every client sent them
+GstCaps *tensor_caps;               //Tell the socket thread a blob from a JPEG
+bool send_frame_meta = false;       //GST_REMOTE_FRAME_META=1 adds the meta block to the wire
+unsigned long target_fps = TARGET_FPS;
+unsigned long decode_threads = 0;   //avdec_h264 max-threads, 0 = one per core
+unsigned long jitter_latency = JITTER_LATENCY_MS;
+unsigned long udp_rcvbuf = UDP_RCVBUF;
+std::vector<uint16_t> ingest_ports; //Every port udpsrc listens on, for the kernel drop counters
+bool rtcp_feedback = RTCP_FEEDBACK; //RTCP on port + 1 of every RTP port
+bool keyframe_requests = KEYFRAME_REQUESTS; //PLI to the sender on start, loss and decode errors
+
+//Filled once per stream and never moved, so the threads read them without a lock
+std::vector<stream_t *> streams;
+std::atomic<guint> stream_count{0};
+std::mutex streams_mtx;             //Serializes adding SSRC streams with print_stats
+
+//Per stage counters, reported every GST_REMOTE_STATS_INTERVAL seconds
+remote::stage_counter stage_decode, stage_drop_queue, stage_encode, stage_appsink;
+std::atomic<uint64_t> frames_skipped{0}; //Superseded by a newer frame in latest mode
+std::atomic<uint64_t> frames_idle{0};   //Not converted in idle skip mode, nobody was connected
+std::atomic<uint64_t> frame_bytes{0};   //Payload handed to the frame server or the ring
+remote::metrics_server *metrics;    //Prometheus endpoint, NULL when off
+bool log_frames = false;            //GST_REMOTE_LOG_FRAMES=1 prints a line per frame sent
 
-pthread_mutex_t mtx_buff;
 std::thread appsink_thread, socket_thread;
 bool m_isRunning = true;
 
+////////////////////////////////////////////////////////////////////////////////
+/* Frames dropped at every stage since start, in pipeline order */
+static void print_stats ()
+{
+  std::lock_guard<std::mutex> lock(streams_mtx);
+  guint count = stream_count.load(std::memory_order_acquire);
+  for (guint i = 0; i < count; i++) {
+    if (streams[i]->decimator != NULL) {
+      streams[i]->decimator->report(std::cout, count > 1 ? static_cast<int>(i) : -1);
+    }
+  }
+  if (p.funnel != NULL) {
+    std::cout << "[Streams] " << count << " frames:";
+    for (guint i = 0; i < count; i++) {
+      std::cout << " " << i << "=" << streams[i]->frames.load(std::memory_order_relaxed);
+    }
+    std::cout << std::endl;
+  }
+  remote::ingest_totals_t ingest = {};
+  for (guint i = 0; i < count; i++) {
+    streams[i]->ingest->add_to(ingest);
+  }
+  uint64_t socket_drops = 0;
+  for (auto port : ingest_ports) {
+    socket_drops += remote::udp_socket_drops(port);
+  }
+  uint32_t rtcp_senders = p.rtcp != NULL ? p.rtcp->senders() : 0;
+  uint64_t pli_count = p.rtcp != NULL ? p.rtcp->keyframe_requests() : 0;
+  for (guint i = 0; i < count; i++) {
+    rtcp_senders += streams[i]->rtcp != NULL ? streams[i]->rtcp->senders() : 0;
+    pli_count += streams[i]->rtcp != NULL ? streams[i]->rtcp->keyframe_requests() : 0;
+  }
+  std::cout << "[Ingest] packets: " << ingest.packets << " reordered: " << ingest.reordered
+            << " duplicates: " << ingest.duplicates << " lost: " << ingest.lost << " late: " << ingest.late
+            << " | socket buffer drops: " << socket_drops;
+  if (rtcp_feedback) {
+    std::cout << " | RTCP senders: " << rtcp_senders << " keyframe requests: " << pli_count;
+  }
+  std::cout << std::endl;
+  std::cout << "[Stats] decode in: " << stage_decode.in << " out: " << stage_decode.out;
+  if (backpressure == BACKPRESSURE_BOUNDED) {
+    std::cout << " | " << stage_drop_queue.name << " dropped: " << stage_drop_queue.dropped();
+  }
+  if (encoder != NULL) {
+    std::cout << " | encode in: " << encoder->submitted() << " out: " << encoder->encoded()
+              << " failed: " << encoder->failed() << " stale: " << encoder->stale()
+              << " in flight max: " << encoder->max_in_flight() << "/" << encoder->window();
+  }
+  else if (output != OUTPUT_SHM) {
+    std::cout << " | encode in: " << stage_encode.in << " out: " << stage_encode.out;
+  }
+  if (backpressure != BACKPRESSURE_NONE) {
+    //Includes the (at most max-buffers) samples still waiting in appsink
+    std::cout << " | appsink dropped: " << stage_appsink.dropped();
+  }
+  if (output == OUTPUT_SHM) {
+    std::cout << " | shm frames: " << shm_writer->frames_written() << std::endl;
+    return;
+  }
+  std::cout << " | frame queue dropped: " << frames->dropped()
+            << " depth: " << frames->depth() << "/" << frames->capacity()
+            << " max: " << frames->high_watermark();
+  if (backpressure == BACKPRESSURE_LATEST) {
+    std::cout << " skipped: " << frames_skipped;
+  }
+  std::cout << " | clients: " << server->client_count()
+            << " client drops: " << server->frames_dropped();
+  if (idle_policy == IDLE_SKIP) {
+    std::cout << " idle skipped: " << frames_idle;
+  }
+  else {
+    std::cout << " replayed: " << server->frames_replayed();
+  }
+  std::cout << std::endl;
+  timing->report(std::cout);
+}
+
+/* One Prometheus scrape, runs on the metrics thread. Reads the same counters
+   as print_stats, nothing here touches the streaming threads */
+static void collect_metrics (remote::metrics_writer &m)
+{
+  using remote::metrics_writer;
+  std::lock_guard<std::mutex> lock(streams_mtx);
+  guint count = stream_count.load(std::memory_order_acquire);
+
+  m.family("gst_remote_streams", "gauge", "Incoming RTP streams with a decode branch");
+  m.sample("gst_remote_streams", count);
+  m.family("gst_remote_stream_frames_total", "counter", "Frames of a stream handed to the socket thread or the ring");
+  for (guint i = 0; i < count; i++) {
+    m.sample("gst_remote_stream_frames_total", streams[i]->frames.load(std::memory_order_relaxed),
+             metrics_writer::label("stream", std::to_string(i)));
+  }
+
+  remote::ingest_totals_t ingest = {};
+  for (guint i = 0; i < count; i++) {
+    streams[i]->ingest->add_to(ingest);
+  }
+  uint64_t socket_drops = 0;
+  for (auto port : ingest_ports) {
+    socket_drops += remote::udp_socket_drops(port);
+  }
+  m.family("gst_remote_rtp_packets_total", "counter", "RTP packets received");
+  m.sample("gst_remote_rtp_packets_total", ingest.packets);
+  m.family("gst_remote_rtp_lost_total", "counter", "RTP packets the jitter buffer gave up on");
+  m.sample("gst_remote_rtp_lost_total", ingest.lost);
+  m.family("gst_remote_rtp_reordered_total", "counter", "RTP packets that arrived out of order");
+  m.sample("gst_remote_rtp_reordered_total", ingest.reordered);
+  m.family("gst_remote_udp_socket_drops_total", "counter", "Datagrams dropped by the kernel, socket buffer full");
+  m.sample("gst_remote_udp_socket_drops_total", socket_drops);
+  uint64_t pli_count = p.rtcp != NULL ? p.rtcp->keyframe_requests() : 0;
+  for (guint i = 0; i < count; i++) {
+    pli_count += streams[i]->rtcp != NULL ? streams[i]->rtcp->keyframe_requests() : 0;
+  }
+  m.family("gst_remote_keyframe_requests_total", "counter", "RTCP PLIs sent to the senders");
+  m.sample("gst_remote_keyframe_requests_total", pli_count);
+
+  m.family("gst_remote_stage_frames_total", "counter", "Frames into and out of a pipeline stage");
+  auto stage = [&](const char *name, const char *direction, uint64_t value) {
+    m.sample("gst_remote_stage_frames_total", value,
+             metrics_writer::label("stage", name) + "," + metrics_writer::label("direction", direction));
+  };
+  stage("decode", "in", stage_decode.in);
+  stage("decode", "out", stage_decode.out);
+  if (encoder != NULL) {
+    stage("encode", "in", encoder->submitted());
+    stage("encode", "out", encoder->encoded());
+  }
+  else if (output == OUTPUT_JPEG) {
+    stage("encode", "in", stage_encode.in);
+    stage("encode", "out", stage_encode.out);
+  }
+
+  m.family("gst_remote_dropped_frames_total", "counter", "Frames thrown away, by where");
+  auto dropped = [&](const char *point, uint64_t value) {
+    m.sample("gst_remote_dropped_frames_total", value, metrics_writer::label("point", point));
+  };
+  uint64_t decimated = 0;
+  for (guint i = 0; i < count; i++) {
+    if (streams[i]->decimator != NULL) {
+      decimated += streams[i]->decimator->dropped_before_decode() + streams[i]->decimator->dropped_after_decode();
+    }
+  }
+  dropped("decimate", decimated);
+  if (backpressure == BACKPRESSURE_BOUNDED) {
+    dropped(stage_drop_queue.name.c_str(), stage_drop_queue.dropped());
+  }
+  if (backpressure != BACKPRESSURE_NONE) {
+    dropped("appsink", stage_appsink.dropped());
+  }
+
+  m.family("gst_remote_frame_bytes_total", "counter", "Payload bytes of the frames handed out");
+  m.sample("gst_remote_frame_bytes_total", frame_bytes.load(std::memory_order_relaxed));
+  if (output == OUTPUT_SHM) {
+    return;
+  }
+
+  dropped("frame_queue", frames->dropped());
+  dropped("skipped", frames_skipped.load(std::memory_order_relaxed));
+  dropped("client", server->frames_dropped());
+  dropped("idle", frames_idle.load(std::memory_order_relaxed));
+  m.family("gst_remote_frame_queue_depth", "gauge", "Frames waiting for the socket thread");
+  m.sample("gst_remote_frame_queue_depth", frames->depth());
+  m.family("gst_remote_frame_queue_capacity", "gauge", "Size of the frame queue");
+  m.sample("gst_remote_frame_queue_capacity", frames->capacity());
+  m.family("gst_remote_frame_queue_high_watermark", "gauge", "Deepest the frame queue has been");
+  m.sample("gst_remote_frame_queue_high_watermark", frames->high_watermark());
+
+  m.family("gst_remote_frame_span_seconds", "histogram", "Time a frame spent in each span of the pipeline");
+  for (uint32_t i = 0; i < remote::frame_timing::span_count; i++) {
+    m.histogram("gst_remote_frame_span_seconds", timing->total(i),
+                metrics_writer::label("span", remote::frame_timing::span_name(i)));
+  }
+
+  m.family("gst_remote_sent_bytes_total", "counter", "Bytes written to the TCP clients");
+  m.sample("gst_remote_sent_bytes_total", server->bytes_sent());
+  m.family("gst_remote_clients", "gauge", "Connected TCP clients");
+  m.sample("gst_remote_clients", server->client_count());
+  m.family("gst_remote_client_disconnects_total", "counter", "TCP clients that went away or were cut off");
+  m.sample("gst_remote_client_disconnects_total", server->disconnects());
+  m.family("gst_remote_client_connects_total", "counter", "TCP clients accepted");
+  m.sample("gst_remote_client_connects_total", server->connects());
+  m.family("gst_remote_client_first_frame_seconds", "histogram", "Time from a client's connect to its first complete frame");
+  m.histogram("gst_remote_client_first_frame_seconds", server->first_frame());
+  m.family("gst_remote_frames_replayed_total", "counter", "Held frames sent to a client the moment it connected");
+  m.sample("gst_remote_frames_replayed_total", server->frames_replayed());
+
+  m.family("gst_remote_startup_seconds", "gauge", "Time from process start to each startup phase reached so far");
+  for (auto &phase : startup::phases()) {
+    m.sample("gst_remote_startup_seconds", phase.second / 1e3, metrics_writer::label("phase", phase.first));
+  }
+
+  auto clients = server->client_stats();
+  m.family("gst_remote_client_lag_frames", "gauge", "Frames sent out since the last one this client fully received");
+  for (auto &c : clients) {
+    m.sample("gst_remote_client_lag_frames", c.lag, metrics_writer::label("client", c.peer));
+  }
+  m.family("gst_remote_client_queued_frames", "gauge", "Frames waiting in the client's send queue");
+  for (auto &c : clients) {
+    m.sample("gst_remote_client_queued_frames", c.queued, metrics_writer::label("client", c.peer));
+  }
+  m.family("gst_remote_client_sent_frames_total", "counter", "Frames this client fully received");
+  for (auto &c : clients) {
+    m.sample("gst_remote_client_sent_frames_total", c.sent, metrics_writer::label("client", c.peer));
+  }
+  m.family("gst_remote_client_dropped_frames_total", "counter", "Frames dropped from this client's queue");
+  for (auto &c : clients) {
+    m.sample("gst_remote_client_dropped_frames_total", c.dropped, metrics_writer::label("client", c.peer));
+  }
+  m.family("gst_remote_client_sent_bytes_total", "counter", "Bytes written to this client");
+  for (auto &c : clients) {
+    m.sample("gst_remote_client_sent_bytes_total", c.bytes, metrics_writer::label("client", c.peer));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* The funnel loses track of the branch a buffer came from, so every branch
+   writes its stream id into the buffer offset, which nothing downstream uses */
+static GstPadProbeReturn cb_tag_stream (GstPad *, GstPadProbeInfo *info, gpointer user_data)
+{
+  GstBuffer *buffer = gst_pad_probe_info_get_buffer (info);
+  if (buffer != NULL) {
+    buffer = gst_buffer_make_writable (buffer);
+    GST_BUFFER_OFFSET (buffer) = GPOINTER_TO_UINT (user_data);
+    GST_PAD_PROBE_INFO_DATA (info) = buffer;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static uint64_t steady_ns ()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* The RTP session whose RTCP socket reaches the stream's sender */
+static remote::rtcp_receiver *rtcp_of (stream_t *s)
+{
+  return s->rtcp != NULL ? s->rtcp : p.rtcp;
+}
+
+/* Depayloader sink pad. A stream joined mid-GOP decodes nothing until the next
+   IDR, which may be seconds away; ask for one if the decoder put out nothing soon */
+static GstPadProbeReturn cb_stream_packet (GstPad *, GstPadProbeInfo *, gpointer user_data)
+{
+  stream_t *s = static_cast<stream_t *>(user_data);
+  if (s->decoded.load(std::memory_order_relaxed)) {
+    return GST_PAD_PROBE_OK;
+  }
+  uint64_t now = steady_ns();
+  uint64_t first = 0;
+  if (s->first_packet_ns.compare_exchange_strong(first, now, std::memory_order_relaxed)) {
+    startup::mark("first packet");
+    return GST_PAD_PROBE_OK;
+  }
+  if (keyframe_requests && now - first > KEYFRAME_WAIT_MS * GST_MSECOND && rtcp_of(s) != NULL) {
+    rtcp_of(s)->request_keyframe(s->ssrc);
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+/* Decoder src pad, removes itself after the first frame */
+static GstPadProbeReturn cb_stream_decoded (GstPad *, GstPadProbeInfo *, gpointer user_data)
+{
+  static_cast<stream_t *>(user_data)->decoded.store(true, std::memory_order_relaxed);
+  return GST_PAD_PROBE_REMOVE;
+}
+
+/* Depayloader sink pad. rtph264depay asks for a keyframe upstream on packet
+   loss, avdec_h264 on decode errors; it goes to the sender as an RTCP PLI */
+static GstPadProbeReturn cb_keyframe_event (GstPad *, GstPadProbeInfo *info, gpointer user_data)
+{
+  GstEvent *event = gst_pad_probe_info_get_event (info);
+  if (event == NULL || !gst_video_event_is_force_key_unit (event)) {
+    return GST_PAD_PROBE_OK;
+  }
+  stream_t *s = static_cast<stream_t *>(user_data);
+  rtcp_of(s)->request_keyframe(s->ssrc);
+  //rtpsession sends its own PLIs only with the AVPF profile and rtcp-fb caps, none are set up here
+  return GST_PAD_PROBE_DROP;
+}
+
+/* The element's property if this GStreamer version has it */
+static void enable_if_supported (GstElement *element, const char *property)
+{
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (element), property) != NULL) {
+    g_object_set (G_OBJECT (element), property, TRUE, NULL);
+  }
+}
+
+/* Idle skip mode, on the converter's sink pad of every stream */
+static GstPadProbeReturn cb_idle (GstPad *, GstPadProbeInfo *, gpointer)
+{
+  if (server->client_count() > 0) {
+    return GST_PAD_PROBE_OK;
+  }
+  frames_idle.fetch_add(1, std::memory_order_relaxed);
+  return GST_PAD_PROBE_DROP;
+}
+
+static guint stream_of (GstBuffer *buffer)
+{
+  if (p.funnel == NULL) {
+    return 0;
+  }
+  guint64 id = GST_BUFFER_OFFSET (buffer);
+  return id < stream_count.load(std::memory_order_acquire) ? static_cast<guint>(id) : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Hand an encoded sample reference over to the next free slot, no copy is made.
+   The newest frame is dropped when the socket thread is frames->capacity() behind */
+static void queue_frame (GstSample *sample, guint stream)
+{
+  stream_t *s = streams[stream];
+  GstClockTime pts = GST_BUFFER_PTS (gst_sample_get_buffer (sample));
+  if (encoder != NULL || output == OUTPUT_TENSOR) {
+    s->timing->mark(pts, frame_protocol::stage_encoded);
+  }
+  s->timing->mark(pts, frame_protocol::stage_enqueued);
+
+  frame_t *slot = frames->producer_slot();
+  if (slot != NULL) {
+    slot->sample = sample;
+    slot->stream = stream;
+    frames->push_commit();
+    frames_ready->notify();
+  }
+  else {
+    gst_sample_unref(sample);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Copy one decoded frame into the next shared-memory slot, as laid out in the buffer */
+static void write_shm_frame (GstSample *sample, guint stream)
+{
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstVideoInfo info;
+
+  if (buffer == NULL || !gst_video_info_from_caps (&info, gst_sample_get_caps (sample))) {
+    return;
+  }
+
+  shm_ring::frame_format_t format = {};
+  g_strlcpy (format.format, gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (&info)), sizeof (format.format));
+  format.width = GST_VIDEO_INFO_WIDTH (&info);
+  format.height = GST_VIDEO_INFO_HEIGHT (&info);
+  format.n_planes = GST_VIDEO_INFO_N_PLANES (&info);
+  format.frame_size = gst_buffer_get_size (buffer);
+  format.stream_id = stream;
+
+  //Upstream may pad rows, a GstVideoMeta then describes the real layout
+  GstVideoMeta *meta = gst_buffer_get_video_meta (buffer);
+  for (guint i = 0; i < format.n_planes && i < shm_ring::max_planes; i++) {
+    format.stride[i] = meta ? meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE (&info, i);
+    format.offset[i] = meta ? meta->offset[i] : GST_VIDEO_INFO_PLANE_OFFSET (&info, i);
+  }
+
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  uint8_t *dst = shm_writer->begin_frame (format, GST_CLOCK_TIME_IS_VALID (pts) ? pts : UINT64_MAX);
+  if (dst == NULL) {
+    return;
+  }
+  gst_buffer_extract (buffer, 0, dst, format.frame_size);
+  shm_writer->commit_frame ();
+  frame_bytes.fetch_add (format.frame_size, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Letterbox one decoded RGB frame into a pooled tensor blob. The blob keeps the
+   frame's PTS, so it goes through the frame queue and timing like a JPEG */
+static GstSample *make_tensor_sample (GstSample *sample)
+{
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstVideoInfo info;
+  GstVideoFrame frame;
+
+  if (!gst_video_info_from_caps (&info, gst_sample_get_caps (sample)) ||
+      GST_VIDEO_INFO_FORMAT (&info) != GST_VIDEO_FORMAT_RGB ||
+      !gst_video_frame_map (&frame, &info, buffer, GST_MAP_READ)) {
+    return NULL;
+  }
+
+  GstBuffer *blob = NULL;
+  GstMapInfo map;
+  if (gst_buffer_pool_acquire_buffer (tensor_pool, &blob, NULL) == GST_FLOW_OK) {
+    if (gst_buffer_map (blob, &map, GST_MAP_WRITE)) {
+      tensor->process (static_cast<const uint8_t *> (GST_VIDEO_FRAME_PLANE_DATA (&frame, 0)),
+          GST_VIDEO_FRAME_WIDTH (&frame), GST_VIDEO_FRAME_HEIGHT (&frame),
+          GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0), map.data);
+      gst_buffer_unmap (blob, &map);
+      GST_BUFFER_PTS (blob) = GST_BUFFER_PTS (buffer);
+    }
+    else {
+      gst_buffer_unref (blob);
+      blob = NULL;
+    }
+  }
+  gst_video_frame_unmap (&frame);
+
+  if (blob == NULL) {
+    return NULL;
+  }
+  GstSample *out = gst_sample_new (blob, tensor_caps, NULL, NULL);
+  gst_buffer_unref (blob);
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/* Format and size for the version 2 header. JPEGs and tensors stand alone,
+   every one of them is a keyframe */
+static remote::frame_info_t describe_frame (GstSample *sample)
+{
+  remote::frame_info_t info = {};
+  info.keyframe = true;
+  GstCaps *caps = gst_sample_get_caps (sample);
+  if (caps == NULL || gst_caps_get_size (caps) == 0) {
+    return info;
+  }
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  if (gst_structure_has_name (structure, "image/jpeg")) {
+    info.format = frame_protocol::format_jpeg;
+  }
+  else if (gst_structure_has_name (structure, "application/x-tensor")) {
+    info.format = frame_protocol::format_tensor;
+  }
+  gint width = 0, height = 0;
+  gst_structure_get_int (structure, "width", &width);
+  gst_structure_get_int (structure, "height", &height);
+  info.width = width;
+  info.height = height;
+  return info;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static GstElement *make_stream_element (const char *factory, const char *name, guint id)
+{
+  std::string element_name = std::string(name) + "-" + std::to_string(id);
+  return gst_element_factory_make (factory, element_name.c_str());
+}
+
+/* Create, add and link the decode branch of s, from udpsrc (or the input
+   queue) to the funnel. Works on a playing pipeline too */
+static bool build_stream (stream_t *s)
+{
+  /*
+  gst-launch-1.0 udpsrc port=PORT ! application/x-rtp, encoding-name=H264, payload=96 ! \
+              rtph264depay ! avdec_h264 ! autovideoconvert ! autovideosink
+  */
+  std::vector<GstElement *> chain;
+  if (s->port != 0) {
+    s->source = make_stream_element("udpsrc", "source", s->id);
+    ASSERT_ELEMENT(s->source, "udpsrc");
+    GstCaps *filtercaps = gst_caps_new_simple("application/x-rtp",
+      //"media", G_TYPE_STRING, "video",
+      "payload", G_TYPE_INT, 96,
+      "clock-rate", G_TYPE_INT, 90000,     //rtpjitterbuffer needs it
+      "encoding-name", G_TYPE_STRING, "H264", NULL);
+    ASSERT_ELEMENT(filtercaps, "filtercaps");
+    g_object_set(G_OBJECT(s->source), "caps", filtercaps, "port", static_cast<gint>(s->port), NULL);
+    gst_caps_unref(filtercaps);
+    if (udp_rcvbuf > 0) {
+      //Keyframe bursts overflow the default socket buffer at high bitrates
+      g_object_set(G_OBJECT(s->source), "buffer-size", static_cast<gint>(udp_rcvbuf), NULL);
+    }
+    chain.push_back(s->source);
+    if (rtcp_feedback) {
+      s->rtcp = new remote::rtcp_receiver(s->id);
+      ASSERT_ELEMENT(s->rtcp->session(), "rtpsession");
+      chain.push_back(s->rtcp->session());
+    }
+  }
+  else {
+    //rtpssrcdemux pushes every stream from the udpsrc thread, a leaky queue
+    //gives each branch its own and keeps one slow stream from stalling the rest
+    s->input_queue = make_stream_element("queue", "input_queue", s->id);
+    ASSERT_ELEMENT(s->input_queue, "queue");
+    g_object_set (G_OBJECT (s->input_queue), "leaky", 2 /* downstream, drop oldest */, NULL);
+    chain.push_back(s->input_queue);
+  }
+  if (jitter_latency > 0) {
+    //Puts reordered packets back in sequence; what is still missing after the
+    //latency is declared lost so the depayloader doesn't build broken frames
+    s->jitterbuffer = make_stream_element("rtpjitterbuffer", "jitterbuffer", s->id);
+    ASSERT_ELEMENT(s->jitterbuffer, "rtpjitterbuffer");
+    g_object_set (G_OBJECT (s->jitterbuffer),
+        "latency", static_cast<guint>(jitter_latency),
+        "drop-on-latency", TRUE,
+        "do-lost", TRUE, NULL);
+    chain.push_back(s->jitterbuffer);
+  }
+  s->rtp_dec = make_stream_element("rtph264depay", "rtp_dec", s->id);
+  ASSERT_ELEMENT(s->rtp_dec, "rtph264depay");
+  s->h264dec = make_stream_element("avdec_h264", "dec", s->id);
+  ASSERT_ELEMENT(s->h264dec, "avdec_h264");
+  if (decode_threads > 0) {
+    g_object_set (G_OBJECT (s->h264dec), "max-threads", static_cast<gint>(decode_threads), NULL);
+  }
+  s->conv = make_stream_element("autovideoconvert", "conv", s->id);
+  ASSERT_ELEMENT(s->conv, "autovideoconvert");
+  if (keyframe_requests && rtcp_feedback) {
+    //Drop what is broken and ask for a keyframe, rather than sending smeared
+    //frames until the sender's next one (GStreamer >= 1.20)
+    enable_if_supported(s->rtp_dec, "request-keyframe");
+    enable_if_supported(s->h264dec, "automatic-request-sync-points");
+    enable_if_supported(s->h264dec, "discard-corrupted-frames");
+  }
+
+  if (output == OUTPUT_JPEG && encoder == NULL) {
+    s->last_stage = make_stream_element("jpegenc", "enc", s->id);
+    ASSERT_ELEMENT(s->last_stage, "jpegenc");
+  }
+  else if (output != OUTPUT_JPEG) {
+    //No encoder: fix the raw format the shared-memory readers or the tensor stage get
+    s->last_stage = make_stream_element("capsfilter", "raw_caps", s->id);
+    ASSERT_ELEMENT(s->last_stage, "capsfilter");
+    GstCaps *caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING,
+        output == OUTPUT_SHM ? shm_format.c_str() : "RGB", NULL);
+    g_object_set(G_OBJECT(s->last_stage), "caps", caps, NULL);
+    gst_caps_unref(caps);
+  }
+
+  //Leaky queue so frames that can't be encoded in time are thrown away
+  //before doing the expensive work, instead of stalling udpsrc
+  if (backpressure == BACKPRESSURE_BOUNDED) {
+    s->drop_queue = make_stream_element("queue", "drop_queue", s->id);
+    ASSERT_ELEMENT(s->drop_queue, "queue");
+    g_object_set (G_OBJECT (s->drop_queue),
+        "max-size-buffers", drop_queue_capacity,
+        "max-size-bytes", 0u,
+        "max-size-time", static_cast<guint64>(0),
+        "leaky", 2 /* downstream, drop oldest */, NULL);
+  }
+
+  chain.push_back(s->rtp_dec);
+  chain.push_back(s->h264dec);
+  if (s->drop_queue != NULL && drop_point == DROP_POINT_CONVERT) {
+    chain.push_back(s->drop_queue);
+  }
+  chain.push_back(s->conv);
+  if (s->drop_queue != NULL && drop_point == DROP_POINT_ENCODE) {
+    chain.push_back(s->drop_queue);
+  }
+  if (s->last_stage != NULL) {
+    chain.push_back(s->last_stage);
+  }
+  GstElement *tail = chain.back();
+  chain.push_back(p.funnel != NULL ? p.funnel : p.sink);
+
+  for (GstElement *element : chain) {
+    if (element != p.funnel && element != p.sink) {
+      gst_bin_add (GST_BIN (p.pipeline), element);
+    }
+  }
+  GstElement *session = s->rtcp != NULL ? s->rtcp->session() : NULL;
+  for (size_t i = 1; i < chain.size(); i++) {
+    //rtpsession has RTP and RTCP pads of the same direction, name the RTP ones
+    if (gst_element_link_pads (chain[i - 1], chain[i - 1] == session ? "recv_rtp_src" : NULL,
+                               chain[i], chain[i] == session ? "recv_rtp_sink" : NULL) != TRUE) {
+      g_printerr ("Stream %u elements could not be linked.\n", s->id);
+      return false;
+    }
+  }
+  if (s->rtcp != NULL && !s->rtcp->attach(p.pipeline, s->port + 1)) {
+    g_printerr ("Stream %u RTCP could not be set up.\n", s->id);
+    return false;
+  }
+  //Skip frames before decode where possible, before conversion otherwise
+  if (target_fps > 0) {
+    s->decimator = new remote::frame_decimator(target_fps);
+    if (!s->decimator->attach(s->h264dec)) {
+      g_printerr ("Stream %u frame decimator could not be attached.\n", s->id);
+      return false;
+    }
+  }
+  //Nothing below fails, add_stream() only has to undo the elements above
+
+  if (p.funnel != NULL) {
+    GstPad *tail_pad = gst_element_get_static_pad (tail, "src");
+    gst_pad_add_probe (tail_pad, GST_PAD_PROBE_TYPE_BUFFER, cb_tag_stream, GUINT_TO_POINTER (s->id), NULL);
+    gst_object_unref (tail_pad);
+  }
+
+  /* Count buffers in and out of every stage that can drop */
+  s->ingest = new remote::rtp_ingest();
+  s->ingest->attach(s->jitterbuffer != NULL ? s->jitterbuffer : s->rtp_dec, s->jitterbuffer);
+  remote::attach_stage_counter(s->h264dec, &stage_decode);
+  startup::mark_first_buffer(s->h264dec, "src", "first decoded frame");
+  GstPad *dec_pad = gst_element_get_static_pad (s->h264dec, "src");
+  gst_pad_add_probe (dec_pad, GST_PAD_PROBE_TYPE_BUFFER, cb_stream_decoded, s, NULL);
+  gst_object_unref (dec_pad);
+  if (output == OUTPUT_JPEG && s->last_stage != NULL) {
+    remote::attach_stage_counter(s->last_stage, &stage_encode);
+  }
+  if (s->drop_queue != NULL) {
+    stage_drop_queue.queues.push_back(s->drop_queue);
+    remote::attach_stage_counter(s->drop_queue, &stage_drop_queue);
+  }
+  if (output != OUTPUT_SHM) {
+    s->timing = new remote::frame_timing();
+    s->timing->attach(p.pipeline, s->rtp_dec, s->h264dec, output == OUTPUT_JPEG && encoder == NULL ? s->last_stage : NULL);
+  }
+  GstPad *depay_pad = gst_element_get_static_pad (s->rtp_dec, "sink");
+  gst_pad_add_probe (depay_pad, GST_PAD_PROBE_TYPE_BUFFER, cb_stream_packet, s, NULL);
+  if (keyframe_requests && rtcp_feedback) {
+    gst_pad_add_probe (depay_pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, cb_keyframe_event, s, NULL);
+  }
+  gst_object_unref (depay_pad);
+  //Nobody to send to: keep decoding so the next consumer needs no keyframe,
+  //but leave out the conversion and encoding
+  if (output != OUTPUT_SHM && idle_policy == IDLE_SKIP) {
+    GstPad *conv_pad = gst_element_get_static_pad (s->conv, "sink");
+    gst_pad_add_probe (conv_pad, GST_PAD_PROBE_TYPE_BUFFER, cb_idle, NULL, NULL);
+    gst_object_unref (conv_pad);
+  }
+  return true;
+}
+
+/* Out of the pipeline if it was added, linked pads go with it */
+static void discard_element (GstElement *element)
+{
+  if (element == NULL) {
+    return;
+  }
+  if (GST_OBJECT_PARENT (element) == GST_OBJECT (p.pipeline)) {
+    gst_element_set_state (element, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (p.pipeline), element);
+  }
+  else {
+    gst_object_unref (gst_object_ref_sink (element));
+  }
+}
+
+/* Undo a build_stream() that failed half way, s was never published */
+static void destroy_stream (stream_t *s)
+{
+  //The funnel keeps a request pad until it is given back, tail as in build_stream()
+  GstElement *tail = s->last_stage;
+  if (tail == NULL) {
+    tail = s->drop_queue != NULL && drop_point == DROP_POINT_ENCODE ? s->drop_queue : s->conv;
+  }
+  GstPad *tail_pad = p.funnel != NULL && tail != NULL ? gst_element_get_static_pad (tail, "src") : NULL;
+  GstPad *funnel_pad = tail_pad != NULL ? gst_pad_get_peer (tail_pad) : NULL;
+  if (funnel_pad != NULL) {
+    gst_pad_unlink (tail_pad, funnel_pad);
+    gst_element_release_request_pad (p.funnel, funnel_pad);
+    gst_object_unref (funnel_pad);
+  }
+  if (tail_pad != NULL) {
+    gst_object_unref (tail_pad);
+  }
+
+  if (s->rtcp != NULL) {
+    s->rtcp->detach(p.pipeline);
+  }
+  for (GstElement *element : {s->source, s->rtcp != NULL ? s->rtcp->session() : NULL, s->input_queue, s->jitterbuffer,
+                              s->rtp_dec, s->h264dec, s->drop_queue, s->conv, s->last_stage}) {
+    discard_element(element);
+  }
+  delete s->decimator;
+  delete s->rtcp;
+  delete s;
+}
+
+/* Streams are published only once their branch is complete and, with
+   input, linked to it. NULL if the stream table is full or the branch could
+   not be built or linked */
+static stream_t *add_stream (guint16 port, guint32 ssrc, GstPad *input = NULL)
+{
+  guint id = stream_count.load(std::memory_order_relaxed);
+  if (id >= streams.size()) {
+    return NULL;
+  }
+  stream_t *s = new stream_t();
+  s->id = id;
+  s->port = port;
+  s->ssrc = ssrc;
+  bool linked = build_stream(s);
+  if (linked && input != NULL) {
+    GstPad *sink_pad = gst_element_get_static_pad (s->input_queue, "sink");
+    linked = gst_pad_link (input, sink_pad) == GST_PAD_LINK_OK;
+    if (!linked) {
+      g_printerr ("Stream %u input could not be linked.\n", s->id);
+    }
+    gst_object_unref (sink_pad);
+  }
+  if (!linked) {
+    destroy_stream(s);
+    return NULL;
+  }
+  streams[id] = s;
+  stream_count.store(id + 1, std::memory_order_release);
+  return s;
+}
+
+static GstPadProbeReturn cb_drop (GstPad *, GstPadProbeInfo *, gpointer)
+{
+  return GST_PAD_PROBE_DROP;
+}
+
+/* rtpssrcdemux found a new sender on the shared port, runs in the udpsrc thread */
+static void on_new_ssrc_pad (GstElement *, guint ssrc, GstPad *pad, gpointer)
+{
+  std::lock_guard<std::mutex> lock(streams_mtx);
+  stream_t *s = NULL;
+  if (stream_count.load(std::memory_order_relaxed) >= streams.size()) {
+    std::cout << "Ignoring SSRC " << ssrc << ", no stream slot left" << std::endl;
+  }
+  else if ((s = add_stream(0, ssrc, pad)) == NULL) {
+    std::cout << "Ignoring SSRC " << ssrc << ", its decode branch could not be built or linked" << std::endl;
+  }
+  if (s == NULL) {
+    //An unlinked pad would stop the shared udpsrc for every stream
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, cb_drop, NULL, NULL);
+    return;
+  }
+  std::cout << "Stream " << s->id << ": SSRC " << ssrc << std::endl;
+  //Downstream first, so nothing pushes into an element that is not playing yet
+  for (GstElement *element : {s->last_stage, s->drop_queue, s->conv, s->h264dec, s->rtp_dec, s->jitterbuffer, s->input_queue}) {
+    if (element != NULL) {
+      gst_element_sync_state_with_parent (element);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 int main (int argc, char *argv[])
 {
@@ -95,56 +944,331 @@ int main (int argc, char *argv[])
 
   gint port = 0;
 
-  if(argc <= 1) {
-  
-    auto port_str = std::getenv("GST_REMOTE_INCOMING_PORT");
+  //Several streams, one port each, or one port with the streams told apart by SSRC
+  std::vector<uint16_t> stream_ports;
+  auto streams_str = std::getenv("GST_REMOTE_STREAMS");
+  bool ssrc_demux = utils::get_env_ulong("GST_REMOTE_SSRC_DEMUX", 0) != 0;
+  auto max_streams = utils::get_env_ulong("GST_REMOTE_MAX_STREAMS", MAX_STREAMS);
 
-    if(port_str == nullptr) {
-      perror("GST_REMOTE_INCOMING_PORT environment var not set");
+  if(streams_str != nullptr) {
+    if (!utils::parse_port_list(streams_str, stream_ports) || ssrc_demux) {
+      std::cout << "Not valid GST_REMOTE_STREAMS (ports and ranges, e.g. 5000,5010-5041, not with GST_REMOTE_SSRC_DEMUX). Exiting..." << std::endl;
       exit(EXIT_FAILURE);
     }
-
-    port = std::atoi(port_str);
+    max_streams = stream_ports.size();
+    std::cout << "Listening to " << stream_ports.size() << " incoming gst pipelines on ports: " << streams_str << std::endl;
   }
   else {
-    port = std::stoi(argv[1]);
+    if(argc <= 1) {
+    
+      auto port_str = std::getenv("GST_REMOTE_INCOMING_PORT");
+
+      if(port_str == nullptr) {
+        perror("GST_REMOTE_INCOMING_PORT environment var not set");
+        exit(EXIT_FAILURE);
+      }
+
+      port = std::atoi(port_str);
+    }
+    else {
+      port = std::stoi(argv[1]);
+    }
+
+    if(utils::validate_port(port)) {
+      std::cout << "Listening to incoming gst pipeline on port: " << port << std::endl;
+    }
+    else {
+      std::cout << "Not valid port. Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    if (ssrc_demux) {
+      if (max_streams == 0) {
+        std::cout << "Not valid GST_REMOTE_MAX_STREAMS. Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      std::cout << "Streams split by SSRC, up to " << max_streams << std::endl;
+    }
+    else {
+      max_streams = 1;
+      stream_ports.push_back(port);
+    }
   }
+  bool multi_stream = ssrc_demux || stream_ports.size() > 1;
+  streams.assign(max_streams, NULL);
+
+  //Shared by every stream: room for a couple of frames each
+  auto queue_capacity = utils::get_env_ulong("GST_REMOTE_QUEUE_CAPACITY",
+      std::max<unsigned long>(FRAME_QUEUE_CAPACITY, 2 * max_streams));
+  std::cout << "Frame queue capacity: " << queue_capacity << std::endl;
+  frames = new remote::frame_queue<frame_t>(queue_capacity);
+  frames_ready = new remote::event_notifier();
 
-  if(utils::validate_port(port)) {
-    std::cout << "Listening to incoming gst pipeline on port: " << port << std::endl;
+  drop_queue_capacity = utils::get_env_ulong("GST_REMOTE_DROP_QUEUE", DROP_QUEUE_CAPACITY);
+  if (drop_queue_capacity == 0) {
+    drop_queue_capacity = 1;
+  }
+  auto backpressure_str = std::getenv("GST_REMOTE_BACKPRESSURE");
+  if (backpressure_str != nullptr) {
+    std::string mode(backpressure_str);
+    if (mode == "none") {
+      backpressure = BACKPRESSURE_NONE;
+    }
+    else if (mode == "latest") {
+      backpressure = BACKPRESSURE_LATEST;
+    }
+    else if (mode == "bounded") {
+      backpressure = BACKPRESSURE_BOUNDED;
+    }
+    else {
+      std::cout << "Not valid GST_REMOTE_BACKPRESSURE (none, latest, bounded). Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  auto drop_point_str = std::getenv("GST_REMOTE_DROP_POINT");
+  if (drop_point_str != nullptr) {
+    std::string point(drop_point_str);
+    if (point == "convert") {
+      drop_point = DROP_POINT_CONVERT;
+    }
+    else if (point == "encode") {
+      drop_point = DROP_POINT_ENCODE;
+    }
+    else {
+      std::cout << "Not valid GST_REMOTE_DROP_POINT (convert, encode). Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  if (backpressure == BACKPRESSURE_LATEST) {
+    std::cout << "Backpressure: latest frame wins" << std::endl;
+  }
+  else if (backpressure == BACKPRESSURE_BOUNDED) {
+    std::cout << "Backpressure: bounded, " << drop_queue_capacity << " frames before "
+              << (drop_point == DROP_POINT_CONVERT ? "autovideoconvert" : "jpegenc") << std::endl;
+  }
+
+  auto output_str = std::getenv("GST_REMOTE_OUTPUT");
+  if (output_str != nullptr) {
+    std::string mode(output_str);
+    if (mode == "jpeg") {
+      output = OUTPUT_JPEG;
+    }
+    else if (mode == "shm") {
+      output = OUTPUT_SHM;
+    }
+    else if (mode == "tensor") {
+      output = OUTPUT_TENSOR;
+    }
+    else {
+      std::cout << "Not valid GST_REMOTE_OUTPUT (jpeg, shm, tensor). Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (output == OUTPUT_SHM) {
+    auto shm_name = std::getenv("GST_REMOTE_SHM_NAME");
+    auto shm_format_str = std::getenv("GST_REMOTE_SHM_FORMAT");
+    if (shm_format_str != nullptr) {
+      shm_format = shm_format_str;
+    }
+    shm_writer = new shm_ring::ring_writer(shm_name != nullptr ? shm_name : SHM_RING_NAME,
+        utils::get_env_ulong("GST_REMOTE_SHM_SLOTS", SHM_RING_SLOTS));
+    std::cout << "Output: " << shm_format << " frames to shared memory " << shm_writer->name() << std::endl;
+  }
+
+  auto server_port_str = std::getenv("GST_YOLO_PORT");
+
+  if(output != OUTPUT_SHM && server_port_str == nullptr) {
+    perror("GST_YOLO_PORT environment var not set");
+    exit(EXIT_FAILURE);
+  }
+
+  auto server_port = output != OUTPUT_SHM ? std::atoi(server_port_str) : 0;
+
+  if(output == OUTPUT_SHM) {
+    //No TCP consumers, readers attach to the ring
+  }
+  else if(utils::validate_port(server_port)) {
+    std::cout << "Listening to incoming yolo clients on port: " << server_port << std::endl;
   }
   else {
-    std::cout << "Not valid port. Exiting..." << std::endl;
+    std::cout << "Not valid yolo port. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  auto policy = remote::slow_client_policy::drop_oldest;
+  auto policy_str = std::getenv("GST_REMOTE_SLOW_CLIENT");
+  if(policy_str != nullptr && !remote::parse_slow_client_policy(policy_str, policy)) {
+    std::cout << "Not valid GST_REMOTE_SLOW_CLIENT (drop-oldest, latest, disconnect). Exiting..." << std::endl;
     exit(EXIT_FAILURE);
   }
 
+  auto idle_str = std::getenv("GST_REMOTE_IDLE");
+  if (idle_str != nullptr) {
+    std::string mode(idle_str);
+    if (mode == "replay") {
+      idle_policy = IDLE_REPLAY;
+    }
+    else if (mode == "skip") {
+      idle_policy = IDLE_SKIP;
+    }
+    else {
+      std::cout << "Not valid GST_REMOTE_IDLE (replay, skip). Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (output != OUTPUT_SHM) {
+    timing = new remote::frame_timing();
+    //Version 1 consumers must be told about the meta block, so only GST_REMOTE_FRAME_META
+    //turns it on; the version 2 header carries the stream id on its own
+    send_frame_meta = utils::get_env_ulong("GST_REMOTE_FRAME_META", 0) != 0;
+    if (send_frame_meta) {
+      std::cout << "Sending a " << sizeof(frame_protocol::meta_t) << " byte timing block with every frame" << std::endl;
+    }
+    else if (multi_stream) {
+      std::cout << "Several streams: version 1 consumers get no stream id,"
+                << " use protocol version 2 or GST_REMOTE_FRAME_META=1" << std::endl;
+    }
+    server = new remote::frame_server(server_port,
+        utils::get_env_ulong("GST_REMOTE_CLIENT_QUEUE", CLIENT_QUEUE_CAPACITY), policy);
+    if (!frames_ready->valid() || !server->start() || !server->add_wakeup_fd(frames_ready->fd())) {
+      exit(EXIT_FAILURE);
+    }
+    std::string protocol_str{PROTOCOL_MODE};
+    auto protocol_env = std::getenv("GST_REMOTE_PROTOCOL");
+    if (protocol_env != nullptr) {
+      protocol_str = protocol_env;
+    }
+    auto protocol = remote::protocol_mode::automatic;
+    if (!remote::parse_protocol_mode(protocol_str, protocol)) {
+      std::cout << "Not valid GST_REMOTE_PROTOCOL (1, auto, 2). Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    server->set_protocol(protocol, utils::get_env_ulong("GST_REMOTE_HELLO_WAIT", HELLO_WAIT_MS));
+    server->set_replay_latest(idle_policy == IDLE_REPLAY,
+        utils::get_env_ulong("GST_REMOTE_REPLAY_AGE", REPLAY_MAX_AGE_MS));
+  }
+
+  //GST_REMOTE_FAST_START=1 trusts the registry cache as is, rebuild the
+  //cache (or the image) when plugins are installed or updated
+  bool fast_start = utils::get_env_ulong("GST_REMOTE_FAST_START", 0) != 0;
+  if (fast_start) {
+    startup::use_registry_cache(REGISTRY_CACHE);
+  }
+
   /* Initialize GStreamer */
   gst_init (&argc, &argv);
+  startup::mark("gst_init");
 
-  /* Create the elements */
-  /*
-  gst-launch-1.0 udpsrc port=PORT ! application/x-rtp, encoding-name=H264, payload=96 ! \
-              rtph264depay ! avdec_h264 ! autovideoconvert ! autovideosink
-  */
-  p.source = gst_element_factory_make ("udpsrc", "source");
-  ASSERT_ELEMENT(p.source, "udpsrc");
-  p.filtercaps = gst_caps_new_simple("application/x-rtp",
-    //"media", G_TYPE_STRING, "video",
-    "payload", G_TYPE_INT, 96,
-    //"clock-rate", G_TYPE_INT, 90000,
-    "encoding-name", G_TYPE_STRING, "H264", NULL);
-  ASSERT_ELEMENT(p.filtercaps, "filtercaps");
-  g_object_set(G_OBJECT(p.source), "caps", p.filtercaps, NULL);
-  gst_caps_unref(p.filtercaps);
-  p.rtp_dec = gst_element_factory_make("rtph264depay", "rtp_dec");
-  ASSERT_ELEMENT(p.rtp_dec, "rtph264depay");
-  p.h264dec = gst_element_factory_make("avdec_h264", "dec");
-  ASSERT_ELEMENT(p.h264dec, "avdec_h264");
-  p.conv = gst_element_factory_make("autovideoconvert", "conv");
-  ASSERT_ELEMENT(p.conv, "autovideoconvert");
-
-  p.enc_img = gst_element_factory_make("jpegenc", "enc");
-  ASSERT_ELEMENT(p.enc_img, "jpegenc");
+  //GST_REMOTE_TRACE=<file.json> profiles every element for a while
+  auto trace_str = std::getenv("GST_REMOTE_TRACE");
+  if (trace_str != nullptr && trace_str[0] != '\0') {
+    gst_profiler::start(trace_str, utils::get_env_ulong("GST_REMOTE_TRACE_SECONDS", TRACE_SECONDS));
+  }
+
+  if (output == OUTPUT_TENSOR) {
+    auto tensor_size = utils::get_env_ulong("GST_REMOTE_TENSOR_SIZE", TENSOR_SIZE);
+    auto tensor_pad = utils::get_env_ulong("GST_REMOTE_TENSOR_PAD", TENSOR_PAD);
+    if (tensor_size == 0 || tensor_size > 4096 || tensor_pad > 255) {
+      std::cout << "Not valid GST_REMOTE_TENSOR_SIZE / GST_REMOTE_TENSOR_PAD. Exiting..." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    tensor = new remote::tensor_preprocessor(tensor_size, tensor_pad);
+    tensor_caps = gst_caps_new_simple ("application/x-tensor", "width", G_TYPE_INT, static_cast<gint>(tensor_size),
+        "height", G_TYPE_INT, static_cast<gint>(tensor_size), NULL);
+
+    //Blobs are several MB, reuse them instead of allocating one per frame.
+    //Aligned so the vector stores into the planes don't split cache lines
+    GstAllocationParams params;
+    gst_allocation_params_init (&params);
+    params.align = 63;
+    tensor_pool = gst_buffer_pool_new ();
+    GstStructure *config = gst_buffer_pool_get_config (tensor_pool);
+    gst_buffer_pool_config_set_params (config, NULL, tensor->tensor_bytes(), 0, 0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+    if (!gst_buffer_pool_set_config (tensor_pool, config) || !gst_buffer_pool_set_active (tensor_pool, TRUE)) {
+      g_printerr ("Tensor buffer pool could not be started.\n");
+      exit(EXIT_FAILURE);
+    }
+    std::cout << "Output: " << tensor_size << "x" << tensor_size << " RGB float tensors, "
+              << remote::tensor_preprocessor::kernel_name() << " kernel" << std::endl;
+  }
+
+  //Skip frames before decode where possible, before conversion otherwise
+  target_fps = utils::get_env_ulong("GST_REMOTE_TARGET_FPS", TARGET_FPS);
+  if (target_fps > 0) {
+    std::cout << "Target output rate: " << target_fps << " fps" << std::endl;
+  }
+
+  jitter_latency = utils::get_env_ulong("GST_REMOTE_JITTER_LATENCY", JITTER_LATENCY_MS);
+  udp_rcvbuf = utils::get_env_ulong("GST_REMOTE_RCVBUF", UDP_RCVBUF);
+  if (udp_rcvbuf > INT32_MAX) {
+    std::cout << "Not valid GST_REMOTE_RCVBUF. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (jitter_latency > 0) {
+    std::cout << "Jitter buffer latency: " << jitter_latency << " ms" << std::endl;
+  }
+  if (ssrc_demux) {
+    ingest_ports.push_back(port);
+  }
+  else {
+    ingest_ports = stream_ports;
+  }
+  log_frames = utils::get_env_ulong("GST_REMOTE_LOG_FRAMES", 0) != 0;
+  rtcp_feedback = utils::get_env_ulong("GST_REMOTE_RTCP", RTCP_FEEDBACK) != 0;
+  keyframe_requests = utils::get_env_ulong("GST_REMOTE_KEYFRAME_REQUESTS", KEYFRAME_REQUESTS) != 0;
+  if (rtcp_feedback) {
+    for (auto rtp_port : ingest_ports) {
+      if (rtp_port == utils::port_range_max ||
+          std::find(ingest_ports.begin(), ingest_ports.end(), rtp_port + 1) != ingest_ports.end()) {
+        std::cout << "Not valid port " << rtp_port << ", RTCP needs port + 1 (or GST_REMOTE_RTCP=0). Exiting..." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    std::cout << "RTCP: receiver reports from RTP port + 1" << std::endl;
+  }
+
+  //libav starts a thread per core in every decoder, too many with dozens of streams
+  decode_threads = utils::get_env_ulong("GST_REMOTE_DECODE_THREADS", multi_stream ? 1 : 0);
+
+  if (fast_start) {
+    //Only the plugins of this pipeline, loaded now rather than when a new
+    //SSRC or the first caps (autovideoconvert picks its converter then) need them
+    std::vector<std::string> factories = {"udpsrc", "rtph264depay", "avdec_h264", "autovideoconvert",
+                                          "videoconvert", "queue", "capsfilter", "appsink"};
+    if (output == OUTPUT_JPEG) {
+      factories.push_back("jpegenc");
+    }
+    if (rtcp_feedback) {
+      factories.push_back("rtpsession");
+    }
+    if (jitter_latency > 0) {
+      factories.push_back("rtpjitterbuffer");
+    }
+    if (ssrc_demux) {
+      factories.push_back("rtpssrcdemux");
+    }
+    if (multi_stream) {
+      factories.push_back("funnel");
+    }
+    for (auto &missing : startup::preload(factories)) {
+      std::cout << "[Startup] element " << missing << " not found" << std::endl;
+    }
+    startup::mark("plugins loaded");
+  }
+
+  auto encode_threads = utils::get_env_ulong("GST_REMOTE_ENCODE_THREADS", ENCODE_THREADS);
+  if (output == OUTPUT_JPEG && encode_threads > 1) {
+    //appsink gets raw frames, the pool encodes them and feeds the frame queue
+    //in order. Only one worker emits at a time, so the queue keeps a single producer
+    encoder = new remote::encode_pool(encode_threads,
+        utils::get_env_ulong("GST_REMOTE_ENCODE_WINDOW", 2 * encode_threads), queue_frame);
+    if (!encoder->start()) {
+      exit(EXIT_FAILURE);
+    }
+  }
 
   //p.enc_img = gst_element_factory_make("pngenc", "enc");
   //ASSERT_ELEMENT(p.enc_img, "pngenc");
@@ -154,10 +1278,16 @@ int main (int argc, char *argv[])
   // ASSERT_ELEMENT(p.sink, "multifilesink");
   // g_object_set(p.sink, "location", "out-%05d.jpg", NULL);
 
-  //Appsink
+  //Appsink, shared by every stream
   p.sink = gst_element_factory_make("appsink", "extract_images_appsink");
   ASSERT_ELEMENT(p.sink, "appsink"); // Checks if NULL
   g_object_set (G_OBJECT (p.sink), "emit-signals", FALSE, "sync", FALSE, NULL);
+  if (backpressure == BACKPRESSURE_LATEST) {
+    g_object_set (G_OBJECT (p.sink), "max-buffers", static_cast<guint>(max_streams), "drop", TRUE, NULL);
+  }
+  else if (backpressure == BACKPRESSURE_BOUNDED) {
+    g_object_set (G_OBJECT (p.sink), "max-buffers", static_cast<guint>(drop_queue_capacity * max_streams), "drop", TRUE, NULL);
+  }
 
 ////////////////////////////////////////////////////////////////////////////////
   // Thread to read from the appsink buffer
@@ -172,38 +1302,46 @@ int main (int argc, char *argv[])
         GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK_CAST(p.sink));
         if(sample != NULL)
         {
+          stage_appsink.out.fetch_add(1, std::memory_order_relaxed);
           GstBuffer * buffer  = gst_sample_get_buffer (sample);
           if (buffer == NULL)
           {
+            gst_sample_unref(sample);
+            continue;
+          }
+          guint stream = stream_of(buffer);
+          if (streams[stream]->frames.fetch_add(1, std::memory_order_relaxed) == 0 &&
+              streams[stream]->first_packet_ns.load(std::memory_order_relaxed) != 0) {
+            stream_t *s = streams[stream];
+            std::cout << "Stream " << s->id << ": first frame " << std::fixed << std::setprecision(1)
+                      << (steady_ns() - s->first_packet_ns.load(std::memory_order_relaxed)) / 1e6
+                      << " ms after its first packet" << std::endl;
+          }
+          if (output == OUTPUT_SHM) {
+            write_shm_frame(sample, stream);
+            gst_sample_unref(sample);
+            startup::mark("first frame sent");
+            filecount++;
             continue;
           }
-          gsize datalen = gst_buffer_get_size(buffer);
-          // Extract buffer
-          uint8_t *rawData = (uint8_t *) malloc(datalen);
-          if (rawData == NULL) {
-            std::cout << " build_pipeline() allocation fails" << std::endl;
-            return false;
+          if (output == OUTPUT_TENSOR) {
+            //The raw frame is released as soon as the tensor is made
+            stage_encode.in.fetch_add(1, std::memory_order_relaxed);
+            GstSample *blob = make_tensor_sample(sample);
+            gst_sample_unref(sample);
+            if (blob == NULL) {
+              continue;
+            }
+            stage_encode.out.fetch_add(1, std::memory_order_relaxed);
+            sample = blob;
+          }
+          if (encoder != NULL) {
+            //Raw frame, blocks while the reorder window is full
+            encoder->submit(sample, stream);
+          }
+          else {
+            queue_frame(sample, stream);
           }
-          memset(rawData, 0, datalen);
-          gst_buffer_extract(buffer, 0, rawData, datalen);
-          //Append to a local buffer
-          pthread_mutex_lock(&mtx_buff);
-          appsinkbuffer.insert( appsinkbuffer.end(), rawData, rawData + datalen );
-          buffersize.push_back(datalen);
-          pthread_mutex_unlock(&mtx_buff);
-          ////////////////////////////////////
-          // //Write to files
-          // FILE* pFile;
-          // std::stringstream filename;
-          // std::string fname;
-          // filename << "file_" << std::setw(2) << std::setfill('0') << filecount << ".raw";
-          // fname = std::string (filename.str());
-          // pFile = fopen(fname.c_str(), "wb");
-          // fwrite(rawData, datalen, 1, pFile);
-          // fclose(pFile);
-          ////////////////////////////////////
-          free(rawData);
-          gst_sample_unref(sample);
           filecount++;
         }
       }
@@ -223,104 +1361,69 @@ int main (int argc, char *argv[])
   // Thread to handle the socket and send frames
   try
   {
-    socket_thread = std::thread([]() 
-    {
-      //Socket
-      int server_socket, client_fd;
-      struct sockaddr_in server_addr, client_addr;
-
-      // Creating socket file descriptor
-      if ((server_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-          perror("socket failed");
-          exit(EXIT_FAILURE);
-      }
-
-
-      auto server_port_str = std::getenv("GST_YOLO_PORT");
-
-      if(server_port_str == nullptr) {
-        perror("GST_YOLO_PORT environment var not set");
-        exit(EXIT_FAILURE);
-      }
-
-      auto server_port = std::atoi(server_port_str);
-      
-
-      if(utils::validate_port(server_port)) {
-        std::cout << "Listening to incoming yolo client on port: " << server_port << std::endl;
-      }
-      else {
-        std::cout << "Not valid yolo port. Exiting..." << std::endl;
-        exit(EXIT_FAILURE);
-      }
-
-      server_addr.sin_family = AF_INET;
-      server_addr.sin_port = htons(server_port);
-      server_addr.sin_addr.s_addr = INADDR_ANY;
-
-      if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-          perror("bind failed");
-          exit(EXIT_FAILURE);
-      }
-      if (listen(server_socket, 1) < 0) {
-          perror("listen");
-          exit(EXIT_FAILURE);
-      }
-
-      socklen_t sin_size=sizeof(client_addr);
-      client_fd=accept(server_socket,(struct sockaddr*)&client_addr, &sin_size);
-      //std::cout << "client_fd:" << client_fd << std::endl;
+    if (output != OUTPUT_SHM) {
+      socket_thread = std::thread([]() 
+      {
+        int filecount2 = 0;
+        bool first_sent = false;
+        std::cout << "------ START Socket Thread ------" << std::endl;
+        while (true){
+          //Sleep until a frame is queued or a client socket needs service
+          server->poll(-1);
 
-      if (client_fd < 0) {
-        perror("accept");
-        exit(EXIT_FAILURE);
-      };
-      printf("Got connection from %s port %d\n", inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-
-      int filecount2 = 0;
-      std::cout << "------ START Socket Thread ------" << std::endl;
-      uint32_t datalen2=0;
-      uint8_t *rawData2;
-      while (true){
-        datalen2=0;
-        //////////////////////////////
-        //Extract from a local buffer                                                                                                                    
-        pthread_mutex_lock(&mtx_buff);
-        if ( ! buffersize.empty()) {
-          datalen2=buffersize.front();
-          buffersize.erase(buffersize.begin(),buffersize.begin()+1);
-        }
-        if (datalen2 != 0) {
-          rawData2 = (uint8_t *) malloc(datalen2);
-          memset(rawData2, 0, datalen2);
-          rawData2=appsinkbuffer.data();
-          std::cout << "[Socket Thread] frame:" << filecount2 << " lenght: " << datalen2 << std::endl;
-          appsinkbuffer.erase( appsinkbuffer.begin(), appsinkbuffer.begin() + datalen2 );
-          //Send Frame Number, Frame Lenght and Frame
-          send(client_fd, &(filecount2), sizeof(filecount2),0);
-          send(client_fd, &(datalen2), sizeof(datalen2),0);
-          send(client_fd, rawData2, datalen2, 0);
-          //std::cout << "Sent: Frame: "<< filecount2 << "[" << sizeof(filecount2) << "] with lenght: " << datalen2 << "[" << sizeof(datalen2) << "]" << std::endl;
-          filecount2++;
+          //////////////////////////////
+          //Extract from the frame queue
+          frame_t *frame;
+          while ((frame = frames->front()) != NULL) {
+            if (backpressure == BACKPRESSURE_LATEST && p.funnel == NULL && frames->depth() > 1) {
+              //A newer frame is already waiting, this one is stale. With several
+              //streams it may be another stream's, appsink max-buffers bounds them instead
+              gst_sample_unref(frame->sample);
+              frame->sample = NULL;
+              frames->pop_release();
+              frames_skipped.fetch_add(1, std::memory_order_relaxed);
+              continue;
+            }
+            //Maps the payload read-only and takes over the sample reference,
+            //every client shares the same mapping
+            auto mapped = std::make_shared<remote::mapped_frame>(frame->sample);
+            stream_t *s = streams[frame->stream];
+            frame->sample = NULL;
+            frames->pop_release();
+            if (!mapped->valid()) {
+              continue;
+            }
+            frame_protocol::meta_t meta;
+            s->timing->take(GST_BUFFER_PTS(mapped->buffer()), meta);
+            meta.stream_id = s->id;
+            meta.stage_ns[frame_protocol::stage_sent] = remote::frame_timing::realtime_ns();
+            timing->record(meta);
+            frame_bytes.fetch_add(mapped->size(), std::memory_order_relaxed);
+            if (log_frames) {
+              std::cout << "[Socket Thread] frame:" << filecount2 << " stream: " << s->id << " lenght: " << mapped->size()
+                        << " queue: " << frames->depth() << "/" << frames->capacity()
+                        << " max: " << frames->high_watermark()
+                        << " dropped: " << frames->dropped()
+                        << " clients: " << server->client_count()
+                        << " client drops: " << server->frames_dropped() << std::endl;
+            }
+            remote::frame_info_t info = describe_frame(mapped->sample());
+            info.stream_id = s->id;
+            info.pts = meta.pts;
+            server->broadcast(mapped, filecount2, send_frame_meta ? &meta : NULL, &info);
+            if (!first_sent && server->client_count() > 0) {
+              startup::mark("first frame sent");
+              first_sent = true;
+            }
+            filecount2++;
+          }
+          //////////////////////////////  
         }
-        pthread_mutex_unlock(&mtx_buff);
-        //////////////////////////////  
-        // //Write to files
-        // FILE* pFile;
-        // std::stringstream filename;
-        // std::string fname;
-        // filename << "file_" << std::setw(2) << std::setfill('0') << filecount2 << ".jpg";
-        // fname = std::string (filename.str());
-        // pFile = fopen(fname.c_str(), "wb");
-        // fwrite(rawData2, datalen2, 1, pFile);
-        // fclose(pFile);
-        //////////////////////////////  
-        //g_usleep(100000);
-      }
-      std::cout << "------ END Socket Thread ------" << std::endl;
-      return true;
-    });
-    socket_thread.detach();
+        std::cout << "------ END Socket Thread ------" << std::endl;
+        return true;
+      });
+      socket_thread.detach();
+    }
   }
   catch (std::exception &e)
   {
@@ -331,42 +1434,127 @@ int main (int argc, char *argv[])
   /* Create the empty pipeline */
   p.pipeline = gst_pipeline_new ("test-pipeline");
 
-  if (!p.pipeline || !p.source || !p.rtp_dec || !p.h264dec || !p.conv || !p.enc_img || !p.sink) {
+  if (!p.pipeline || !p.sink) {
     g_printerr ("Not all elements could be created.\n");
     return -1;
   }
 
   /* Build the pipeline */
-  gst_bin_add_many (GST_BIN (p.pipeline), p.source, p.rtp_dec, p.h264dec, p.conv, p.enc_img, p.sink, NULL);
-  
-  if (gst_element_link_many (p.source, p.rtp_dec, NULL) != TRUE) {
-    g_printerr ("First Elements could not be linked.\n");
-    gst_object_unref (p.pipeline);
-    return -1;
+  gst_bin_add (GST_BIN (p.pipeline), p.sink);
+  if (multi_stream) {
+    //Every branch ends in the funnel, so appsink, the frame queue and the
+    //threads behind it are shared no matter how many streams come in
+    p.funnel = gst_element_factory_make("funnel", "funnel");
+    ASSERT_ELEMENT(p.funnel, "funnel");
+    gst_bin_add (GST_BIN (p.pipeline), p.funnel);
+    if (gst_element_link (p.funnel, p.sink) != TRUE) {
+      g_printerr ("Funnel could not be linked.\n");
+      gst_object_unref (p.pipeline);
+      return -1;
+    }
   }
 
-  if (gst_element_link_many (p.rtp_dec, p.h264dec, p.conv, p.enc_img, p.sink, NULL) != TRUE) {
-    g_printerr ("Next Elements could not be linked.\n");
-    gst_object_unref (p.pipeline);
-    return -1;
+  stage_decode.name = "decode";
+  stage_encode.name = "encode";
+  stage_drop_queue.name = drop_point == DROP_POINT_CONVERT ? "queue-convert" : "queue-encode";
+  stage_appsink.name = "appsink";
+  remote::attach_stage_counter(p.sink, &stage_appsink);
+
+  if (ssrc_demux) {
+    //Branches are added as senders show up
+    p.source = gst_element_factory_make ("udpsrc", "source");
+    ASSERT_ELEMENT(p.source, "udpsrc");
+    GstCaps *filtercaps = gst_caps_new_simple("application/x-rtp",
+      "payload", G_TYPE_INT, 96,
+      "clock-rate", G_TYPE_INT, 90000,
+      "encoding-name", G_TYPE_STRING, "H264", NULL);
+    g_object_set(G_OBJECT(p.source), "caps", filtercaps, "port", static_cast<gint>(port), NULL);
+    gst_caps_unref(filtercaps);
+    if (udp_rcvbuf > 0) {
+      g_object_set(G_OBJECT(p.source), "buffer-size", static_cast<gint>(udp_rcvbuf), NULL);
+    }
+    p.ssrc_demux = gst_element_factory_make ("rtpssrcdemux", "ssrc_demux");
+    ASSERT_ELEMENT(p.ssrc_demux, "rtpssrcdemux");
+    gst_bin_add_many (GST_BIN (p.pipeline), p.source, p.ssrc_demux, NULL);
+    bool linked;
+    if (rtcp_feedback) {
+      //One session for every sender, each report carries a block per SSRC
+      p.rtcp = new remote::rtcp_receiver(0);
+      ASSERT_ELEMENT(p.rtcp->session(), "rtpsession");
+      gst_bin_add (GST_BIN (p.pipeline), p.rtcp->session());
+      linked = gst_element_link_pads (p.source, "src", p.rtcp->session(), "recv_rtp_sink") &&
+               gst_element_link_pads (p.rtcp->session(), "recv_rtp_src", p.ssrc_demux, "sink") &&
+               p.rtcp->attach(p.pipeline, port + 1);
+    }
+    else {
+      linked = gst_element_link (p.source, p.ssrc_demux);
+    }
+    if (!linked) {
+      g_printerr ("First Elements could not be linked.\n");
+      gst_object_unref (p.pipeline);
+      return -1;
+    }
+    g_signal_connect (p.ssrc_demux, "new-ssrc-pad", G_CALLBACK (on_new_ssrc_pad), NULL);
+  }
+  else {
+    std::lock_guard<std::mutex> lock(streams_mtx);
+    for (auto stream_port : stream_ports) {
+      if (add_stream(stream_port, 0) == NULL) {
+        gst_object_unref (p.pipeline);
+        return -1;
+      }
+    }
   }
 
-  /* Set udpsink ip and port */
-  g_object_set (p.source, "port", static_cast<gint>(port), NULL);
+  startup::mark("pipeline built");
 
   /* Start playing */
+  //Live sources don't preroll: PLAYING right away, so sockets, threads and
+  //plugins are up before the first consumer connects
   ret = gst_element_set_state (p.pipeline, GST_STATE_PLAYING);
   if (ret == GST_STATE_CHANGE_FAILURE) {
     g_printerr ("Unable to set the pipeline to the playing state.\n");
     gst_object_unref (p.pipeline);
     return -1;
   }
+  startup::mark("playing");
+
+  unsigned long metrics_port = utils::get_env_ulong("GST_REMOTE_METRICS_PORT", METRICS_PORT);
+  if (metrics_port > utils::port_range_max) {
+    std::cout << "Not valid GST_REMOTE_METRICS_PORT. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (metrics_port > 0) {
+    metrics = new remote::metrics_server(metrics_port, collect_metrics);
+    if (!metrics->start()) {
+      std::cout << "Metrics endpoint could not be started, going on without it" << std::endl;
+    }
+  }
 
-  /* Wait until error or EOS */
+  //The kernel caps SO_RCVBUF at net.core.rmem_max without an error, say so
+  if (udp_rcvbuf > 0) {
+    int rcvbuf = remote::udp_socket_rcvbuf(p.source != NULL ? p.source : streams[0]->source);
+    std::cout << "UDP receive buffer: " << rcvbuf << " bytes";
+    if (rcvbuf > 0 && static_cast<unsigned long>(rcvbuf) < udp_rcvbuf) {
+      std::cout << ", asked for " << udp_rcvbuf << ". Raise net.core.rmem_max to get it";
+    }
+    std::cout << std::endl;
+  }
+
+  /* Wait until error or EOS, reporting the stage counters meanwhile */
+  GstClockTime stats_interval = utils::get_env_ulong("GST_REMOTE_STATS_INTERVAL", STATS_INTERVAL_S) * GST_SECOND;
+  if (stats_interval == 0) {
+    stats_interval = GST_CLOCK_TIME_NONE;
+  }
   bus = gst_element_get_bus (p.pipeline);
-  msg =
-      gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
-      static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+  do {
+    msg =
+        gst_bus_timed_pop_filtered (bus, stats_interval,
+        static_cast<GstMessageType>(GST_MESSAGE_ERROR | GST_MESSAGE_EOS));
+    if (msg == NULL) {
+      print_stats();
+    }
+  } while (msg == NULL);
 
   /* Parse message */
   if (msg != NULL) {
@@ -394,6 +1582,9 @@ int main (int argc, char *argv[])
     gst_message_unref (msg);
   }
 
+  print_stats();
+  gst_profiler::finish();
+
   /* Free rep.sources */
   gst_object_unref (bus);
   gst_element_set_state (p.pipeline, GST_STATE_NULL);
@@ -0,0 +1,191 @@
+/**
+ * @file    rtcp-session.cpp
+ * @brief   Receiver side RTCP, so senders learn loss, jitter and throughput
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <iostream>
+#include <gio/gio.h>
+#include <gst/net/gstnetaddressmeta.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+#include <rtcp-config.h>
+
+#include "rtcp-session.h"
+
+#define KEYFRAME_INTERVAL   std::chrono::milliseconds(500) // Between two PLIs, every IDR is a burst
+
+namespace remote {
+
+    static GstElement *make_element(const char *factory, const char *name, guint id) {
+        std::string element_name = std::string(name) + "-" + std::to_string(id);
+        return gst_element_factory_make(factory, element_name.c_str());
+    }
+
+    rtcp_receiver::rtcp_receiver(guint id) : id_(id) {
+        session_ = make_element("rtpsession", "rtpsession", id);
+        if (session_ != NULL) {
+            g_object_set(G_OBJECT(session_), "rtcp-min-interval", static_cast<guint64>(RTCP_MIN_INTERVAL), NULL);
+        }
+    }
+
+    rtcp_receiver::~rtcp_receiver() {
+        for (auto &sender : ssrc_addresses_) {
+            g_object_unref(sender.second);
+        }
+        if (socket_ != NULL) {
+            g_object_unref(socket_);
+        }
+    }
+
+    bool rtcp_receiver::attach(GstElement *pipeline, uint16_t rtcp_port) {
+        GstElement *rtcp_src = make_element("udpsrc", "rtcp_src", id_);
+        rtcp_src_ = rtcp_src;
+        GstElement *sync_sink = make_element("fakesink", "rtcp_sync", id_);
+        sync_sink_ = sync_sink;
+        rtcp_sink_ = make_element("multiudpsink", "rtcp_sink", id_);
+        if (session_ == NULL || rtcp_src == NULL || sync_sink == NULL || rtcp_sink_ == NULL) {
+            return false;
+        }
+
+        GstCaps *caps = gst_caps_new_empty_simple("application/x-rtcp");
+        g_object_set(G_OBJECT(rtcp_src), "caps", caps, "port", static_cast<gint>(rtcp_port), NULL);
+        gst_caps_unref(caps);
+        // RTCP must never wait for the clock or hold up prerolling
+        g_object_set(G_OBJECT(rtcp_sink_), "sync", FALSE, "async", FALSE, NULL);
+        g_object_set(G_OBJECT(sync_sink), "sync", FALSE, "async", FALSE, NULL);
+
+        gst_bin_add_many(GST_BIN(pipeline), rtcp_src, sync_sink, rtcp_sink_, NULL);
+        // sync_src carries the sender reports on for lip sync, nothing here
+        // needs them but an unlinked pad would stop the RTCP udpsrc
+        if (!gst_element_link_pads(rtcp_src, "src", session_, "recv_rtcp_sink") ||
+            !gst_element_link_pads(session_, "sync_src", sync_sink, "sink") ||
+            !gst_element_link_pads(session_, "send_rtcp_src", rtcp_sink_, "sink")) {
+            return false;
+        }
+
+        GstPad *pad = gst_element_get_static_pad(rtcp_src, "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_rtcp, this, NULL);
+        gst_object_unref(pad);
+        return true;
+    }
+
+    void rtcp_receiver::detach(GstElement *pipeline) {
+        for (GstElement **element : {&rtcp_src_, &sync_sink_, &rtcp_sink_}) {
+            if (*element == NULL) {
+                continue;
+            }
+            if (GST_OBJECT_PARENT(*element) == GST_OBJECT(pipeline)) {
+                gst_element_set_state(*element, GST_STATE_NULL);
+                gst_bin_remove(GST_BIN(pipeline), *element);
+            }
+            else {
+                // Never added, still floating
+                gst_object_unref(gst_object_ref_sink(*element));
+            }
+            *element = NULL;
+        }
+    }
+
+    /* A sender's first RTCP packet adds its address to the report destinations */
+    GstPadProbeReturn rtcp_receiver::cb_rtcp(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<rtcp_receiver *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        GstNetAddressMeta *meta = buffer != NULL ? gst_buffer_get_net_address_meta(buffer) : NULL;
+        if (meta == NULL || !G_IS_INET_SOCKET_ADDRESS(meta->addr)) {
+            return GST_PAD_PROBE_OK;
+        }
+
+        GInetSocketAddress *address = G_INET_SOCKET_ADDRESS(meta->addr);
+        gchar *host = g_inet_address_to_string(g_inet_socket_address_get_address(address));
+        guint16 port = g_inet_socket_address_get_port(address);
+        std::string peer = std::string(host) + ":" + std::to_string(port);
+        if (self->peers_.insert(peer).second) {
+            g_signal_emit_by_name(self->rtcp_sink_, "add", host, static_cast<gint>(port), NULL);
+            self->senders_.store(self->peers_.size(), std::memory_order_relaxed);
+            std::cout << "RTCP reports to " << peer << std::endl;
+        }
+        g_free(host);
+        self->learn_ssrcs(buffer, meta->addr);
+        return GST_PAD_PROBE_OK;
+    }
+
+    /* Sender reports say which SSRC sends from which address */
+    void rtcp_receiver::learn_ssrcs(GstBuffer *buffer, GSocketAddress *address) {
+        GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+        if (!gst_rtcp_buffer_map(buffer, GST_MAP_READ, &rtcp)) {
+            return;
+        }
+        GstRTCPPacket packet;
+        for (gboolean more = gst_rtcp_buffer_get_first_packet(&rtcp, &packet); more;
+             more = gst_rtcp_packet_move_to_next(&packet)) {
+            if (gst_rtcp_packet_get_type(&packet) != GST_RTCP_TYPE_SR) {
+                continue;
+            }
+            guint32 ssrc;
+            gst_rtcp_packet_sr_get_sender_info(&packet, &ssrc, NULL, NULL, NULL, NULL);
+            std::lock_guard<std::mutex> lock(senders_mtx_);
+            // The latest address wins, a sender behind NAT may get a new port
+            GSocketAddress *&known = ssrc_addresses_[ssrc];
+            if (known != NULL) {
+                g_object_unref(known);
+            }
+            known = G_SOCKET_ADDRESS(g_object_ref(address));
+        }
+        gst_rtcp_buffer_unmap(&rtcp);
+    }
+
+    /* An empty receiver report first, a compound RTCP packet has to start with one */
+    static GstBuffer *make_pli(uint32_t sender_ssrc, uint32_t media_ssrc) {
+        GstBuffer *buffer = gst_rtcp_buffer_new(1400);
+        GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+        GstRTCPPacket packet;
+        gst_rtcp_buffer_map(buffer, GST_MAP_READWRITE, &rtcp);
+        gst_rtcp_buffer_add_packet(&rtcp, GST_RTCP_TYPE_RR, &packet);
+        gst_rtcp_packet_rr_set_ssrc(&packet, sender_ssrc);
+        gst_rtcp_buffer_add_packet(&rtcp, GST_RTCP_TYPE_PSFB, &packet);
+        gst_rtcp_packet_fb_set_type(&packet, GST_RTCP_PSFB_TYPE_PLI);
+        gst_rtcp_packet_fb_set_sender_ssrc(&packet, sender_ssrc);
+        gst_rtcp_packet_fb_set_media_ssrc(&packet, media_ssrc);
+        gst_rtcp_buffer_unmap(&rtcp);
+        return buffer;
+    }
+
+    bool rtcp_receiver::request_keyframe(uint32_t media_ssrc) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(senders_mtx_);
+        if (keyframe_requests_.load(std::memory_order_relaxed) > 0 && now - last_request_ < KEYFRAME_INTERVAL) {
+            return false;
+        }
+        if (socket_ == NULL && rtcp_src_ != NULL) {
+            // Only there once udpsrc is PLAYING, the PLI goes out from the RTCP port
+            g_object_get(G_OBJECT(rtcp_src_), "used-socket", &socket_, NULL);
+        }
+        if (socket_ == NULL) {
+            return false;
+        }
+
+        guint own_ssrc = 0;
+        g_object_get(G_OBJECT(session_), "internal-ssrc", &own_ssrc, NULL);
+        bool sent = false;
+        for (auto &sender : ssrc_addresses_) {
+            if (media_ssrc != 0 && sender.first != media_ssrc) {
+                continue;
+            }
+            GstBuffer *pli = make_pli(own_ssrc, sender.first);
+            GstMapInfo map;
+            if (gst_buffer_map(pli, &map, GST_MAP_READ)) {
+                sent |= g_socket_send_to(socket_, sender.second, reinterpret_cast<const gchar *>(map.data),
+                                         map.size, NULL, NULL) > 0;
+                gst_buffer_unmap(pli, &map);
+            }
+            gst_buffer_unref(pli);
+        }
+        if (sent) {
+            last_request_ = now;
+            keyframe_requests_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return sent;
+    }
+
+};
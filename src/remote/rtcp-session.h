@@ -0,0 +1,94 @@
+/**
+ * @file    rtcp-session.h
+ * @brief   Receiver side RTCP, so senders learn loss, jitter and throughput
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * An rtpsession sits between udpsrc and the rest of the branch. It keeps the
+ * per SSRC loss and jitter statistics and sends them back as RTCP receiver
+ * reports, which gstreamer-local uses to adapt its bitrate.
+ *
+ *   udpsrc :port   -> rtpsession recv_rtp_sink / recv_rtp_src -> jitterbuffer
+ *   udpsrc :port+1 -> recv_rtcp_sink          (sender reports)
+ *                     send_rtcp_src -> multiudpsink -> every sender
+ *
+ * Reports go back to the address and port each sender's RTCP came from
+ * (symmetric RTCP, RFC 4961), so no sender address has to be configured and
+ * several senders on one port each get theirs.
+ *
+ * Keyframe requests are RTCP PLI packets (RFC 4585) sent the same way, from
+ * the RTCP socket to the address the sender's SSRC reported from.
+ */
+#ifndef __RTCP_SESSION_H
+#define __RTCP_SESSION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <gst/gst.h>
+#include <gio/gio.h>
+
+namespace remote {
+
+    class rtcp_receiver {
+    public:
+        /** @brief Creates the rtpsession, element names end in "-id" */
+        explicit rtcp_receiver(guint id);
+        ~rtcp_receiver();
+
+        rtcp_receiver(const rtcp_receiver &) = delete;
+        rtcp_receiver &operator=(const rtcp_receiver &) = delete;
+
+        /**
+         * @brief Goes in the branch right after udpsrc; link to its
+         *        "recv_rtp_sink" pad and from its "recv_rtp_src" pad
+         */
+        GstElement *session() const { return session_; }
+
+        /** @brief Add the RTCP socket on rtcp_port and the report path, session must be in pipeline */
+        bool attach(GstElement *pipeline, uint16_t rtcp_port);
+
+        /** @brief Take the RTCP elements of attach() out of pipeline again, the session stays */
+        void detach(GstElement *pipeline);
+
+        /** @brief Senders that reports are going to */
+        uint32_t senders() const { return senders_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Ask the sender of media_ssrc, or every sender if 0, for a
+         *        keyframe. At most one request per 500 ms, callable from any thread.
+         *
+         * @return false if throttled or no sender has sent a report yet
+         */
+        bool request_keyframe(uint32_t media_ssrc);
+
+        uint64_t keyframe_requests() const { return keyframe_requests_.load(std::memory_order_relaxed); }
+
+    private:
+        static GstPadProbeReturn cb_rtcp(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+        void learn_ssrcs(GstBuffer *buffer, GSocketAddress *address);
+
+        guint id_;
+        GstElement *session_;
+        GstElement *rtcp_src_ = NULL;
+        GstElement *sync_sink_ = NULL;
+        GstElement *rtcp_sink_ = NULL;
+
+        // Learnt from the sender reports, read by request_keyframe()
+        std::mutex senders_mtx_;
+        std::map<uint32_t, GSocketAddress *> ssrc_addresses_;
+        GSocket *socket_ = NULL;
+        std::chrono::steady_clock::time_point last_request_;
+        std::atomic<uint64_t> keyframe_requests_{0};
+
+        std::set<std::string> peers_;       // RTCP streaming thread only
+        std::atomic<uint32_t> senders_{0};
+    };
+
+};
+
+#endif // __RTCP_SESSION_H
@@ -0,0 +1,140 @@
+/**
+ * @file    rtp-ingest.cpp
+ * @brief   Loss, reorder and socket overflow statistics of incoming RTP
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <gio/gio.h>
+#include <gst/rtp/gstrtpbuffer.h>
+
+#include "rtp-ingest.h"
+
+namespace remote {
+
+    bool rtp_ingest::attach(GstElement *element, GstElement *jitterbuffer) {
+        GstPad *pad = gst_element_get_static_pad(element, "sink");
+        if (pad == NULL) {
+            return false;
+        }
+        jitterbuffer_ = jitterbuffer;
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_packet, this, NULL);
+        gst_object_unref(pad);
+        return true;
+    }
+
+    GstPadProbeReturn rtp_ingest::cb_packet(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto self = static_cast<rtp_ingest *>(user_data);
+        GstBuffer *buffer = gst_pad_probe_info_get_buffer(info);
+        GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+
+        if (buffer == NULL || !gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp)) {
+            return GST_PAD_PROBE_OK;
+        }
+        uint16_t seq = gst_rtp_buffer_get_seq(&rtp);
+        gst_rtp_buffer_unmap(&rtp);
+
+        self->packets_.fetch_add(1, std::memory_order_relaxed);
+        if (!self->have_seq_) {
+            self->have_seq_ = true;
+            self->highest_seq_ = seq;
+            return GST_PAD_PROBE_OK;
+        }
+        // Sequence numbers wrap, compare them as a signed 16 bit distance
+        int16_t distance = static_cast<int16_t>(seq - self->highest_seq_);
+        if (distance > 0) {
+            self->highest_seq_ = seq;
+        }
+        else if (distance == 0) {
+            self->duplicates_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            self->reordered_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    void rtp_ingest::add_to(ingest_totals_t &totals) const {
+        totals.packets += packets_.load(std::memory_order_relaxed);
+        totals.reordered += reordered_.load(std::memory_order_relaxed);
+        totals.duplicates += duplicates_.load(std::memory_order_relaxed);
+        if (jitterbuffer_ == NULL) {
+            return;
+        }
+
+        GstStructure *stats = NULL;
+        g_object_get(jitterbuffer_, "stats", &stats, NULL);
+        if (stats == NULL) {
+            return;
+        }
+        guint64 value = 0;
+        if (gst_structure_get_uint64(stats, "num-lost", &value)) {
+            totals.lost += value;
+        }
+        if (gst_structure_get_uint64(stats, "num-late", &value)) {
+            totals.late += value;
+        }
+        gst_structure_free(stats);
+    }
+
+    /* Lines look like "sl local_address rem_address st ... drops", addresses as HEX_IP:HEX_PORT */
+    static uint64_t proc_udp_drops(const char *path, uint16_t port) {
+        std::ifstream file(path);
+        std::string line;
+        uint64_t drops = 0;
+
+        std::getline(file, line);
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string slot, local;
+            fields >> slot >> local;
+            auto colon = local.rfind(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            const char *hex = local.c_str() + colon + 1;
+            char *end = nullptr;
+            if (std::strtoul(hex, &end, 16) != port || end == hex || *end != '\0') {
+                continue;
+            }
+            std::string field, last;
+            while (fields >> field) {
+                last = field;
+            }
+            // A line that doesn't parse is skipped, it must not stop the remote
+            end = nullptr;
+            auto count = std::strtoull(last.c_str(), &end, 10);
+            if (end == last.c_str() || *end != '\0') {
+                continue;
+            }
+            drops += count;
+        }
+        return drops;
+    }
+
+    uint64_t udp_socket_drops(uint16_t port) {
+        return proc_udp_drops("/proc/net/udp", port) + proc_udp_drops("/proc/net/udp6", port);
+    }
+
+    int udp_socket_rcvbuf(GstElement *udpsrc) {
+        GSocket *socket = NULL;
+        g_object_get(udpsrc, "used-socket", &socket, NULL);
+        if (socket == NULL) {
+            return 0;
+        }
+        int size = 0;
+        socklen_t len = sizeof(size);
+        if (getsockopt(g_socket_get_fd(socket), SOL_SOCKET, SO_RCVBUF, &size, &len) != 0) {
+            size = 0;
+        }
+        g_object_unref(socket);
+        // Linux reports twice the requested size, half is bookkeeping overhead
+        return size / 2;
+    }
+
+};
@@ -0,0 +1,73 @@
+/**
+ * @file    rtp-ingest.h
+ * @brief   Loss, reorder and socket overflow statistics of incoming RTP
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __RTP_INGEST_H
+#define __RTP_INGEST_H
+
+#include <atomic>
+#include <cstdint>
+#include <gst/gst.h>
+
+namespace remote {
+
+    /** @brief Sums over every stream, see rtp_ingest::add_to() */
+    typedef struct {
+        uint64_t packets;           // Reached the jitter buffer
+        uint64_t reordered;         // Arrived after a higher sequence number
+        uint64_t duplicates;
+        uint64_t lost;              // Given up on by the jitter buffer
+        uint64_t late;              // Arrived after the jitter buffer gave up on them
+    } ingest_totals_t;
+
+    /**
+     * @brief Watches the packets entering one stream's rtpjitterbuffer.
+     *
+     * Reordering is counted here, in arrival order, since the jitter buffer
+     * hides it. Loss and late packets come from the jitter buffer's own
+     * "stats". Without a jitter buffer only the arrival counters are kept.
+     */
+    class rtp_ingest {
+    public:
+        rtp_ingest() = default;
+
+        rtp_ingest(const rtp_ingest &) = delete;
+        rtp_ingest &operator=(const rtp_ingest &) = delete;
+
+        /**
+         * @brief Count the packets going into the sink pad of element
+         *
+         * @param jitterbuffer rtpjitterbuffer to read loss from, may be NULL
+         */
+        bool attach(GstElement *element, GstElement *jitterbuffer);
+
+        void add_to(ingest_totals_t &totals) const;
+
+    private:
+        static GstPadProbeReturn cb_packet(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+
+        GstElement *jitterbuffer_ = NULL;
+
+        // Streaming thread only
+        bool have_seq_ = false;
+        uint16_t highest_seq_ = 0;
+
+        std::atomic<uint64_t> packets_{0};
+        std::atomic<uint64_t> reordered_{0};
+        std::atomic<uint64_t> duplicates_{0};
+    };
+
+    /**
+     * @brief Datagrams the kernel dropped because the receive buffer of the
+     *        UDP socket bound to port was full, from /proc/net/udp{,6}
+     */
+    uint64_t udp_socket_drops(uint16_t port);
+
+    /** @brief SO_RCVBUF the kernel actually gave udpsrc's socket, 0 if unknown */
+    int udp_socket_rcvbuf(GstElement *udpsrc);
+
+};
+
+#endif // __RTP_INGEST_H
@@ -0,0 +1,63 @@
+/**
+ * @file    stage-stats.cpp
+ * @brief   Per-element buffer in/out counters fed by pad probes
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include "stage-stats.h"
+
+namespace remote {
+
+    static guint probe_buffer_count(GstPadProbeInfo *info) {
+        if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+            return gst_buffer_list_length(gst_pad_probe_info_get_buffer_list(info));
+        }
+        return 1;
+    }
+
+    static GstPadProbeReturn cb_stage_in(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto counter = static_cast<stage_counter *>(user_data);
+        counter->in.fetch_add(probe_buffer_count(info), std::memory_order_relaxed);
+        return GST_PAD_PROBE_OK;
+    }
+
+    static GstPadProbeReturn cb_stage_out(GstPad *, GstPadProbeInfo *info, gpointer user_data) {
+        auto counter = static_cast<stage_counter *>(user_data);
+        counter->out.fetch_add(probe_buffer_count(info), std::memory_order_relaxed);
+        return GST_PAD_PROBE_OK;
+    }
+
+    uint64_t stage_counter::dropped() const {
+        uint64_t in_count = in.load(std::memory_order_relaxed);
+        uint64_t out_count = out.load(std::memory_order_relaxed);
+        uint64_t level = 0;
+
+        for (GstElement *queue : queues) {
+            guint buffers = 0;
+            g_object_get(queue, "current-level-buffers", &buffers, NULL);
+            level += buffers;
+        }
+        return (in_count > out_count + level) ? in_count - out_count - level : 0;
+    }
+
+    bool attach_stage_counter(GstElement *element, stage_counter *counter) {
+        auto type = static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST);
+
+        GstPad *sink_pad = gst_element_get_static_pad(element, "sink");
+        if (sink_pad == NULL) {
+            return false;
+        }
+        gst_pad_add_probe(sink_pad, type, cb_stage_in, counter, NULL);
+        gst_object_unref(sink_pad);
+
+        // Sinks have no src pad, their output is counted by whoever pulls
+        GstPad *src_pad = gst_element_get_static_pad(element, "src");
+        if (src_pad != NULL) {
+            gst_pad_add_probe(src_pad, type, cb_stage_out, counter, NULL);
+            gst_object_unref(src_pad);
+        }
+        return true;
+    }
+
+};
@@ -0,0 +1,42 @@
+/**
+ * @file    stage-stats.h
+ * @brief   Per-element buffer in/out counters fed by pad probes
+ * @version 0.1
+ * @date    2026-10-16
+ */
+#ifndef __STAGE_STATS_H
+#define __STAGE_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gst/gst.h>
+
+namespace remote {
+
+    /**
+     * @brief Counts buffers entering and leaving one pipeline stage. The
+     *        counters are updated from the streaming threads with relaxed
+     *        atomics and read by the stats reporter.
+     */
+    struct stage_counter {
+        std::string name;
+        std::vector<GstElement *> queues;   //Set when the stage is made of GstQueues, their level is not a drop
+        std::atomic<uint64_t> in{0};
+        std::atomic<uint64_t> out{0};
+
+        /** @brief Buffers that went in and never came out, minus what is still queued */
+        uint64_t dropped() const;
+    };
+
+    /**
+     * @brief Install buffer probes on the "sink" and "src" pads of element
+     *
+     * @return false if the element has no static sink pad
+     */
+    bool attach_stage_counter(GstElement *element, stage_counter *counter);
+
+};
+
+#endif // __STAGE_STATS_H
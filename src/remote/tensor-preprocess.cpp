@@ -0,0 +1,303 @@
+/**
+ * @file    tensor-preprocess.cpp
+ * @brief   Letterbox resize and planar float conversion of decoded RGB frames
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TENSOR_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TENSOR_NEON 1
+#endif
+
+#include "tensor-preprocess.h"
+
+namespace remote {
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Packed RGB to three float planes, value * mul[c] + add[c]. The whole
+    // letterboxed canvas is one contiguous run, so the kernels only need a
+    // scalar tail, no per-row handling.
+
+    typedef void (*planar_kernel_t)(const uint8_t *rgb, size_t pixels, float *r, float *g, float *b,
+                                    const float *mul, const float *add);
+
+    static void planar_scalar(const uint8_t *rgb, size_t pixels, float *r, float *g, float *b,
+                              const float *mul, const float *add) {
+        for (size_t i = 0; i < pixels; i++, rgb += 3) {
+            r[i] = rgb[0] * mul[0] + add[0];
+            g[i] = rgb[1] * mul[1] + add[1];
+            b[i] = rgb[2] * mul[2] + add[2];
+        }
+    }
+
+#ifdef TENSOR_X86
+    /* 16 pixels, 48 bytes, split into one register of 16 bytes per channel */
+    __attribute__((target("ssse3")))
+    static inline void deinterleave16(const uint8_t *rgb, __m128i &r, __m128i &g, __m128i &b) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 16));
+        const __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 32));
+
+        r = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+        g = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+        b = _mm_or_si128(_mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+                _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+    }
+
+    __attribute__((target("sse4.1,ssse3")))
+    static inline void store16_sse(__m128i v, float *out, __m128 mul, __m128 add) {
+        for (int k = 0; k < 4; k++) {
+            __m128 f = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v));
+            _mm_storeu_ps(out + 4 * k, _mm_add_ps(_mm_mul_ps(f, mul), add));
+            v = _mm_srli_si128(v, 4);
+        }
+    }
+
+    __attribute__((target("sse4.1,ssse3")))
+    static void planar_sse41(const uint8_t *rgb, size_t pixels, float *r, float *g, float *b,
+                             const float *mul, const float *add) {
+        const __m128 mul_r = _mm_set1_ps(mul[0]), mul_g = _mm_set1_ps(mul[1]), mul_b = _mm_set1_ps(mul[2]);
+        const __m128 add_r = _mm_set1_ps(add[0]), add_g = _mm_set1_ps(add[1]), add_b = _mm_set1_ps(add[2]);
+        size_t i = 0;
+        for (; i + 16 <= pixels; i += 16, rgb += 48) {
+            __m128i vr, vg, vb;
+            deinterleave16(rgb, vr, vg, vb);
+            store16_sse(vr, r + i, mul_r, add_r);
+            store16_sse(vg, g + i, mul_g, add_g);
+            store16_sse(vb, b + i, mul_b, add_b);
+        }
+        planar_scalar(rgb, pixels - i, r + i, g + i, b + i, mul, add);
+    }
+
+    __attribute__((target("avx2,fma")))
+    static inline void store16_avx2(__m128i v, float *out, __m256 mul, __m256 add) {
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+        _mm256_storeu_ps(out, _mm256_fmadd_ps(lo, mul, add));
+        _mm256_storeu_ps(out + 8, _mm256_fmadd_ps(hi, mul, add));
+    }
+
+    __attribute__((target("avx2,fma")))
+    static void planar_avx2(const uint8_t *rgb, size_t pixels, float *r, float *g, float *b,
+                            const float *mul, const float *add) {
+        const __m256 mul_r = _mm256_set1_ps(mul[0]), mul_g = _mm256_set1_ps(mul[1]), mul_b = _mm256_set1_ps(mul[2]);
+        const __m256 add_r = _mm256_set1_ps(add[0]), add_g = _mm256_set1_ps(add[1]), add_b = _mm256_set1_ps(add[2]);
+        size_t i = 0;
+        for (; i + 16 <= pixels; i += 16, rgb += 48) {
+            __m128i vr, vg, vb;
+            deinterleave16(rgb, vr, vg, vb);
+            store16_avx2(vr, r + i, mul_r, add_r);
+            store16_avx2(vg, g + i, mul_g, add_g);
+            store16_avx2(vb, b + i, mul_b, add_b);
+        }
+        planar_scalar(rgb, pixels - i, r + i, g + i, b + i, mul, add);
+    }
+#endif
+
+#ifdef TENSOR_NEON
+    static inline void store16_neon(uint8x16_t v, float *out, float32x4_t mul, float32x4_t add) {
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_f32(out, vmlaq_f32(add, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), mul));
+        vst1q_f32(out + 4, vmlaq_f32(add, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), mul));
+        vst1q_f32(out + 8, vmlaq_f32(add, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), mul));
+        vst1q_f32(out + 12, vmlaq_f32(add, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), mul));
+    }
+
+    /* vld3 does the deinterleaving in the load */
+    static void planar_neon(const uint8_t *rgb, size_t pixels, float *r, float *g, float *b,
+                            const float *mul, const float *add) {
+        const float32x4_t mul_r = vdupq_n_f32(mul[0]), mul_g = vdupq_n_f32(mul[1]), mul_b = vdupq_n_f32(mul[2]);
+        const float32x4_t add_r = vdupq_n_f32(add[0]), add_g = vdupq_n_f32(add[1]), add_b = vdupq_n_f32(add[2]);
+        size_t i = 0;
+        for (; i + 16 <= pixels; i += 16, rgb += 48) {
+            uint8x16x3_t v = vld3q_u8(rgb);
+            store16_neon(v.val[0], r + i, mul_r, add_r);
+            store16_neon(v.val[1], g + i, mul_g, add_g);
+            store16_neon(v.val[2], b + i, mul_b, add_b);
+        }
+        planar_scalar(rgb, pixels - i, r + i, g + i, b + i, mul, add);
+    }
+#endif
+
+    typedef struct {
+        planar_kernel_t planar;
+        const char *name;
+    } kernel_t;
+
+    /* Best kernel the CPU runs, picked once at startup */
+    static kernel_t pick_kernel() {
+#ifdef TENSOR_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return {planar_avx2, "avx2"};
+        }
+        if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3")) {
+            return {planar_sse41, "sse4.1"};
+        }
+#elif defined(TENSOR_NEON)
+        return {planar_neon, "neon"};
+#endif
+        return {planar_scalar, "scalar"};
+    }
+
+    static const kernel_t kernel = pick_kernel();
+
+    const char *tensor_preprocessor::kernel_name() {
+        return kernel.name;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    tensor_preprocessor::tensor_preprocessor(uint32_t size, uint8_t pad)
+        : size_(size), pad_(pad), header_() {
+        for (int c = 0; c < 3; c++) {
+            mul_[c] = 1.0f / 255.0f;
+            add_[c] = 0.0f;
+        }
+        canvas_.resize(static_cast<size_t>(size_) * size_ * 3);
+    }
+
+    void tensor_preprocessor::set_normalization(const float mul[3], const float add[3]) {
+        std::copy(mul, mul + 3, mul_);
+        std::copy(add, add + 3, add_);
+    }
+
+    size_t tensor_preprocessor::tensor_bytes() const {
+        return sizeof(frame_protocol::tensor_header_t) + static_cast<size_t>(size_) * size_ * 3 * sizeof(float);
+    }
+
+    /* Scale to fit, center, and build the bilinear tables with OpenCV's pixel center convention */
+    void tensor_preprocessor::set_geometry(uint32_t width, uint32_t height) {
+        src_width_ = width;
+        src_height_ = height;
+
+        float scale = std::min(static_cast<float>(size_) / width, static_cast<float>(size_) / height);
+        uint32_t rw = std::min(size_, std::max(1u, static_cast<uint32_t>(std::lround(width * scale))));
+        uint32_t rh = std::min(size_, std::max(1u, static_cast<uint32_t>(std::lround(height * scale))));
+
+        header_ = {};
+        header_.magic = frame_protocol::tensor_magic;
+        header_.size = sizeof(frame_protocol::tensor_header_t);
+        header_.version = frame_protocol::tensor_version;
+        header_.width = size_;
+        header_.height = size_;
+        header_.channels = 3;
+        header_.dtype = frame_protocol::tensor_float32;
+        header_.src_width = width;
+        header_.src_height = height;
+        header_.scale = scale;
+        header_.pad_x = (size_ - rw) / 2;
+        header_.pad_y = (size_ - rh) / 2;
+        header_.resized_width = rw;
+        header_.resized_height = rh;
+
+        auto table = [](uint32_t dst, uint32_t src, std::vector<uint32_t> *index, std::vector<uint16_t> &weight) {
+            index[0].resize(dst);
+            index[1].resize(dst);
+            weight.resize(dst);
+            double ratio = static_cast<double>(src) / dst;
+            for (uint32_t i = 0; i < dst; i++) {
+                double pos = std::max(0.0, (i + 0.5) * ratio - 0.5);
+                uint32_t i0 = std::min(static_cast<uint32_t>(pos), src - 1);
+                index[0][i] = i0;
+                index[1][i] = std::min(i0 + 1, src - 1);
+                weight[i] = static_cast<uint16_t>(std::lround((pos - i0) * 256));
+                if (index[1][i] == i0) {
+                    weight[i] = 0;
+                }
+            }
+        };
+        table(rw, width, x_offset_, x_weight_);
+        table(rh, height, y_row_, y_weight_);
+        for (auto &offsets : x_offset_) {
+            for (auto &x : offsets) {
+                x *= 3;
+            }
+        }
+
+        // The border never changes for a frame size, only the inside is redrawn
+        std::fill(canvas_.begin(), canvas_.end(), pad_);
+        rows_[0].resize(static_cast<size_t>(rw) * 3);
+        rows_[1].resize(static_cast<size_t>(rw) * 3);
+        row_index_[0] = row_index_[1] = -1;
+    }
+
+    /* Bilinear, separable. Horizontally resized rows are kept while consecutive
+       output rows share them, which is most of them when upscaling */
+    void tensor_preprocessor::resize(const uint8_t *rgb, size_t stride) {
+        const uint32_t rw = header_.resized_width, rh = header_.resized_height;
+        const size_t canvas_stride = static_cast<size_t>(size_) * 3;
+        uint8_t *dst = canvas_.data() + header_.pad_y * canvas_stride + header_.pad_x * 3;
+
+        auto horizontal = [&](uint32_t src_row, std::vector<uint16_t> &out) {
+            const uint8_t *row = rgb + src_row * stride;
+            uint16_t *o = out.data();
+            for (uint32_t x = 0; x < rw; x++, o += 3) {
+                const uint8_t *p0 = row + x_offset_[0][x];
+                const uint8_t *p1 = row + x_offset_[1][x];
+                const uint32_t w1 = x_weight_[x], w0 = 256 - w1;
+                o[0] = static_cast<uint16_t>(p0[0] * w0 + p1[0] * w1);
+                o[1] = static_cast<uint16_t>(p0[1] * w0 + p1[1] * w1);
+                o[2] = static_cast<uint16_t>(p0[2] * w0 + p1[2] * w1);
+            }
+        };
+
+        for (uint32_t y = 0; y < rh; y++, dst += canvas_stride) {
+            const int64_t top = y_row_[0][y], bottom = y_row_[1][y];
+            if (row_index_[0] != top) {
+                if (row_index_[1] == top) {
+                    // Moving down, the previous bottom row is the new top
+                    std::swap(rows_[0], rows_[1]);
+                    std::swap(row_index_[0], row_index_[1]);
+                }
+                else {
+                    horizontal(static_cast<uint32_t>(top), rows_[0]);
+                    row_index_[0] = top;
+                }
+            }
+            if (row_index_[1] != bottom) {
+                horizontal(static_cast<uint32_t>(bottom), rows_[1]);
+                row_index_[1] = bottom;
+            }
+
+            // Plain loop over independent lanes, the compiler vectorizes it
+            const uint16_t *r0 = rows_[0].data(), *r1 = rows_[1].data();
+            const uint32_t w1 = y_weight_[y], w0 = 256 - w1;
+            for (size_t i = 0; i < static_cast<size_t>(rw) * 3; i++) {
+                dst[i] = static_cast<uint8_t>((r0[i] * w0 + r1[i] * w1 + (1u << 15)) >> 16);
+            }
+        }
+        // Rows may come from a different frame next time
+        row_index_[0] = row_index_[1] = -1;
+    }
+
+    void tensor_preprocessor::process(const uint8_t *rgb, uint32_t width, uint32_t height, size_t stride,
+                                      uint8_t *out) {
+        if (width != src_width_ || height != src_height_) {
+            set_geometry(width, height);
+        }
+        resize(rgb, stride);
+
+        std::memcpy(out, &header_, sizeof(header_));
+        float *planes = reinterpret_cast<float *>(out + sizeof(header_));
+        const size_t plane = static_cast<size_t>(size_) * size_;
+        kernel.planar(canvas_.data(), plane, planes, planes + plane, planes + 2 * plane, mul_, add_);
+    }
+
+};
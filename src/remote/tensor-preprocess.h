@@ -0,0 +1,83 @@
+/**
+ * @file    tensor-preprocess.h
+ * @brief   Letterbox resize and planar float conversion of decoded RGB frames
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Turns a packed RGB frame of any size into the input a YOLO style detector
+ * expects: scaled to fit a size x size square keeping the aspect ratio,
+ * centered on a grey border, split into R, G and B planes of float32 and
+ * normalized as value * mul[c] + add[c]. The result is laid out as
+ *
+ *   [frame_protocol::tensor_header_t][R plane][G plane][B plane]
+ *
+ * so it can be sent instead of a JPEG and used without further work.
+ */
+#ifndef __TENSOR_PREPROCESS_H
+#define __TENSOR_PREPROCESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <frame-protocol.h>
+
+namespace remote {
+
+    class tensor_preprocessor {
+    public:
+        /**
+         * @brief Default normalization maps 0..255 to 0..1, as YOLO wants
+         *
+         * @param size     Width and height of the tensor
+         * @param pad      Value of the letterbox border, before normalization
+         */
+        tensor_preprocessor(uint32_t size, uint8_t pad);
+
+        tensor_preprocessor(const tensor_preprocessor &) = delete;
+        tensor_preprocessor &operator=(const tensor_preprocessor &) = delete;
+
+        void set_normalization(const float mul[3], const float add[3]);
+
+        /** @brief Bytes process() writes, header included */
+        size_t tensor_bytes() const;
+
+        /**
+         * @brief Letterbox and convert one frame
+         *
+         * @param rgb    Packed RGB, 3 bytes per pixel
+         * @param stride Bytes from one row of rgb to the next
+         * @param out    tensor_bytes() bytes, 32 byte alignment makes the stores faster
+         */
+        void process(const uint8_t *rgb, uint32_t width, uint32_t height, size_t stride, uint8_t *out);
+
+        /** @brief The conversion kernel picked for this CPU, e.g. "avx2" */
+        static const char *kernel_name();
+
+    private:
+        void set_geometry(uint32_t width, uint32_t height);
+        void resize(const uint8_t *rgb, size_t stride);
+
+        uint32_t size_;
+        uint8_t pad_;
+        float mul_[3];
+        float add_[3];
+
+        // Letterbox of the last frame size, recomputed when it changes
+        uint32_t src_width_ = 0;
+        uint32_t src_height_ = 0;
+        frame_protocol::tensor_header_t header_;
+
+        // Resize tables, per destination column and row of the resized image
+        std::vector<uint32_t> x_offset_[2];   // Byte offsets of the two source pixels
+        std::vector<uint16_t> x_weight_;      // Weight of the second, out of 256
+        std::vector<uint32_t> y_row_[2];
+        std::vector<uint16_t> y_weight_;
+
+        std::vector<uint8_t> canvas_;         // Packed RGB size x size, border filled once
+        std::vector<uint16_t> rows_[2];       // Horizontally resized source rows
+        int64_t row_index_[2] = {-1, -1};
+    };
+
+};
+
+#endif // __TENSOR_PREPROCESS_H
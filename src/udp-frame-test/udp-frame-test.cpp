@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file    udp-frame-test.cpp
+ * @brief   Loopback check of the chunking, reassembly and XOR FEC of udp-frame
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * A udp_frame::sender sends frames to a socket of this process over
+ * loopback. The datagrams are read back and fed to a reassembler in order,
+ * shuffled, with one chunk missing (rebuilt from parity) and with two chunks
+ * of one parity group missing (dropped on timeout). Exits 0 when every case
+ * passes, so it runs under ctest.
+ */
+////////////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <udp-frame.h>
+
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_MTU              1500
+#define TEST_FRAME_SIZE       100000    //About 70 chunks, the last one short
+#define TEST_FEC_PERCENT      25
+#define TEST_TIMEOUT_MS       200
+#define TEST_MAX_FRAME        (1 << 20)
+#define RECV_WAIT_MS          500
+////////////////////////////////////////////////////////////////////////////////
+
+typedef std::vector<std::vector<uint8_t>> datagrams_t;
+
+static int failures = 0;
+
+static void check (bool ok, const std::string &what)
+{
+  std::cout << (ok ? "[PASS] " : "[FAIL] ") << what << std::endl;
+  if (!ok) {
+    failures++;
+  }
+}
+
+static std::vector<uint8_t> make_frame (size_t size, uint32_t seed)
+{
+  std::vector<uint8_t> frame(size);
+  std::mt19937 rng(seed);
+  for (auto &byte : frame) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  return frame;
+}
+
+/* Send one frame over loopback and return its datagrams in the order they came */
+static datagrams_t send_frame (uint32_t frame_id, const std::vector<uint8_t> &frame, unsigned fec_percent)
+{
+  datagrams_t datagrams;
+  int rx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  int tx = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  int rcvbuf = 8 << 20;
+  setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  if (rx < 0 || tx < 0 || bind(rx, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      getsockname(rx, reinterpret_cast<struct sockaddr *>(&addr), &addr_len) < 0) {
+    perror("socket");
+  }
+  else {
+    udp_frame::sender sender(tx, addr, TEST_MTU, false);
+    sender.set_fec(fec_percent);
+    std::vector<struct iovec> payload = {{const_cast<uint8_t *>(frame.data()), frame.size()}};
+    if (sender.send(frame_id, payload, frame.size())) {
+      std::vector<uint8_t> buffer(udp_frame::max_datagram);
+      struct pollfd pfd = {rx, POLLIN, 0};
+      while (datagrams.size() < sender.datagrams_sent() && poll(&pfd, 1, RECV_WAIT_MS) > 0) {
+        ssize_t n = recv(rx, buffer.data(), buffer.size(), 0);
+        if (n > 0) {
+          datagrams.emplace_back(buffer.begin(), buffer.begin() + n);
+        }
+      }
+    }
+  }
+  if (rx >= 0) {
+    close(rx);
+  }
+  if (tx >= 0) {
+    close(tx);
+  }
+  return datagrams;
+}
+
+static const udp_frame::chunk_header_t &header_of (const std::vector<uint8_t> &datagram)
+{
+  return *reinterpret_cast<const udp_frame::chunk_header_t *>(datagram.data());
+}
+
+/* Data chunk number index, or the datagram count if it isn't there */
+static size_t find_chunk (const datagrams_t &datagrams, uint16_t index)
+{
+  for (size_t i = 0; i < datagrams.size(); i++) {
+    const auto &h = header_of(datagrams[i]);
+    if (!(h.flags & udp_frame::flag_parity) && h.chunk_index == index) {
+      return i;
+    }
+  }
+  return datagrams.size();
+}
+
+/* Feed the datagrams at now_ms, then expire; true if exactly frame came out */
+static bool reassemble (udp_frame::reassembler &r, const datagrams_t &datagrams,
+                        const std::vector<uint8_t> &frame, uint32_t frame_id)
+{
+  bool completed = false, matches = false;
+  for (auto &datagram : datagrams) {
+    udp_frame::frame_t out;
+    if (r.push(datagram.data(), datagram.size(), 0, out)) {
+      matches = !completed && out.frame_id == frame_id && out.length == frame.size() &&
+                memcmp(out.data, frame.data(), frame.size()) == 0;
+      completed = true;
+    }
+  }
+  r.expire(TEST_TIMEOUT_MS + 1);
+  return completed && matches;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main ()
+{
+  std::vector<uint8_t> frame = make_frame(TEST_FRAME_SIZE, 1);
+
+  /* In order, no FEC */
+  {
+    datagrams_t datagrams = send_frame(1, frame, 0);
+    udp_frame::reassembler r(TEST_MAX_FRAME, TEST_TIMEOUT_MS, 4);
+    check(datagrams.size() > 1, "frame is cut into " + std::to_string(datagrams.size()) + " chunks");
+    bool fit = std::all_of(datagrams.begin(), datagrams.end(),
+        [](const std::vector<uint8_t> &d) { return d.size() <= TEST_MTU - udp_frame::ip_udp_overhead; });
+    check(fit, "every chunk fits the MTU");
+    check(reassemble(r, datagrams, frame, 1), "in order: frame rebuilt byte for byte");
+    check(r.frames_completed() == 1 && r.chunks_recovered() == 0, "in order: no recovery needed");
+  }
+
+  /* Reordered, no FEC */
+  {
+    datagrams_t datagrams = send_frame(2, frame, 0);
+    std::mt19937 rng(2);
+    std::shuffle(datagrams.begin(), datagrams.end(), rng);
+    udp_frame::reassembler r(TEST_MAX_FRAME, TEST_TIMEOUT_MS, 4);
+    check(reassemble(r, datagrams, frame, 2), "reordered: frame rebuilt byte for byte");
+  }
+
+  /* One lost data chunk, rebuilt from its parity group. The last chunk is the
+     short one, which tests the zero padding. Shuffled, parity may also rebuild
+     chunks that were only late, those then arrive as duplicates */
+  for (bool last : {false, true}) {
+    for (bool shuffled : {false, true}) {
+      datagrams_t datagrams = send_frame(3, frame, TEST_FEC_PERCENT);
+      uint16_t lost = last ? header_of(datagrams.front()).chunk_count - 1 : 1;
+      size_t at = find_chunk(datagrams, lost);
+      std::string name = std::string("one lost ") + (last ? "short last" : "full") + " chunk" +
+                         (shuffled ? ", reordered: " : ": ");
+      check(at < datagrams.size(), name + "chunk " + std::to_string(lost) + " sent");
+      if (at == datagrams.size()) {
+        continue;
+      }
+      datagrams.erase(datagrams.begin() + at);
+      if (shuffled) {
+        std::mt19937 rng(3);
+        std::shuffle(datagrams.begin(), datagrams.end(), rng);
+      }
+      udp_frame::reassembler r(TEST_MAX_FRAME, TEST_TIMEOUT_MS, 4);
+      check(reassemble(r, datagrams, frame, 3), name + "frame rebuilt byte for byte");
+      check(shuffled ? r.chunks_recovered() >= 1 : r.chunks_recovered() == 1,
+            name + "recovered " + std::to_string(r.chunks_recovered()) + " chunks");
+    }
+  }
+
+  /* Two lost chunks of one parity group, XOR can't repair that */
+  {
+    datagrams_t datagrams = send_frame(4, frame, TEST_FEC_PERCENT);
+    size_t groups = 0;
+    for (auto &datagram : datagrams) {
+      if (header_of(datagram).flags & udp_frame::flag_parity) {
+        groups = header_of(datagram).offset;
+      }
+    }
+    check(groups > 0, "two lost: parity groups sent");
+    for (uint16_t lost : {static_cast<uint16_t>(0), static_cast<uint16_t>(groups)}) {
+      size_t at = find_chunk(datagrams, lost);
+      if (at < datagrams.size()) {
+        datagrams.erase(datagrams.begin() + at);
+      }
+    }
+    udp_frame::reassembler r(TEST_MAX_FRAME, TEST_TIMEOUT_MS, 4);
+    check(!reassemble(r, datagrams, frame, 4), "two lost in one group: frame not handed out");
+    check(r.frames_timed_out() == 1 && r.frames_completed() == 0, "two lost in one group: dropped on timeout");
+  }
+
+  std::cout << (failures == 0 ? "All udp-frame checks passed" : std::to_string(failures) + " udp-frame checks failed")
+            << std::endl;
+  return failures == 0 ? 0 : 1;
+}
+////////////////////////////////////////////////////////////////////////////////
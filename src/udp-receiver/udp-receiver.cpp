@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * @file    udp-receiver.cpp
+ * @brief   Receives the chunked frames sent by gstreamer-remote-udp
+ * @version 0.1
+ * @date    2026-10-16
+ *
+ * Reassembles every frame from its chunks (common/udp-frame.h) and, like the
+ * Python socket client, optionally writes it to <frame number>.jpg. Chunks
+ * lost on the way are rebuilt from the parity chunks when the sender has FEC
+ * enabled, frames still incomplete after GST_UDP_RECEIVER_TIMEOUT ms are
+ * dropped.
+ */
+////////////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <utils.h>
+#include <udp-frame.h>
+
+////////////////////////////////////////////////////////////////////////////////
+#define RECEIVER_PORT         4008      //Default, override with argv[1] or GST_UDP_RECEIVER_PORT
+#define REASSEMBLY_TIMEOUT_MS 200       //Default, override with GST_UDP_RECEIVER_TIMEOUT
+#define REASSEMBLY_PENDING    16        //Frames being reassembled at the same time
+#define MAX_FRAME_SIZE        (64 << 20)
+#define RECV_BUFFER_SIZE      (8 << 20) //Default, override with GST_UDP_RECEIVER_RCVBUF
+#define RECV_BATCH            64        //Datagrams per recvmmsg()
+#define STATS_INTERVAL_MS     1000
+////////////////////////////////////////////////////////////////////////////////
+
+static uint64_t now_ms ()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+int main (int argc, char *argv[])
+{
+  unsigned long port = argc > 1 ? std::strtoul(argv[1], NULL, 10)
+                                : utils::get_env_ulong("GST_UDP_RECEIVER_PORT", RECEIVER_PORT);
+  if (port == 0 || port > utils::port_range_max) {
+    std::cout << "Not valid port. Exiting..." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  bool save = utils::get_env_ulong("GST_UDP_RECEIVER_SAVE", 0) != 0;
+
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (fd < 0) {
+    perror("socket");
+    exit(EXIT_FAILURE);
+  }
+
+  //A frame arrives as a burst of datagrams, give the kernel room for a few
+  int rcvbuf = utils::get_env_ulong("GST_UDP_RECEIVER_RCVBUF", RECV_BUFFER_SIZE);
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  socklen_t optlen = sizeof(rcvbuf);
+  getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &optlen);
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = INADDR_ANY;
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    perror("bind");
+    exit(EXIT_FAILURE);
+  }
+  std::cout << "Receiving frames on port: " << port << " (SO_RCVBUF " << rcvbuf << " bytes)" << std::endl;
+
+  udp_frame::reassembler frames(MAX_FRAME_SIZE,
+      utils::get_env_ulong("GST_UDP_RECEIVER_TIMEOUT", REASSEMBLY_TIMEOUT_MS), REASSEMBLY_PENDING);
+
+  //Datagrams are read in batches straight into fixed buffers
+  std::vector<uint8_t> storage(RECV_BATCH * udp_frame::max_datagram);
+  struct iovec iov[RECV_BATCH];
+  struct mmsghdr msgs[RECV_BATCH];
+  for (int i = 0; i < RECV_BATCH; i++) {
+    iov[i] = {storage.data() + i * udp_frame::max_datagram, udp_frame::max_datagram};
+    msgs[i] = {};
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  uint64_t bytes = 0, last_frames = 0, last_report = now_ms();
+  struct pollfd pfd = {fd, POLLIN, 0};
+  while (true) {
+    if (poll(&pfd, 1, STATS_INTERVAL_MS / 4) < 0 && errno != EINTR) {
+      perror("poll");
+      break;
+    }
+
+    int n = recvmmsg(fd, msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+    if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      perror("recvmmsg");
+      break;
+    }
+    uint64_t now = now_ms();
+    for (int i = 0; i < n; i++) {
+      udp_frame::frame_t frame;
+      if (!frames.push(static_cast<uint8_t *>(iov[i].iov_base), msgs[i].msg_len, now, frame)) {
+        continue;
+      }
+      bytes += frame.length;
+      if (save) {
+        std::ofstream out(std::to_string(frame.frame_id) + ".jpg", std::ios::binary);
+        out.write(reinterpret_cast<const char *>(frame.data), frame.length);
+      }
+    }
+    frames.expire(now);
+
+    if (now - last_report >= STATS_INTERVAL_MS) {
+      uint64_t completed = frames.frames_completed();
+      std::cout << "[Receiver] fps: " << (completed - last_frames) * 1000 / (now - last_report)
+                << " frames: " << completed << " timed out: " << frames.frames_timed_out()
+                << " recovered chunks: " << frames.chunks_recovered()
+                << " late chunks: " << frames.chunks_late() << " duplicate: " << frames.chunks_duplicate()
+                << " invalid: " << frames.chunks_invalid()
+                << " avg bytes: " << (completed ? bytes / completed : 0) << std::endl;
+      last_frames = completed;
+      last_report = now;
+    }
+  }
+
+  close(fd);
+  return 0;
+}
+////////////////////////////////////////////////////////////////////////////////